@@ -0,0 +1,93 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   adaptive.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: asplavni <asplavni@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by asplavni          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by asplavni         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include <time.h>
+
+double	get_time_ms(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0);
+}
+
+void	adaptive_init(t_adaptive *adaptive)
+{
+	adaptive->enabled = 1;
+	adaptive->moving = 0;
+	adaptive->step = ADAPTIVE_START_STEP;
+	adaptive->full_ms = 0.0;
+	adaptive->last_input = 0.0;
+}
+
+//Input that changes the 3D view: frames drawn from now on are moving
+//frames until ADAPTIVE_IDLE_MS pass without another call
+void	adaptive_input(t_adaptive *adaptive)
+{
+	if (!adaptive->enabled)
+		return ;
+	adaptive->moving = 1;
+	adaptive->last_input = get_time_ms();
+}
+
+//Sample spacing of the next frame, 0 if it should be a full one. Never
+//finer than the resolution factor of the full frames.
+int	adaptive_step(const t_fractal *fractal)
+{
+	if (!fractal->adaptive.enabled || !fractal->adaptive.moving)
+		return (0);
+	if (fractal->adaptive.step < fractal->resolution_factor)
+		return (fractal->resolution_factor);
+	return (fractal->adaptive.step);
+}
+
+//Moving frame of spacing `step` took `ms`: its cost times step * step is
+//an estimate of a full frame, smoothed over the frames before. The next
+//step is the smallest spacing, power of two or not, that fits the budget.
+void	adaptive_record(t_adaptive *adaptive, int step, double ms)
+{
+	double	full;
+	int		next;
+
+	if (step <= 0 || ms <= 0.0)
+		return ;
+	full = ms * step * step;
+	if (adaptive->full_ms > 0.0)
+		full = 0.5 * (adaptive->full_ms + full);
+	adaptive->full_ms = full;
+	next = (int)ceil(sqrt(full / ADAPTIVE_TARGET_MS));
+	if (next < 1)
+		next = 1;
+	if (next > ADAPTIVE_MAX_STEP)
+		next = ADAPTIVE_MAX_STEP;
+	adaptive->step = next;
+}
+
+//mlx loop hook: once the input has stopped, the last moving frame is
+//replaced by a full one. Sleeps a little otherwise so the event loop
+//doesn't spin.
+int	adaptive_loop_hook(t_fractal *fractal)
+{
+	if (!fractal->adaptive.moving
+		|| get_time_ms() - fractal->adaptive.last_input <= ADAPTIVE_IDLE_MS)
+	{
+		usleep(1000);
+		return (0);
+	}
+	fractal->adaptive.moving = 0;
+	if (!ft_strncmp(fractal->name, "menger", 6))
+		render_menger_sponge(fractal);
+	else if (!ft_strncmp(fractal->name, "mandelbrot3d", 12))
+		render_mandelbrot3d(fractal);
+	return (0);
+}
@@ -0,0 +1,413 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   benchmark.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: asplavni <asplavni@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by asplavni          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by asplavni         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include <string.h>
+
+//Headless benchmarks, run with: ./fractol bench <name> [args]
+//No window is opened, so these can run on render boxes without a display.
+
+typedef struct s_bench_view
+{
+	char	*name;
+	double	shift_x;
+	double	shift_y;
+	double	zoom;
+	double	julia_x;
+	double	julia_y;
+}	t_bench_view;
+
+static void	bench_fractal(t_fractal *fractal, const t_bench_view *view,
+				int iterations)
+{
+	memset(fractal, 0, sizeof(t_fractal));
+	fractal->name = view->name;
+	fractal->escape_value = 4;
+	fractal->iterations_defintion = iterations;
+	fractal->shift_x = view->shift_x;
+	fractal->shift_y = view->shift_y;
+	fractal->zoom = view->zoom;
+	fractal->julia_x = view->julia_x;
+	fractal->julia_y = view->julia_y;
+	fractal->deep.series = 1;
+	fractal->interior_checks = CHECK_BULBS | CHECK_PERIOD;
+}
+
+//One full frame of counts through `kernel`, best of `frames`; returns ms
+static double	escape_frame(t_fractal *fractal, t_escape_kernel kernel,
+					int *counts, int frames, long *total)
+{
+	double	t0, best;
+
+	best = 0.0;
+	for (int f = 0; f < frames; f++)
+	{
+		t0 = get_time_ms();
+		for (int y = 0; y < HEIGHT; y++)
+			escape_span(fractal, y, 0, WIDTH, counts + y * WIDTH, kernel);
+		t0 = get_time_ms() - t0;
+		if (f == 0 || t0 < best)
+			best = t0;
+	}
+	*total = 0;
+	for (int i = 0; i < WIDTH * HEIGHT; i++)
+		*total += counts[i];
+	return (best);
+}
+
+//Scalar vs SIMD escape-time kernels on one thread. Throughput is in
+//megapixel-iterations per second (iterations summed over the frame); the
+//last column counts pixels whose iteration count differs from scalar.
+static int	bench_escape(int iterations, int frames)
+{
+	static const t_bench_view	views[] = {
+		{"mandelbrot", 0.0, 0.0, 1.0, 0.0, 0.0},
+		{"mandelbrot", -0.7435, 0.1314, 0.01, 0.0, 0.0},
+		{"julia", 0.0, 0.0, 1.0, -0.8, 0.156},
+	};
+	t_escape_kernel				kernels[] = {ESCAPE_SCALAR, ESCAPE_DOUBLE,
+		ESCAPE_FLOAT};
+	t_fractal					fractal;
+	int							*reference, *counts;
+	double						ms, scalar_ms;
+	long						total;
+	int							diff;
+
+	reference = malloc(sizeof(int) * WIDTH * HEIGHT);
+	counts = malloc(sizeof(int) * WIDTH * HEIGHT);
+	if (!reference || !counts)
+		return (free(reference), free(counts), 1);
+	printf("Escape-time kernels: %dx%d, %d iterations, best of %d\n",
+		WIDTH, HEIGHT, iterations, frames);
+	for (size_t v = 0; v < sizeof(views) / sizeof(views[0]); v++)
+	{
+		bench_fractal(&fractal, &views[v], iterations);
+		printf("%s at (%g, %g), zoom %g\n", views[v].name, views[v].shift_x,
+			views[v].shift_y, views[v].zoom);
+		scalar_ms = escape_frame(&fractal, ESCAPE_SCALAR, reference, frames,
+				&total);
+		for (int k = 0; k < 3; k++)
+		{
+			ms = k ? escape_frame(&fractal, kernels[k], counts, frames, &total)
+				: scalar_ms;
+			diff = 0;
+			for (int i = 0; k && i < WIDTH * HEIGHT; i++)
+				diff += counts[i] != reference[i];
+			printf("  %-10s %9.1f ms %9.1f Mpix-it/s %6.2fx %8d differ\n",
+				escape_kernel_name(kernels[k]), ms, total / (ms * 1000.0),
+				scalar_ms / ms, diff);
+		}
+	}
+	free(reference);
+	free(counts);
+	return (0);
+}
+
+//Interior checks on the full Mandelbrot view, where the main cardioid
+//covers most of the black: frame time with every check off, then with
+//bulbs only and with bulbs and periodicity, for scalar and the SIMD kernel
+//escape_pick would use. Differences are counted against checks off.
+static int	bench_interior(int frames)
+{
+	static const t_bench_view	view = {"mandelbrot", 0.0, 0.0, 1.0, 0.0, 0.0};
+	static const int			limits[] = {100, 1000, 10000};
+	static const int			checks[] = {0, CHECK_BULBS,
+		CHECK_BULBS | CHECK_PERIOD};
+	static const char			*names[] = {"off", "bulbs", "bulbs+period"};
+	t_escape_kernel				kernels[2];
+	t_fractal					fractal;
+	int							*reference, *counts;
+	double						ms, off_ms;
+	long						total;
+	int							diff;
+
+	reference = malloc(sizeof(int) * WIDTH * HEIGHT);
+	counts = malloc(sizeof(int) * WIDTH * HEIGHT);
+	if (!reference || !counts)
+		return (free(reference), free(counts), 1);
+	bench_fractal(&fractal, &view, 100);
+	kernels[0] = ESCAPE_SCALAR;
+	kernels[1] = escape_pick(&fractal);
+	printf("Interior checks: mandelbrot %dx%d, best of %d\n", WIDTH, HEIGHT,
+		frames);
+	printf("%6s %-10s %-13s %10s %8s %8s\n", "iter", "kernel", "checks",
+		"frame", "speedup", "differ");
+	for (int l = 0; l < 3; l++)
+	{
+		for (int k = 0; k < 2; k++)
+		{
+			off_ms = 0.0;
+			for (int c = 0; c < 3; c++)
+			{
+				bench_fractal(&fractal, &view, limits[l]);
+				fractal.interior_checks = checks[c];
+				ms = escape_frame(&fractal, kernels[k], c ? counts : reference,
+						frames, &total);
+				if (!c)
+					off_ms = ms;
+				diff = 0;
+				for (int i = 0; c && i < WIDTH * HEIGHT; i++)
+					diff += counts[i] != reference[i];
+				printf("%6d %-10s %-13s %7.1f ms %7.2fx %8d\n", limits[l],
+					escape_kernel_name(kernels[k]), names[c], ms, off_ms / ms,
+					diff);
+			}
+		}
+	}
+	free(reference);
+	free(counts);
+	return (0);
+}
+
+//One frame into fractal->img through `render` on `threads` threads, best
+//of `frames`; returns ms
+static double	tile_frame(t_fractal *fractal, t_tile_fn render, int tile,
+					int threads, int frames)
+{
+	t_tile_job	job;
+	double		best;
+
+	best = 0.0;
+	for (int f = 0; f < frames; f++)
+	{
+		tile_job_init(&job, render, fractal, 1, 1);
+		job.tile_w = tile;
+		job.tile_h = tile;
+		job.threads = threads;
+		run_tile_job(&job);
+		if (f == 0 || job.wall_ms < best)
+			best = job.wall_ms;
+	}
+	return (best);
+}
+
+//Mariani-Silver tiles against the plain tile renderer behind the threaded
+//mode, both on the same threads, with the interior checks on and off.
+//Differences are counted in pixels of the final image.
+static int	bench_mariani(int iterations, int threads, int frames)
+{
+	static const t_bench_view	views[] = {
+		{"mandelbrot", 0.0, 0.0, 1.0, 0.0, 0.0},
+		{"mandelbrot", -0.7435, 0.1314, 0.01, 0.0, 0.0},
+		{"julia", 0.0, 0.0, 1.0, -0.8, 0.156},
+	};
+	t_fractal					fractal;
+	char						*plain, *pixels;
+	double						plain_ms, ms;
+	int							diff;
+
+	plain = malloc(WIDTH * HEIGHT * 4);
+	pixels = malloc(WIDTH * HEIGHT * 4);
+	if (!plain || !pixels)
+		return (free(plain), free(pixels), 1);
+	printf("Mariani-Silver: %dx%d, %d iterations, %d threads, best of %d\n",
+		WIDTH, HEIGHT, iterations, threads, frames);
+	for (size_t v = 0; v < sizeof(views) / sizeof(views[0]); v++)
+	{
+		bench_fractal(&fractal, &views[v], iterations);
+		printf("%s at (%g, %g), zoom %g, %s\n", views[v].name,
+			views[v].shift_x, views[v].shift_y, views[v].zoom,
+			escape_kernel_name(escape_pick(&fractal)));
+		for (int checks = 1; checks >= 0; checks--)
+		{
+			fractal.interior_checks = checks * (CHECK_BULBS | CHECK_PERIOD);
+			fractal.img = (t_img){NULL, plain, 32, 0, WIDTH * 4};
+			plain_ms = tile_frame(&fractal, render_fractal_tile, TILE_SIZE,
+					threads, frames);
+			fractal.img.pixels_ptr = pixels;
+			ms = tile_frame(&fractal, render_mariani_tile, MARIANI_TILE,
+					threads, frames);
+			diff = 0;
+			for (int i = 0; i < WIDTH * HEIGHT; i++)
+				diff += ((int *)plain)[i] != ((int *)pixels)[i];
+			printf("  checks %-3s tiles %8.1f ms, mariani %8.1f ms (%5.2fx), "
+				"%d pixels differ\n", checks ? "on" : "off", plain_ms, ms,
+				plain_ms / ms, diff);
+		}
+	}
+	free(plain);
+	free(pixels);
+	return (0);
+}
+
+//Escape count of pixel (x, y) with the whole orbit in t_mp, the ground
+//truth for the perturbation path (far too slow for a full frame)
+static int	mp_escape(t_fractal *fractal, int x, int y)
+{
+	t_mp	zx, zy, cx, cy, xx, yy, xy, d;
+	int		i;
+
+	mp_from_double(&d, (map(x, (t_bounds){-2, +2, 0, WIDTH})
+			* fractal->zoom) + fractal->shift_x);
+	mp_add(&zx, &fractal->deep.base_x, &d);
+	mp_from_double(&d, (map(y, (t_bounds){+2, -2, 0, HEIGHT})
+			* fractal->zoom) + fractal->shift_y);
+	mp_add(&zy, &fractal->deep.base_y, &d);
+	cx = zx;
+	cy = zy;
+	if (!ft_strncmp(fractal->name, "julia", 5))
+	{
+		mp_from_double(&cx, fractal->julia_x);
+		mp_from_double(&cy, fractal->julia_y);
+	}
+	i = 0;
+	while (i < fractal->iterations_defintion)
+	{
+		if (pow(mp_to_double(&zx), 2) + pow(mp_to_double(&zy), 2)
+			> fractal->escape_value)
+			break ;
+		mp_mul(&xx, &zx, &zx);
+		mp_mul(&yy, &zy, &zy);
+		mp_mul(&xy, &zx, &zy);
+		mp_sub(&zx, &xx, &yy);
+		mp_add(&zx, &zx, &cx);
+		mp_add(&zy, &xy, &xy);
+		mp_add(&zy, &zy, &cy);
+		i++;
+	}
+	return (i);
+}
+
+//Distinct escape counts in a frame: 1 means the view is flat
+static int	distinct_counts(const int *counts, int iterations)
+{
+	char	*seen;
+	int		distinct;
+
+	seen = calloc(iterations + 1, 1);
+	if (!seen)
+		return (0);
+	distinct = 0;
+	for (int i = 0; i < WIDTH * HEIGHT; i++)
+	{
+		distinct += !seen[counts[i]];
+		seen[counts[i]] = 1;
+	}
+	free(seen);
+	return (distinct);
+}
+
+//Samples of a frame whose count differs from a full t_mp iteration
+static int	mp_check(t_fractal *fractal, const int *counts, int samples)
+{
+	int	diff;
+	int	x;
+	int	y;
+
+	diff = 0;
+	for (int sy = 0; sy < samples; sy++)
+	{
+		for (int sx = 0; sx < samples; sx++)
+		{
+			x = (sx * WIDTH + WIDTH / 2) / samples;
+			y = (sy * HEIGHT + HEIGHT / 2) / samples;
+			diff += mp_escape(fractal, x, y) != counts[y * WIDTH + x];
+		}
+	}
+	return (diff);
+}
+
+//Deep zoom at 10^-exponent on points that keep structure at any scale:
+//the Misiurewicz point c = i, and -1 + i on the dendrite Julia set of
+//c = i. The plain double kernel is shown for comparison, then plain
+//perturbation and perturbation with series approximation; a grid of
+//samples is checked against a full t_mp iteration.
+static int	bench_deep(int iterations, int exponent, int samples)
+{
+	static const t_bench_view	views[] = {
+		{"mandelbrot", 0.0, 1.0, 1.0, 0.0, 0.0},
+		{"julia", -1.0, 1.0, 1.0, 0.0, 1.0},
+	};
+	t_fractal					fractal;
+	int							*counts[2];
+	double						t0, t_orbit, t_frame, t_plain;
+	long						total;
+	int							diff;
+
+	counts[0] = malloc(sizeof(int) * WIDTH * HEIGHT);
+	counts[1] = malloc(sizeof(int) * WIDTH * HEIGHT);
+	if (!counts[0] || !counts[1])
+		return (free(counts[0]), free(counts[1]), 1);
+	printf("Deep zoom: %dx%d, zoom 1e-%d, %d iterations\n", WIDTH, HEIGHT,
+		exponent, iterations);
+	for (size_t v = 0; v < sizeof(views) / sizeof(views[0]); v++)
+	{
+		printf("%s at (%g, %g)\n", views[v].name, views[v].shift_x,
+			views[v].shift_y);
+		bench_fractal(&fractal, &views[v], iterations);
+		fractal.zoom = pow(10.0, -exponent);
+		escape_frame(&fractal, ESCAPE_DOUBLE, counts[0], 1, &total);
+		printf("  double kernel: %d distinct counts\n",
+			distinct_counts(counts[0], iterations));
+		t_plain = 0.0;
+		for (int series = 0; series <= 1; series++)
+		{
+			bench_fractal(&fractal, &views[v], iterations);
+			fractal.zoom = pow(10.0, -exponent);
+			fractal.deep.series = series;
+			t0 = get_time_ms();
+			deep_prepare(&fractal);
+			t_orbit = get_time_ms() - t0;
+			t_frame = escape_frame(&fractal, escape_pick(&fractal),
+					counts[series], 1, &total);
+			if (!series)
+				t_plain = t_frame;
+			printf("  %-13s %2d distinct, setup %5.1f ms, frame %7.1f ms "
+				"(%5.2fx), %6.1f Mpix-it/s, %4d skipped\n",
+				series ? "+ series" : "perturbation",
+				distinct_counts(counts[series], iterations), t_orbit, t_frame,
+				t_plain / t_frame, total / (t_frame * 1000.0),
+				fractal.deep.skipped);
+			diff = 0;
+			for (int i = 0; series && i < WIDTH * HEIGHT; i++)
+				diff += counts[0][i] != counts[1][i];
+			printf("  %15s %d of %d samples differ from full precision, "
+				"%d pixels from plain perturbation\n", "",
+				mp_check(&fractal, counts[series], samples), samples * samples,
+				diff);
+			deep_free(&fractal.deep);
+		}
+	}
+	free(counts[0]);
+	free(counts[1]);
+	return (0);
+}
+
+static int	bench_arg(int ac, char **av, int index, int fallback)
+{
+	if (ac > index && atoi(av[index]) > 0)
+		return (atoi(av[index]));
+	return (fallback);
+}
+
+int	run_benchmarks(int ac, char **av)
+{
+	if (ac >= 3 && !ft_strncmp(av[2], "escape", 7))
+		return (bench_escape(bench_arg(ac, av, 3, 256),
+				bench_arg(ac, av, 4, 3)));
+	if (ac >= 3 && !ft_strncmp(av[2], "deep", 5))
+		return (bench_deep(bench_arg(ac, av, 3, 1000), bench_arg(ac, av, 4, 100),
+				bench_arg(ac, av, 5, 16)));
+	if (ac >= 3 && !ft_strncmp(av[2], "mariani", 8))
+		return (bench_mariani(bench_arg(ac, av, 3, 256),
+				bench_arg(ac, av, 4, render_thread_count()),
+				bench_arg(ac, av, 5, 3)));
+	if (ac >= 3 && !ft_strncmp(av[2], "interior", 9))
+		return (bench_interior(bench_arg(ac, av, 3, 1)));
+	write_string_to_file_descriptor("Usage: ./fractol bench <name> [args]\n"
+		"  escape [iterations=256] [frames=3]\n"
+		"  deep [iterations=1000] [zoom_exponent=100] [samples=16]\n"
+		"  interior [frames=1]\n"
+		"  mariani [iterations=256] [threads=cores] [frames=3]\n",
+		STDERR_FILENO);
+	return (1);
+}
@@ -0,0 +1,263 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   deep_zoom.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: asplavni <asplavni@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by asplavni          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by asplavni         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include <string.h>
+
+//Perturbation deep zoom for the 2D fractals. Past DEEP_ZOOM_START one
+//reference orbit is iterated in t_mp at the view centre and every pixel
+//only iterates its double offset d from it:
+//    d' = 2 Z d + d^2 + dc    (dc = 0 for Julia)
+//Where the pixel gets closer to 0 than d is large (the precision of d
+//would be lost in a glitch) or runs past the end of the reference, it is
+//rebased: d takes the full value and the pixel continues on an orbit that
+//starts at 0 (the reference itself for Mandelbrot, the critical orbit of
+//the Julia constant otherwise).
+//On top of that, series_prepare lets every pixel skip the iterations that
+//a polynomial in its offset predicts accurately enough.
+
+static void	orbit_reserve(t_orbit *orbit, int len)
+{
+	double	*data;
+
+	if (orbit->cap >= len)
+		return ;
+	data = realloc(orbit->x, sizeof(double) * 2 * len);
+	if (!data)
+	{
+		perror("Malloc malfunction");
+		exit(EXIT_FAILURE);
+	}
+	orbit->x = data;
+	orbit->y = data + len;
+	orbit->cap = len;
+}
+
+//z_0 = (zx, zy), z_{m+1} = z_m^2 + (cx, cy) in t_mp, stored as doubles
+//until it escapes (the escaping value included) or `len` values exist
+static void	orbit_compute(t_orbit *orbit, t_mp zx, t_mp zy, const t_mp *cx,
+				const t_mp *cy, int len, double escape)
+{
+	t_mp	xx, yy, xy;
+	double	x, y;
+
+	orbit_reserve(orbit, len);
+	orbit->len = 0;
+	while (orbit->len < len)
+	{
+		x = mp_to_double(&zx);
+		y = mp_to_double(&zy);
+		orbit->x[orbit->len] = x;
+		orbit->y[orbit->len++] = y;
+		if (x * x + y * y > escape)
+			break ;
+		mp_mul(&xx, &zx, &zx);
+		mp_mul(&yy, &zy, &zy);
+		mp_mul(&xy, &zx, &zy);
+		mp_sub(&zx, &xx, &yy);
+		mp_add(&zx, &zx, cx);
+		mp_add(&zy, &xy, &xy);
+		mp_add(&zy, &zy, cy);
+	}
+}
+
+//Moves shift into base (or back out once the view is shallow again)
+static void	deep_fold(t_fractal *fractal)
+{
+	t_deep	*deep;
+	t_mp	shift;
+
+	deep = &fractal->deep;
+	if (fractal->zoom >= DEEP_ZOOM_START)
+	{
+		fractal->shift_x += mp_to_double(&deep->base_x);
+		fractal->shift_y += mp_to_double(&deep->base_y);
+		memset(&deep->base_x, 0, sizeof(t_mp));
+		memset(&deep->base_y, 0, sizeof(t_mp));
+		return ;
+	}
+	mp_from_double(&shift, fractal->shift_x);
+	mp_add(&deep->base_x, &deep->base_x, &shift);
+	mp_from_double(&shift, fractal->shift_y);
+	mp_add(&deep->base_y, &deep->base_y, &shift);
+	fractal->shift_x = 0.0;
+	fractal->shift_y = 0.0;
+}
+
+static t_complex	cmul(t_complex a, t_complex b)
+{
+	return ((t_complex){a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x});
+}
+
+//Series approximation. Near the reference every pixel offset follows
+//    d_n = sum of a_k u^(k+1),  u = offset / sa_radius, |u| <= 1
+//where a_k (scaled by sa_radius^(k+1) so they stay in range at any zoom)
+//step alongside the orbit:
+//    a_k' = 2 Z a_k + sum of a_i a_j over i + j = k - 1  (+ sa_radius, k = 0,
+//    Mandelbrot only)
+//Stepping stops before the last term grows to SA_TOLERANCE of a pixel, or
+//before any pixel of the frame could escape or need a rebase.
+static void	series_prepare(t_fractal *fractal, int julia)
+{
+	t_deep		*deep;
+	t_complex	a[SA_TERMS], next[SA_TERMS], z;
+	double		bound, pixel;
+	int			n;
+
+	deep = &fractal->deep;
+	deep->sa_radius = 2.0 * sqrt(2.0) * fractal->zoom;
+	pixel = 4.0 * fractal->zoom / WIDTH / deep->sa_radius;
+	memset(a, 0, sizeof(a));
+	a[0].x = deep->sa_radius;
+	n = !julia;
+	while (deep->series && n + 1 < deep->ref.len
+		&& n + 1 - !julia < fractal->iterations_defintion)
+	{
+		z = (t_complex){deep->ref.x[n], deep->ref.y[n]};
+		bound = 0.0;
+		for (int k = 0; k < SA_TERMS; k++)
+			bound += hypot(a[k].x, a[k].y);
+		if (hypot(z.x, z.y) + bound > sqrt(fractal->escape_value)
+			|| hypot(z.x, z.y) < 2.0 * bound)
+			break ;
+		for (int k = 0; k < SA_TERMS; k++)
+		{
+			next[k] = cmul((t_complex){2.0 * z.x, 2.0 * z.y}, a[k]);
+			for (int i = 0; i < k; i++)
+				next[k] = sum_complex(next[k], cmul(a[i], a[k - 1 - i]));
+		}
+		if (!julia)
+			next[0].x += deep->sa_radius;
+		if (hypot(next[SA_TERMS - 1].x, next[SA_TERMS - 1].y)
+			> SA_TOLERANCE * pixel * hypot(next[0].x, next[0].y))
+			break ;
+		memcpy(a, next, sizeof(a));
+		n++;
+	}
+	memcpy(deep->sa, a, sizeof(a));
+	deep->sa_start = n;
+	deep->skipped = n - !julia;
+}
+
+//Once per frame, before any pixel of a 2D fractal: decides whether the
+//frame needs perturbation and (re)computes the orbits if the view changed
+void	deep_prepare(t_fractal *fractal)
+{
+	t_deep	*deep;
+	t_mp	zero, jx, jy;
+	int		moved;
+	int		len;
+
+	deep = &fractal->deep;
+	if (fractal->is_3d || (fractal->zoom >= DEEP_ZOOM_START && !deep->active))
+		return ;
+	if (fractal->zoom < DEEP_ZOOM_MIN)
+		fractal->zoom = DEEP_ZOOM_MIN;
+	moved = fractal->shift_x != 0.0 || fractal->shift_y != 0.0;
+	deep_fold(fractal);
+	deep->active = fractal->zoom < DEEP_ZOOM_START;
+	if (!deep->active || (!moved && deep->ref.len
+			&& deep->zoom == fractal->zoom
+			&& deep->iterations == fractal->iterations_defintion
+			&& deep->julia_x == fractal->julia_x
+			&& deep->julia_y == fractal->julia_y))
+		return ;
+	len = fractal->iterations_defintion + 2;
+	memset(&zero, 0, sizeof(t_mp));
+	if (!ft_strncmp(fractal->name, "julia", 5))
+	{
+		mp_from_double(&jx, fractal->julia_x);
+		mp_from_double(&jy, fractal->julia_y);
+		orbit_compute(&deep->ref, deep->base_x, deep->base_y, &jx, &jy, len,
+			fractal->escape_value);
+		orbit_compute(&deep->crit, zero, zero, &jx, &jy, len,
+			fractal->escape_value);
+	}
+	else
+		orbit_compute(&deep->ref, zero, zero, &deep->base_x, &deep->base_y,
+			len, fractal->escape_value);
+	series_prepare(fractal, !ft_strncmp(fractal->name, "julia", 5));
+	deep->zoom = fractal->zoom;
+	deep->iterations = fractal->iterations_defintion;
+	deep->julia_x = fractal->julia_x;
+	deep->julia_y = fractal->julia_y;
+}
+
+//Iterations before pixel (x, y) escapes, counted like escape_pixel
+int	deep_escape(int x, int y, t_fractal *fractal)
+{
+	const t_orbit	*orbit;
+	double			dx, dy, dcx, dcy, zx, zy, t;
+	t_complex		u, d;
+	int				julia;
+	int				m;
+	int				i;
+
+	dx = (map(x, (t_bounds){-2, +2, 0, WIDTH}) * fractal->zoom)
+		+ fractal->shift_x;
+	dy = (map(y, (t_bounds){+2, -2, 0, HEIGHT}) * fractal->zoom)
+		+ fractal->shift_y;
+	orbit = &fractal->deep.ref;
+	julia = !ft_strncmp(fractal->name, "julia", 5);
+	m = 0;
+	dcx = 0.0;
+	dcy = 0.0;
+	if (!julia)
+	{
+		dcx = dx;
+		dcy = dy;
+		m = 1;
+	}
+	i = 0;
+	if (fractal->deep.skipped)
+	{
+		u = (t_complex){dx / fractal->deep.sa_radius,
+			dy / fractal->deep.sa_radius};
+		d = fractal->deep.sa[SA_TERMS - 1];
+		for (int k = SA_TERMS - 2; k >= 0; k--)
+			d = sum_complex(cmul(d, u), fractal->deep.sa[k]);
+		d = cmul(d, u);
+		dx = d.x;
+		dy = d.y;
+		m = fractal->deep.sa_start;
+		i = fractal->deep.skipped;
+	}
+	while (i < fractal->iterations_defintion)
+	{
+		zx = orbit->x[m] + dx;
+		zy = orbit->y[m] + dy;
+		if (zx * zx + zy * zy > fractal->escape_value)
+			break ;
+		if (m == orbit->len - 1 || zx * zx + zy * zy < dx * dx + dy * dy)
+		{
+			if (julia)
+				orbit = &fractal->deep.crit;
+			dx = zx;
+			dy = zy;
+			m = 0;
+		}
+		t = 2.0 * (orbit->x[m] * dx - orbit->y[m] * dy) + dx * dx - dy * dy
+			+ dcx;
+		dy = 2.0 * (orbit->x[m] * dy + orbit->y[m] * dx + dx * dy) + dcy;
+		dx = t;
+		m++;
+		i++;
+	}
+	return (i);
+}
+
+void	deep_free(t_deep *deep)
+{
+	free(deep->ref.x);
+	free(deep->crit.x);
+	memset(deep, 0, sizeof(t_deep));
+}
@@ -0,0 +1,365 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   escape_simd.c                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: asplavni <asplavni@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by asplavni          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by asplavni         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+
+#define ESCAPE_MAX_LANES 8
+#define ESCAPE_MAX_POINTS (WIDTH > HEIGHT ? WIDTH : HEIGHT)
+
+//Lane types: AVX2 takes 4 doubles or 8 floats per register, SSE2 (the
+//x86_64 baseline) 2 or 4
+#if HAS_AVX2
+# define ESCAPE_LANES_D 4
+# define ESCAPE_LANES_F 8
+
+typedef __m256d	t_vd;
+typedef __m256	t_vf;
+
+static inline t_vd	vd_set1(double v) { return (_mm256_set1_pd(v)); }
+static inline t_vd	vd_load(const double *p) { return (_mm256_loadu_pd(p)); }
+static inline void	vd_store(double *p, t_vd v) { _mm256_storeu_pd(p, v); }
+static inline t_vd	vd_add(t_vd a, t_vd b) { return (_mm256_add_pd(a, b)); }
+static inline t_vd	vd_sub(t_vd a, t_vd b) { return (_mm256_sub_pd(a, b)); }
+static inline t_vd	vd_mul(t_vd a, t_vd b) { return (_mm256_mul_pd(a, b)); }
+static inline t_vd	vd_and(t_vd a, t_vd b) { return (_mm256_and_pd(a, b)); }
+static inline t_vd	vd_or(t_vd a, t_vd b) { return (_mm256_or_pd(a, b)); }
+static inline t_vd	vd_andnot(t_vd a, t_vd b)
+{
+	return (_mm256_andnot_pd(a, b));
+}
+static inline t_vd	vd_le(t_vd a, t_vd b)
+{
+	return (_mm256_cmp_pd(a, b, _CMP_LE_OQ));
+}
+static inline int	vd_any(t_vd m) { return (_mm256_movemask_pd(m)); }
+
+static inline t_vf	vf_set1(float v) { return (_mm256_set1_ps(v)); }
+static inline t_vf	vf_load(const float *p) { return (_mm256_loadu_ps(p)); }
+static inline void	vf_store(float *p, t_vf v) { _mm256_storeu_ps(p, v); }
+static inline t_vf	vf_add(t_vf a, t_vf b) { return (_mm256_add_ps(a, b)); }
+static inline t_vf	vf_sub(t_vf a, t_vf b) { return (_mm256_sub_ps(a, b)); }
+static inline t_vf	vf_mul(t_vf a, t_vf b) { return (_mm256_mul_ps(a, b)); }
+static inline t_vf	vf_and(t_vf a, t_vf b) { return (_mm256_and_ps(a, b)); }
+static inline t_vf	vf_or(t_vf a, t_vf b) { return (_mm256_or_ps(a, b)); }
+static inline t_vf	vf_andnot(t_vf a, t_vf b)
+{
+	return (_mm256_andnot_ps(a, b));
+}
+static inline t_vf	vf_le(t_vf a, t_vf b)
+{
+	return (_mm256_cmp_ps(a, b, _CMP_LE_OQ));
+}
+static inline int	vf_any(t_vf m) { return (_mm256_movemask_ps(m)); }
+#elif HAS_SSE
+# define ESCAPE_LANES_D 2
+# define ESCAPE_LANES_F 4
+
+typedef __m128d	t_vd;
+typedef __m128	t_vf;
+
+static inline t_vd	vd_set1(double v) { return (_mm_set1_pd(v)); }
+static inline t_vd	vd_load(const double *p) { return (_mm_loadu_pd(p)); }
+static inline void	vd_store(double *p, t_vd v) { _mm_storeu_pd(p, v); }
+static inline t_vd	vd_add(t_vd a, t_vd b) { return (_mm_add_pd(a, b)); }
+static inline t_vd	vd_sub(t_vd a, t_vd b) { return (_mm_sub_pd(a, b)); }
+static inline t_vd	vd_mul(t_vd a, t_vd b) { return (_mm_mul_pd(a, b)); }
+static inline t_vd	vd_and(t_vd a, t_vd b) { return (_mm_and_pd(a, b)); }
+static inline t_vd	vd_or(t_vd a, t_vd b) { return (_mm_or_pd(a, b)); }
+static inline t_vd	vd_andnot(t_vd a, t_vd b) { return (_mm_andnot_pd(a, b)); }
+static inline t_vd	vd_le(t_vd a, t_vd b) { return (_mm_cmple_pd(a, b)); }
+static inline int	vd_any(t_vd m) { return (_mm_movemask_pd(m)); }
+
+static inline t_vf	vf_set1(float v) { return (_mm_set1_ps(v)); }
+static inline t_vf	vf_load(const float *p) { return (_mm_loadu_ps(p)); }
+static inline void	vf_store(float *p, t_vf v) { _mm_storeu_ps(p, v); }
+static inline t_vf	vf_add(t_vf a, t_vf b) { return (_mm_add_ps(a, b)); }
+static inline t_vf	vf_sub(t_vf a, t_vf b) { return (_mm_sub_ps(a, b)); }
+static inline t_vf	vf_mul(t_vf a, t_vf b) { return (_mm_mul_ps(a, b)); }
+static inline t_vf	vf_and(t_vf a, t_vf b) { return (_mm_and_ps(a, b)); }
+static inline t_vf	vf_or(t_vf a, t_vf b) { return (_mm_or_ps(a, b)); }
+static inline t_vf	vf_andnot(t_vf a, t_vf b) { return (_mm_andnot_ps(a, b)); }
+static inline t_vf	vf_le(t_vf a, t_vf b) { return (_mm_cmple_ps(a, b)); }
+static inline int	vf_any(t_vf m) { return (_mm_movemask_ps(m)); }
+#endif
+
+//Float only while a pixel is still many float ulps wide and the counts fit
+//in the float mantissa; deeper views keep double, and past DEEP_ZOOM_START
+//(deep_prepare turned it on) only perturbation can resolve the pixels
+t_escape_kernel	escape_pick(t_fractal *fractal)
+{
+	if (fractal->deep.active)
+		return (ESCAPE_PERTURB);
+#if HAS_SSE
+	if (fractal->zoom >= ESCAPE_FLOAT_ZOOM
+		&& fractal->iterations_defintion < (1 << 24))
+		return (ESCAPE_FLOAT);
+	return (ESCAPE_DOUBLE);
+#else
+	(void)fractal;
+	return (ESCAPE_SCALAR);
+#endif
+}
+
+const char	*escape_kernel_name(t_escape_kernel kernel)
+{
+	if (kernel == ESCAPE_PERTURB)
+		return ("perturbation");
+	if (kernel == ESCAPE_FLOAT)
+		return (HAS_AVX2 ? "float x8" : "float x4");
+	if (kernel == ESCAPE_DOUBLE)
+		return (HAS_AVX2 ? "double x4" : "double x2");
+	return ("scalar");
+}
+
+#if HAS_SSE
+static inline t_vd	vd_abs(t_vd v) { return (vd_andnot(vd_set1(-0.0), v)); }
+static inline t_vf	vf_abs(t_vf v) { return (vf_andnot(vf_set1(-0.0f), v)); }
+
+//in_main_bulbs on every lane, all bits set where c is interior
+static t_vd	vd_bulbs(t_vd x, t_vd y)
+{
+	t_vd	xq, y_sq, q, x1;
+
+	xq = vd_sub(x, vd_set1(0.25));
+	y_sq = vd_mul(y, y);
+	q = vd_add(vd_mul(xq, xq), y_sq);
+	x1 = vd_add(x, vd_set1(1.0));
+	return (vd_or(vd_le(vd_mul(q, vd_add(q, xq)), vd_mul(vd_set1(0.25), y_sq)),
+			vd_le(vd_add(vd_mul(x1, x1), y_sq), vd_set1(0.0625))));
+}
+
+static t_vf	vf_bulbs(t_vf x, t_vf y)
+{
+	t_vf	xq, y_sq, q, x1;
+
+	xq = vf_sub(x, vf_set1(0.25f));
+	y_sq = vf_mul(y, y);
+	q = vf_add(vf_mul(xq, xq), y_sq);
+	x1 = vf_add(x, vf_set1(1.0f));
+	return (vf_or(vf_le(vf_mul(q, vf_add(q, xq)), vf_mul(vf_set1(0.25f), y_sq)),
+			vf_le(vf_add(vf_mul(x1, x1), y_sq), vf_set1(0.0625f))));
+}
+
+//Same iteration as handle_fractal_iteration, one lane per pixel. A lane
+//stays out once it escapes (its z keeps running but is masked) and the
+//loop ends as soon as every lane is out. Interior lanes (bulb test, or a
+//cycle found by the lockstep Brent check) drop out the same way and get
+//the full count at the end.
+static void	escape_lanes_d(const double *cx, const double *cy, double jx,
+				double jy, int julia, t_fractal *fractal, int *counts)
+{
+	t_vd	zx, zy, zx_sq, zy_sq, c_x, c_y, active, count;
+	t_vd	one, escape, inside, saved_x, saved_y, periodic;
+	double	out[ESCAPE_LANES_D];
+	int		limit;
+	int		i;
+
+	zx = vd_load(cx);
+	zy = vd_load(cy);
+	c_x = julia ? vd_set1(jx) : zx;
+	c_y = julia ? vd_set1(jy) : zy;
+	one = vd_set1(1.0);
+	escape = vd_set1(fractal->escape_value);
+	count = vd_set1(0.0);
+	active = vd_le(count, one);
+	inside = vd_le(one, count);
+	if ((fractal->interior_checks & CHECK_BULBS) && !julia)
+		inside = vd_bulbs(zx, zy);
+	active = vd_andnot(inside, active);
+	saved_x = zx;
+	saved_y = zy;
+	limit = 1;
+	i = 0;
+	while (i++ < fractal->iterations_defintion)
+	{
+		zx_sq = vd_mul(zx, zx);
+		zy_sq = vd_mul(zy, zy);
+		active = vd_and(active, vd_le(vd_add(zx_sq, zy_sq), escape));
+		if (!vd_any(active))
+			break ;
+		count = vd_add(count, vd_and(active, one));
+		zy = vd_mul(zx, zy);
+		zy = vd_add(vd_add(zy, zy), c_y);
+		zx = vd_add(vd_sub(zx_sq, zy_sq), c_x);
+		if (!(fractal->interior_checks & CHECK_PERIOD))
+			continue ;
+		periodic = vd_and(active, vd_le(vd_add(vd_abs(vd_sub(zx, saved_x)),
+						vd_abs(vd_sub(zy, saved_y))), vd_set1(PERIOD_EPS)));
+		inside = vd_or(inside, periodic);
+		active = vd_andnot(periodic, active);
+		if (i == limit)
+		{
+			saved_x = zx;
+			saved_y = zy;
+			limit *= 2;
+		}
+	}
+	count = vd_or(vd_and(inside, vd_set1(fractal->iterations_defintion)),
+			vd_andnot(inside, count));
+	vd_store(out, count);
+	for (int k = 0; k < ESCAPE_LANES_D; k++)
+		counts[k] = (int)out[k];
+}
+
+static void	escape_lanes_f(const float *cx, const float *cy, float jx,
+				float jy, int julia, t_fractal *fractal, int *counts)
+{
+	t_vf	zx, zy, zx_sq, zy_sq, c_x, c_y, active, count;
+	t_vf	one, escape, inside, saved_x, saved_y, periodic;
+	float	out[ESCAPE_LANES_F];
+	int		limit;
+	int		i;
+
+	zx = vf_load(cx);
+	zy = vf_load(cy);
+	c_x = julia ? vf_set1(jx) : zx;
+	c_y = julia ? vf_set1(jy) : zy;
+	one = vf_set1(1.0f);
+	escape = vf_set1((float)fractal->escape_value);
+	count = vf_set1(0.0f);
+	active = vf_le(count, one);
+	inside = vf_le(one, count);
+	if ((fractal->interior_checks & CHECK_BULBS) && !julia)
+		inside = vf_bulbs(zx, zy);
+	active = vf_andnot(inside, active);
+	saved_x = zx;
+	saved_y = zy;
+	limit = 1;
+	i = 0;
+	while (i++ < fractal->iterations_defintion)
+	{
+		zx_sq = vf_mul(zx, zx);
+		zy_sq = vf_mul(zy, zy);
+		active = vf_and(active, vf_le(vf_add(zx_sq, zy_sq), escape));
+		if (!vf_any(active))
+			break ;
+		count = vf_add(count, vf_and(active, one));
+		zy = vf_mul(zx, zy);
+		zy = vf_add(vf_add(zy, zy), c_y);
+		zx = vf_add(vf_sub(zx_sq, zy_sq), c_x);
+		if (!(fractal->interior_checks & CHECK_PERIOD))
+			continue ;
+		periodic = vf_and(active, vf_le(vf_add(vf_abs(vf_sub(zx, saved_x)),
+						vf_abs(vf_sub(zy, saved_y))), vf_set1(PERIOD_EPS_F)));
+		inside = vf_or(inside, periodic);
+		active = vf_andnot(periodic, active);
+		if (i == limit)
+		{
+			saved_x = zx;
+			saved_y = zy;
+			limit *= 2;
+		}
+	}
+	count = vf_or(vf_and(inside, vf_set1(fractal->iterations_defintion)),
+			vf_andnot(inside, count));
+	vf_store(out, count);
+	for (int k = 0; k < ESCAPE_LANES_F; k++)
+		counts[k] = (int)out[k];
+}
+#endif
+
+static double	pixel_x(t_fractal *fractal, int x)
+{
+	return ((map(x, (t_bounds){-2, +2, 0, WIDTH}) * fractal->zoom)
+		+ fractal->shift_x);
+}
+
+static double	pixel_y(t_fractal *fractal, int y)
+{
+	return ((map(y, (t_bounds){+2, -2, 0, HEIGHT}) * fractal->zoom)
+		+ fractal->shift_y);
+}
+
+#if HAS_SSE
+//n points at (cx[k], cy[k]) through a SIMD kernel; both arrays are padded
+//by a full register past n
+static void	escape_points(t_fractal *fractal, const double *cx,
+				const double *cy, int n, int *counts, t_escape_kernel kernel)
+{
+	float	cx_f[ESCAPE_MAX_POINTS + ESCAPE_MAX_LANES];
+	float	cy_f[ESCAPE_MAX_POINTS + ESCAPE_MAX_LANES];
+	int		lane_counts[ESCAPE_MAX_LANES];
+	int		julia;
+	int		lanes;
+
+	julia = !ft_strncmp(fractal->name, "julia", 5);
+	lanes = ESCAPE_LANES_D;
+	if (kernel == ESCAPE_FLOAT)
+	{
+		lanes = ESCAPE_LANES_F;
+		for (int k = 0; k < n + ESCAPE_MAX_LANES; k++)
+		{
+			cx_f[k] = (float)cx[k];
+			cy_f[k] = (float)cy[k];
+		}
+	}
+	for (int k = 0; k < n; k += lanes)
+	{
+		if (kernel == ESCAPE_FLOAT)
+			escape_lanes_f(cx_f + k, cy_f + k, (float)fractal->julia_x,
+				(float)fractal->julia_y, julia, fractal, lane_counts);
+		else
+			escape_lanes_d(cx + k, cy + k, fractal->julia_x, fractal->julia_y,
+				julia, fractal, lane_counts);
+		for (int l = 0; l < lanes && k + l < n; l++)
+			counts[k + l] = lane_counts[l];
+	}
+}
+#endif
+
+//Iteration counts of pixels [x0, x1) of row y. The coordinates go through
+//map() once per pixel exactly as get_mapped_complex does, so the double
+//kernel reproduces the scalar one; the tail is padded to a full register.
+void	escape_span(t_fractal *fractal, int y, int x0, int x1,
+			int *counts, t_escape_kernel kernel)
+{
+	double	cx[WIDTH + ESCAPE_MAX_LANES];
+	double	cy[WIDTH + ESCAPE_MAX_LANES];
+
+	if (kernel == ESCAPE_SCALAR || kernel == ESCAPE_PERTURB || !HAS_SSE)
+	{
+		for (int x = x0; x < x1; x++)
+			counts[x - x0] = escape_pixel(x, y, fractal);
+		return ;
+	}
+	for (int k = 0; k < x1 - x0 + ESCAPE_MAX_LANES; k++)
+	{
+		cx[k] = pixel_x(fractal, x0 + k);
+		cy[k] = pixel_y(fractal, y);
+	}
+#if HAS_SSE
+	escape_points(fractal, cx, cy, x1 - x0, counts, kernel);
+#endif
+}
+
+//Same for pixels [y0, y1) of column x
+void	escape_column(t_fractal *fractal, int x, int y0, int y1,
+			int *counts, t_escape_kernel kernel)
+{
+	double	cx[HEIGHT + ESCAPE_MAX_LANES];
+	double	cy[HEIGHT + ESCAPE_MAX_LANES];
+
+	if (kernel == ESCAPE_SCALAR || kernel == ESCAPE_PERTURB || !HAS_SSE)
+	{
+		for (int y = y0; y < y1; y++)
+			counts[y - y0] = escape_pixel(x, y, fractal);
+		return ;
+	}
+	for (int k = 0; k < y1 - y0 + ESCAPE_MAX_LANES; k++)
+	{
+		cx[k] = pixel_x(fractal, x);
+		cy[k] = pixel_y(fractal, y0 + k);
+	}
+#if HAS_SSE
+	escape_points(fractal, cx, cy, y1 - y0, counts, kernel);
+#endif
+}
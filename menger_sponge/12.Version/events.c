@@ -12,6 +12,7 @@
 
 #include "platform.h"
 #include <stdio.h>
+#include <string.h>
 
 // Helper function to print status messages
 void display_status(t_fractal *fractal)
@@ -24,21 +25,34 @@ void display_status(t_fractal *fractal)
 		if (!ft_strncmp(fractal->name, "menger", 6))
 		{
 			// Menger sponge status
-			snprintf(status, 100, "3D Mode | Iterations: %d | Resolution: %d", 
-					fractal->menger.iterations, fractal->resolution_factor);
+			snprintf(status, 100, "3D Mode | Iterations: %d | Resolution: %d%s", 
+					fractal->menger.iterations, fractal->resolution_factor,
+					fractal->adaptive.enabled ? " | Adaptive" : "");
 		}
 		else if (!ft_strncmp(fractal->name, "mandelbrot3d", 12))
 		{
 			// 3D Mandelbrot status
-			snprintf(status, 100, "3D Mandelbrot | Iterations: %d | Resolution: %d", 
-					fractal->iterations_defintion, fractal->resolution_factor);
+			snprintf(status, 100, "3D Mandelbrot | Iterations: %d | Resolution: %d%s", 
+					fractal->iterations_defintion, fractal->resolution_factor,
+					fractal->adaptive.enabled ? " | Adaptive" : "");
 		}
 	}
 	else
 	{
 		// 2D mode status
-		snprintf(status, 100, "Fractal: %s | Zoom: %.2f | Iterations: %d", 
-				fractal->name, fractal->zoom, fractal->iterations_defintion);
+		snprintf(status, 100, "Fractal: %s | Zoom: %.3g | Iterations: %d | %s", 
+				fractal->name, fractal->zoom, fractal->iterations_defintion,
+				escape_kernel_name(escape_pick(fractal)));
+		// Deep zoom: iterations the series approximation saved per pixel
+		if (fractal->deep.active)
+			snprintf(status + strlen(status), 100 - strlen(status),
+				" | Skipped: %d", fractal->deep.skipped);
+		else if (!fractal->interior_checks)
+			snprintf(status + strlen(status), 100 - strlen(status),
+				" | No interior checks");
+		if (fractal->render_mode != RENDER_SINGLE)
+			snprintf(status + strlen(status), 100 - strlen(status),
+				" | %s", render_mode_name(fractal->render_mode));
 	}
 	
 	// Clear the window and display the status with a new image
@@ -58,6 +72,8 @@ int	close_handler(t_fractal *fractal)
 	if (freed)
 		return (0);
 	freed = 1;
+	render_pool_destroy(&fractal->pool);
+	deep_free(&fractal->deep);
 	
 	// Free BVH for Menger sponge if it exists
 	if (!ft_strncmp(fractal->name, "menger", 6) && fractal->menger.bvh_root)
@@ -232,6 +248,8 @@ int	key_handler(int keysym, t_fractal *fractal)
 		// Re-render if camera has changed
 		if (camera_changed)
 		{
+			// Frames go to the frame budget until the keys stop
+			adaptive_input(&fractal->adaptive);
 			if (!ft_strncmp(fractal->name, "menger", 6))
 				render_menger_sponge(fractal);
 			else if (!ft_strncmp(fractal->name, "mandelbrot3d", 12)) 
@@ -262,8 +280,6 @@ int	key_handler(int keysym, t_fractal *fractal)
 					// Build a new BVH with the higher iteration count
 					fractal->menger.bvh_root = build_menger_bvh(fractal->menger.iterations);
 					
-					// Re-render at a lower resolution for a quick preview
-					fractal->resolution_factor = 4;
 					render_menger_sponge(fractal);
 					display_status(fractal);
 				}
@@ -275,8 +291,6 @@ int	key_handler(int keysym, t_fractal *fractal)
 				{
 					fractal->iterations_defintion++;
 					
-					// Re-render at a lower resolution for a quick preview
-					fractal->resolution_factor = 4;
 					render_mandelbrot3d(fractal);
 					display_status(fractal);
 				}
@@ -313,8 +327,6 @@ int	key_handler(int keysym, t_fractal *fractal)
 					// Build a new BVH with the lower iteration count
 					fractal->menger.bvh_root = build_menger_bvh(fractal->menger.iterations);
 					
-					// Re-render at a lower resolution for a quick preview
-					fractal->resolution_factor = 4;
 					render_menger_sponge(fractal);
 					display_status(fractal);
 				}
@@ -326,8 +338,6 @@ int	key_handler(int keysym, t_fractal *fractal)
 				{
 					fractal->iterations_defintion--;
 					
-					// Re-render at a lower resolution for a quick preview
-					fractal->resolution_factor = 4;
 					render_mandelbrot3d(fractal);
 					display_status(fractal);
 				}
@@ -380,6 +390,17 @@ int	key_handler(int keysym, t_fractal *fractal)
 			display_status(fractal);
 			return (0);
 		}
+		// Adaptive resolution while moving, on or off
+#ifdef __APPLE__
+		else if (keysym == KEY_V)
+#else
+		else if (keysym == XK_v)
+#endif
+		{
+			fractal->adaptive.enabled = !fractal->adaptive.enabled;
+			fractal->adaptive.moving = 0;
+			display_status(fractal);
+		}
 		// Reset camera position
 #ifdef __APPLE__
 		else if (keysym == KEY_r)
@@ -389,6 +410,7 @@ int	key_handler(int keysym, t_fractal *fractal)
 		{
 			fractal->camera.position = (t_vec3){0, 0, -3};
 			fractal->camera.rotation = (t_vec3){0, 0, 0};
+			adaptive_input(&fractal->adaptive);
 			render_menger_sponge(fractal);
 		}
 		// Debug camera positions
@@ -400,6 +422,7 @@ int	key_handler(int keysym, t_fractal *fractal)
 		{
 			fractal->camera.position = (t_vec3){0.0, 0.0, -4.0};
 			fractal->camera.rotation = (t_vec3){0.0, 0.0, 0.0};
+			adaptive_input(&fractal->adaptive);
 			render_menger_sponge(fractal);
 		}
 #ifdef __APPLE__
@@ -410,6 +433,7 @@ int	key_handler(int keysym, t_fractal *fractal)
 		{
 			fractal->camera.position = (t_vec3){4.0, 0.0, 0.0};
 			fractal->camera.rotation = (t_vec3){0.0, -1.57, 0.0};
+			adaptive_input(&fractal->adaptive);
 			render_menger_sponge(fractal);
 		}
 #ifdef __APPLE__
@@ -420,6 +444,7 @@ int	key_handler(int keysym, t_fractal *fractal)
 		{
 			fractal->camera.position = (t_vec3){0.0, 4.0, -0.0};
 			fractal->camera.rotation = (t_vec3){1.6, 0.0, 0.0};
+			adaptive_input(&fractal->adaptive);
 			render_menger_sponge(fractal);
 		}
 #ifdef __APPLE__
@@ -430,6 +455,7 @@ int	key_handler(int keysym, t_fractal *fractal)
 		{
 			fractal->camera.position = (t_vec3){2.4, 0.4, -2.8};
 			fractal->camera.rotation = (t_vec3){0.15, -0.7, 0.0};
+			adaptive_input(&fractal->adaptive);
 			render_menger_sponge(fractal);
 		}
 #ifdef __APPLE__
@@ -440,6 +466,7 @@ int	key_handler(int keysym, t_fractal *fractal)
 		{
 			fractal->camera.position = (t_vec3){2.4, 2.0, -2.8};
 			fractal->camera.rotation = (t_vec3){0.45, -0.7, 0.0};
+			adaptive_input(&fractal->adaptive);
 			render_menger_sponge(fractal);
 		}
 		
@@ -465,6 +492,12 @@ int	key_handler(int keysym, t_fractal *fractal)
 		fractal->iterations_defintion -= 10;
 	else if (keysym == KEY_M)
 		fractal->mouse_control = !fractal->mouse_control;
+	else if (keysym == KEY_I)
+		fractal->interior_checks = fractal->interior_checks ? 0
+			: CHECK_BULBS | CHECK_PERIOD;
+	else if (keysym == KEY_B)
+		fractal->render_mode = (fractal->render_mode + 1)
+			% (RENDER_MARIANI + 1);
 #else
 	if (keysym == XK_Right)
 		fractal->shift_x += (0.5 * fractal->zoom);
@@ -480,6 +513,12 @@ int	key_handler(int keysym, t_fractal *fractal)
 		fractal->iterations_defintion -= 10;
 	else if (keysym == XK_m)
 		fractal->mouse_control = !fractal->mouse_control;
+	else if (keysym == XK_i)
+		fractal->interior_checks = fractal->interior_checks ? 0
+			: CHECK_BULBS | CHECK_PERIOD;
+	else if (keysym == XK_b)
+		fractal->render_mode = (fractal->render_mode + 1)
+			% (RENDER_MARIANI + 1);
 #endif
 	// Ensure we're in 2D mode for these fractals
 	fractal->is_3d = 0;
@@ -513,14 +552,14 @@ int	mouse_handler(int button, int x, int y, t_fractal *fractal)
 			
 			if (!ft_strncmp(fractal->name, "menger", 6))
 			{
-				// Use a lower resolution for preview during movement
-				fractal->resolution_factor = 4;
+				// Budget-sized frame while scrolling
+				adaptive_input(&fractal->adaptive);
 				render_menger_sponge(fractal);
 			}
 			else if (!ft_strncmp(fractal->name, "mandelbrot3d", 12))
 			{
-				// Use a lower resolution for preview during movement
-				fractal->resolution_factor = 4;
+				// Budget-sized frame while scrolling
+				adaptive_input(&fractal->adaptive);
 				render_mandelbrot3d(fractal);
 			}
 			
@@ -534,14 +573,14 @@ int	mouse_handler(int button, int x, int y, t_fractal *fractal)
 			
 			if (!ft_strncmp(fractal->name, "menger", 6))
 			{
-				// Use a lower resolution for preview during movement
-				fractal->resolution_factor = 4;
+				// Budget-sized frame while scrolling
+				adaptive_input(&fractal->adaptive);
 				render_menger_sponge(fractal);
 			}
 			else if (!ft_strncmp(fractal->name, "mandelbrot3d", 12))
 			{
-				// Use a lower resolution for preview during movement
-				fractal->resolution_factor = 4;
+				// Budget-sized frame while scrolling
+				adaptive_input(&fractal->adaptive);
 				render_mandelbrot3d(fractal);
 			}
 			
@@ -650,9 +689,8 @@ static void handle_3d_rotation(int x, int y, t_fractal *fractal)
 	fractal->prev_mouse_x = x;
 	fractal->prev_mouse_y = y;
 	
-	// Render at low resolution during dragging for better performance
-	// Use 4 instead of 8 for better quality during dragging
-	fractal->resolution_factor = 4;
+	// Budget-sized frames while dragging, a full one once it stops
+	adaptive_input(&fractal->adaptive);
 	
 	if (!ft_strncmp(fractal->name, "menger", 6))
 		render_menger_sponge(fractal);
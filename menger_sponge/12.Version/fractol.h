@@ -27,12 +27,44 @@
 # include <unistd.h>
 # include <math.h>
 # include <pthread.h>
+# include <stdatomic.h>
 # include <ctype.h>
+# include <stdint.h>
 # include "minilibx-linux/mlx.h"
 
+// SSE2 is part of the x86_64 baseline, AVX2 needs `make SIMD=avx2`
+# if defined(__SSE2__)
+#  include <immintrin.h>
+#  define HAS_SSE 1
+# else
+#  define HAS_SSE 0
+# endif
+# if defined(__AVX2__)
+#  define HAS_AVX2 1
+# else
+#  define HAS_AVX2 0
+# endif
+
 # define WIDTH	1280
 # define HEIGHT	1024
-# define NUM_THREADS 8  // Number of threads for multithreaded rendering
+# define TILE_SIZE 32 // Side of a render tile in pixels, before alignment
+# define MAX_RENDER_THREADS 64
+# define ADAPTIVE_TARGET_MS 33.0 // Frame budget while the 3D view is moving
+# define ADAPTIVE_IDLE_MS 150.0 // Input quiet this long: full frame
+# define ADAPTIVE_START_STEP 4 // Spacing of the first moving frame
+# define ADAPTIVE_MAX_STEP 16
+# define ESCAPE_FLOAT_ZOOM 0.05 // Zoomed in past this the float kernel smears
+# define DEEP_ZOOM_START 1e-10 // Zoomed in past this: perturbation
+# define DEEP_ZOOM_MIN 1e-120 // Deepest zoom MP_LIMBS can still resolve
+# define MP_LIMBS 16 // 32-bit limbs per t_mp, 480 fractional bits
+# define SA_TERMS 3 // Series approximation: terms in the pixel offset
+# define SA_TOLERANCE 0.01 // Last term's share of one pixel, at the corners
+# define CHECK_BULBS 1 // Mandelbrot: closed-form cardioid and period-2 bulb
+# define CHECK_PERIOD 2 // Brent periodicity detection on the orbit
+# define PERIOD_EPS 1e-12 // Orbit back this close to a saved point: a cycle
+# define PERIOD_EPS_F 1e-6f // Same for the float kernel
+# define MARIANI_TILE 128 // Side of a Mariani-Silver tile, one per task
+# define MARIANI_MIN 12 // Rectangles this thin are iterated pixel by pixel
 
 // 3D rendering constants
 # define FOV 60.0
@@ -89,6 +121,12 @@ typedef struct s_camera
 	t_vec3	position;
 	t_vec3	rotation;
 	double	fov;
+	t_vec3	forwards; //rotated axes, set by camera_setup once per frame
+	t_vec3	right;
+	t_vec3	up;
+	t_vec3	ray_corner; //pixel (x, y) looks along corner + x * dx + y * dy
+	t_vec3	ray_dx;
+	t_vec3	ray_dy;
 	double	aspect_ratio;
 	double	near;
 	double	far;
@@ -126,6 +164,117 @@ typedef struct s_img
 	int		line_len;
 }				t_img;
 
+//Renders the pixels [x0, x1) x [y0, y1) of one tile
+typedef void	(*t_tile_fn)(void *ctx, int x0, int y0, int x1, int y1);
+
+//One thread's share of a tiled render
+typedef struct s_tile_stats
+{
+	double	busy_ms; //CPU time spent on tiles
+	double	idle_ms; //render wall time minus busy time
+	int		tiles;
+}	t_tile_stats;
+
+//Render threads kept for the whole run, parked on a condition variable
+//between frames. The thread that submits a job works on it too.
+typedef struct s_render_pool
+{
+	pthread_t		ids[MAX_RENDER_THREADS];
+	int				workers;
+	int				started;
+	int				running; //workers still on the current job
+	unsigned int	generation; //bumped for every job
+	int				stop;
+	struct s_tile_job	*job;
+	pthread_mutex_t	lock;
+	pthread_cond_t	wake;
+	pthread_cond_t	done;
+}	t_render_pool;
+
+//Screen cut into tiles handed out through one atomic counter, so threads
+//that drew cheap tiles take more instead of waiting on the slowest one
+typedef struct s_tile_job
+{
+	t_tile_fn		render;
+	void			*ctx;
+	int				tile_w;
+	int				tile_h;
+	int				threads;
+	t_render_pool	*pool; //NULL: start threads for this job only
+	int				cols;
+	int				count;
+	atomic_int		next;
+	double			wall_ms;
+	t_tile_stats	stats[MAX_RENDER_THREADS];
+}	t_tile_job;
+
+//Frame budget while the 3D view moves: each moving frame is drawn at
+//`step`, picked from the measured cost of the ones before so it fits in
+//ADAPTIVE_TARGET_MS. When the input stops, the loop hook draws a full one.
+typedef struct s_adaptive
+{
+	int		enabled; //toggled with 'v'
+	int		moving; //input came within ADAPTIVE_IDLE_MS, full frame owed
+	int		step; //sample spacing of the next moving frame
+	double	full_ms; //smoothed estimate of a frame at spacing 1
+	double	last_input; //time of the latest input, ms
+}	t_adaptive;
+
+//Escape-time kernels for the 2D fractals, picked per frame by escape_pick
+typedef enum e_escape_kernel
+{
+	ESCAPE_SCALAR,
+	ESCAPE_DOUBLE, //4 lanes with AVX2, 2 with SSE2
+	ESCAPE_FLOAT, //8 lanes with AVX2, 4 with SSE2
+	ESCAPE_PERTURB //deep zoom, see deep_zoom.c
+}	t_escape_kernel;
+
+//2D render modes, cycled with 'b'
+typedef enum e_render_mode
+{
+	RENDER_SINGLE,
+	RENDER_THREADED,
+	RENDER_HYBRID,
+	RENDER_MARIANI //border tracing, see mariani.c
+}	t_render_mode;
+
+//Fixed-point multiprecision number: sign and magnitude, limb[0] is the
+//integer part and limb[k] weighs 2^(-32k)
+typedef struct s_mp
+{
+	int			neg;
+	uint32_t	limb[MP_LIMBS];
+}	t_mp;
+
+//Reference orbit in double, x and y share one allocation
+typedef struct s_orbit
+{
+	double	*x;
+	double	*y;
+	int		len;
+	int		cap;
+}	t_orbit;
+
+//Deep zoom state: the view centre is base + shift, with shift folded into
+//base every frame so it stays a small double
+typedef struct s_deep
+{
+	int		active;
+	t_mp	base_x;
+	t_mp	base_y;
+	t_orbit	ref; //orbit of the view centre (Mandelbrot: from 0, c = centre)
+	t_orbit	crit; //Julia only: orbit of 0, where pixels are rebased to
+	double	zoom; //view the orbits were computed for
+	int		iterations;
+	double	julia_x;
+	double	julia_y;
+	int		series; //series approximation on (the bench turns it off)
+	int		skipped; //iterations every pixel skips this frame
+	int		sa_start; //reference index the pixels start from
+	double	sa_radius; //largest pixel offset from the centre
+	t_complex	sa[SA_TERMS]; //coefficient k times sa_radius^(k+1)
+}	t_deep;
+
 typedef struct s_fractal
 {
 	char		*name;
@@ -150,14 +299,13 @@ typedef struct s_fractal
 	t_menger	menger;
 	int			is_3d;
 	int			resolution_factor;  // For controlling render resolution
+	t_render_pool	pool; // Render threads, started in fractal_init
+	t_adaptive	adaptive;
+	t_deep		deep;
+	int			interior_checks; // CHECK_* flags, toggled with 'i'
+	t_render_mode	render_mode; // 2D only
 }				t_fractal;
 
-typedef struct s_thread_data
-{
-	int			start_row;
-	int			end_row;
-	t_fractal	*fractal;
-}	t_thread_data;
 
 //events
 int			close_handler(t_fractal *fractal);
@@ -170,6 +318,39 @@ void        display_progress(t_fractal *fractal, const char *status_text);
 
 //handle_pixel
 void		handle_pixel(int x, int y, t_fractal *fractal);
+int			escape_pixel(int x, int y, t_fractal *fractal);
+int			in_main_bulbs(double x, double y);
+void		handle_pixel_span(int y, int x0, int x1, t_fractal *fractal);
+void		put_count_row(int y, int x0, int x1, const int *counts,
+				t_fractal *fractal);
+
+//escape_simd
+t_escape_kernel	escape_pick(t_fractal *fractal);
+const char	*escape_kernel_name(t_escape_kernel kernel);
+void		escape_span(t_fractal *fractal, int y, int x0, int x1,
+				int *counts, t_escape_kernel kernel);
+void		escape_column(t_fractal *fractal, int x, int y0, int y1,
+				int *counts, t_escape_kernel kernel);
+
+//mariani
+void		fractal_render_mariani(t_fractal *fractal);
+void		render_mariani_tile(void *ctx, int x0, int y0, int x1, int y1);
+const char	*render_mode_name(t_render_mode mode);
+
+//mp
+void		mp_from_double(t_mp *r, double v);
+double		mp_to_double(const t_mp *a);
+void		mp_add(t_mp *r, const t_mp *a, const t_mp *b);
+void		mp_sub(t_mp *r, const t_mp *a, const t_mp *b);
+void		mp_mul(t_mp *r, const t_mp *a, const t_mp *b);
+
+//deep_zoom
+void		deep_prepare(t_fractal *fractal);
+int			deep_escape(int x, int y, t_fractal *fractal);
+void		deep_free(t_deep *deep);
+
+//benchmark
+int			run_benchmarks(int ac, char **av);
 
 //init
 void		fractal_init(t_fractal *fractal);
@@ -199,13 +380,33 @@ int			ft_strncmp(char *s1, char *s2, int n);
 double		string_to_double(char *str);
 void		write_string_to_file_descriptor(char *str, int file_descriptor);
 
+//tile_scheduler
+int			render_thread_count(void);
+void		render_pool_init(t_render_pool *pool, int threads);
+void		render_pool_destroy(t_render_pool *pool);
+void		tile_job_init(t_tile_job *job, t_tile_fn render, void *ctx,
+				int align_x, int align_y);
+void		run_tile_job(t_tile_job *job);
+void		print_tile_stats(const t_tile_job *job, const char *name);
+
+//adaptive resolution
+double		get_time_ms(void);
+void		adaptive_init(t_adaptive *adaptive);
+void		adaptive_input(t_adaptive *adaptive);
+int			adaptive_step(const t_fractal *fractal);
+void		adaptive_record(t_adaptive *adaptive, int step, double ms);
+int			adaptive_loop_hook(t_fractal *fractal);
+
 //thread_render
-void		*thread_render(void *arg);
+void		render_fractal_tile(void *ctx, int x0, int y0, int x1, int y1);
 
 // 3D rendering functions
 void		init_3d(t_fractal *fractal);
 void		render_menger_sponge(t_fractal *fractal);
 t_vec3		rotate_point(t_vec3 point, t_vec3 rotation);
+void		camera_setup(t_camera *camera, double depth);
+t_vec3		camera_row(const t_camera *camera, double y);
+t_vec3		camera_ray_dir(const t_camera *camera, t_vec3 row, double x);
 void		project_point(t_vec3 point, t_fractal *fractal, int *x, int *y);
 int			is_point_in_menger(t_vec3 point, int iterations);
 
@@ -34,6 +34,21 @@ static int	get_pixel_color(int i, t_fractal *fractal)
 	return (map(i, color_bounds));
 }
 
+//Closed-form tests for the two largest interior regions of the Mandelbrot
+//set: the main cardioid and the period-2 bulb left of it
+int	in_main_bulbs(double x, double y)
+{
+	double	q;
+
+	q = (x - 0.25) * (x - 0.25) + y * y;
+	if (q * (q + (x - 0.25)) <= 0.25 * y * y)
+		return (1);
+	return ((x + 1.0) * (x + 1.0) + y * y <= 0.0625);
+}
+
+//With CHECK_PERIOD, Brent's cycle detection: z is saved at iterations
+//1, 2, 4, 8, ... and an orbit that comes back to the saved point has
+//settled on a cycle, so the pixel is interior
 static void	handle_fractal_iteration(t_complex *z,
 		t_complex c, int *i, t_fractal *fractal)
 {
@@ -41,11 +56,15 @@ static void	handle_fractal_iteration(t_complex *z,
 	double	zy;
 	double	zx_sq;
 	double	zy_sq;
+	t_complex	saved;
+	int		limit;
 
 	zx = z->x;
 	zy = z->y;
 	zx_sq = zx * zx;
 	zy_sq = zy * zy;
+	saved = *z;
+	limit = 1;
 	while (*i < fractal->iterations_defintion)
 	{
 		if (zx_sq + zy_sq > fractal->escape_value)
@@ -55,14 +74,42 @@ static void	handle_fractal_iteration(t_complex *z,
 		zx_sq = zx * zx;
 		zy_sq = zy * zy;
 		(*i)++;
+		if (fractal->interior_checks & CHECK_PERIOD)
+		{
+			if (fabs(zx - saved.x) + fabs(zy - saved.y) <= PERIOD_EPS)
+				*i = fractal->iterations_defintion;
+			if (*i == limit)
+			{
+				saved = (t_complex){zx, zy};
+				limit *= 2;
+			}
+		}
 	}
 }
 
-void	handle_pixel(int x, int y, t_fractal *fractal)
+//Iterations before the pixel escapes, the scalar reference for escape_span.
+//Deep views go through the perturbation path instead.
+int	escape_pixel(int x, int y, t_fractal *fractal)
 {
 	t_complex	z;
 	t_complex	c;
 	int			i;
+
+	if (fractal->deep.active)
+		return (deep_escape(x, y, fractal));
+	i = 0;
+	z = get_mapped_complex(x, y, fractal);
+	if ((fractal->interior_checks & CHECK_BULBS)
+		&& ft_strncmp(fractal->name, "julia", 5) && in_main_bulbs(z.x, z.y))
+		return (fractal->iterations_defintion);
+	mandelbrot_vs_julia(&z, &c, fractal);
+	handle_fractal_iteration(&z, c, &i, fractal);
+	return (i);
+}
+
+void	handle_pixel(int x, int y, t_fractal *fractal)
+{
+	int			i;
 	int			color;
 
 	// Safety check for null pointer
@@ -77,10 +124,7 @@ void	handle_pixel(int x, int y, t_fractal *fractal)
 		return;
 	}
 
-	i = 0;
-	z = get_mapped_complex(x, y, fractal);
-	mandelbrot_vs_julia(&z, &c, fractal);
-	handle_fractal_iteration(&z, c, &i, fractal);
+	i = escape_pixel(x, y, fractal);
 	
 	if (i < fractal->iterations_defintion)
 	{
@@ -94,3 +138,36 @@ void	handle_pixel(int x, int y, t_fractal *fractal)
 	// Write the pixel to the image buffer
 	pixel_put(x, y, &fractal->img, color);
 }
+
+//Colours pixels [x0, x1) of row y from their iteration counts
+void	put_count_row(int y, int x0, int x1, const int *counts,
+			t_fractal *fractal)
+{
+	int	x;
+
+	x = x0;
+	while (x < x1)
+	{
+		if (counts[x - x0] < fractal->iterations_defintion)
+			pixel_put(x, y, &fractal->img,
+				get_pixel_color(counts[x - x0], fractal));
+		else
+			pixel_put(x, y, &fractal->img, BLACK);
+		x++;
+	}
+}
+
+//Pixels [x0, x1) of row y through the SIMD kernel picked for this view
+void	handle_pixel_span(int y, int x0, int x1, t_fractal *fractal)
+{
+	int	counts[WIDTH];
+
+	if (!fractal || !fractal->img.pixels_ptr || y < 0 || y >= HEIGHT)
+		return ;
+	if (x0 < 0)
+		x0 = 0;
+	if (x1 > WIDTH)
+		x1 = WIDTH;
+	escape_span(fractal, y, x0, x1, counts, escape_pick(fractal));
+	put_count_row(y, x0, x1, counts, fractal);
+}
@@ -30,6 +30,9 @@ static void	data_init(t_fractal *fractal)
 	fractal->prev_mouse_x = 0;
 	fractal->prev_mouse_y = 0;
 	fractal->resolution_factor = 4;  // Default resolution factor
+	adaptive_init(&fractal->adaptive);
+	fractal->deep.series = 1;
+	fractal->interior_checks = CHECK_BULBS | CHECK_PERIOD;
 	
 	// Initialize camera defaults for 3D fractals
 	fractal->is_3d = 0;  // Default to 2D mode
@@ -56,6 +59,7 @@ static void	events_init(t_fractal *fractal)
 	mlx_hook(fractal->mlx_window, 5, 1L<<3, mouse_release, fractal);
 	mlx_hook(fractal->mlx_window, 17, 0, close_handler, fractal);
 	mlx_hook(fractal->mlx_window, 6, 1L<<6, julia_track, fractal);
+	mlx_loop_hook(fractal->mlx_connection, adaptive_loop_hook, fractal);
 #else
 	mlx_hook(fractal->mlx_window, KeyPress,
 		KeyPressMask, key_handler, fractal);
@@ -67,6 +71,7 @@ static void	events_init(t_fractal *fractal)
 		StructureNotifyMask, close_handler, fractal);
 	mlx_hook(fractal->mlx_window, MotionNotify,
 		PointerMotionMask, julia_track, fractal);
+	mlx_loop_hook(fractal->mlx_connection, adaptive_loop_hook, fractal);
 #endif
 }
 
@@ -100,4 +105,5 @@ void	fractal_init(t_fractal *fractal)
 			&fractal->img.bpp, &fractal->img.line_len, &fractal->img.endian);
 	events_init(fractal);
 	data_init(fractal);
+	render_pool_init(&fractal->pool, render_thread_count());
 }
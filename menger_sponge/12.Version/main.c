@@ -72,7 +72,8 @@ void	print_usage_and_exit(void)
 		"\n\t./fractol mandelbrot"
 		"\n\t./fractol julia <value1> <value2>"
 		"\n\t./fractol menger"
-		"\n\t./fractol mandelbrot3d\n", STDERR_FILENO);
+		"\n\t./fractol mandelbrot3d"
+		"\n\t./fractol bench <name> [args]\n", STDERR_FILENO);
 	exit(EXIT_FAILURE);
 }
 
@@ -83,6 +84,8 @@ int	main(int ac, char **av)
 	// Initialize the structure to zeros/NULL to avoid uninitialized memory
 	memset(&fractal, 0, sizeof(t_fractal));
 	
+	if (ac >= 2 && !ft_strncmp(av[1], "bench", 6))
+		return (run_benchmarks(ac, av));
 	if ((ac == 2 && !ft_strncmp(av[1], "mandelbrot", 10))
 		|| (ac == 4 && !ft_strncmp(av[1], "julia", 5))
 		|| (ac == 2 && !ft_strncmp(av[1], "menger", 6))
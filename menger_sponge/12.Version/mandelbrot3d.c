@@ -15,10 +15,12 @@
 #include <stdlib.h>
 #include <pthread.h>
 
-// Thread data structure for parallel rendering
+// Screen area one call of render_mandelbrot3d_thread draws (a scheduler tile)
 typedef struct s_mandelbrot3d_thread_data
 {
     t_fractal   *fractal;
+    int         start_x;
+    int         end_x;
     int         start_y;
     int         end_y;
 } t_mandelbrot3d_thread_data;
@@ -184,32 +186,12 @@ double mandelbrot3d_DE(t_vec3 pos, t_fractal *fractal)
     return dist_from_point;
 }
 
-// Generate ray from camera position toward the specified pixel
+// Generate ray from camera position toward the specified pixel, on the
+// grid camera_setup made for this frame (looking along negative z)
 void generate_ray(int x, int y, t_fractal *fractal, t_vec3 *ray_origin, t_vec3 *ray_direction)
 {
-    // Calculate normalized device coordinates (-1 to 1)
-    double ndc_x = (2.0 * x / WIDTH) - 1.0;
-    double ndc_y = 1.0 - (2.0 * y / HEIGHT);
-    
-    // Adjust for aspect ratio to prevent distortion
-    double aspect = (double)WIDTH / HEIGHT;
-    ndc_x *= aspect;
-    
-    // Apply FOV (field of view)
-    double fov_rad = fractal->camera.fov * M_PI / 180.0;
-    double scale = tan(fov_rad * 0.5);
-    ndc_x *= scale;
-    ndc_y *= scale;
-    
-    // Create the ray direction in camera space
-    t_vec3 dir = {ndc_x, ndc_y, -1.0};  // -1 because we look along negative z-axis
-    dir = vec3_normalize(dir);
-    
-    // Apply camera rotation (simplified version)
-    // For a proper implementation, we would use a rotation matrix
-    *ray_direction = rotate_point(dir, fractal->camera.rotation);
-    
-    // Set ray origin to camera position
+    *ray_direction = camera_ray_dir(&fractal->camera,
+        camera_row(&fractal->camera, y), x);
     *ray_origin = fractal->camera.position;
 }
 
@@ -447,10 +429,10 @@ void *render_mandelbrot3d_thread(void *arg)
     // Determine resolution reduction factor (blocky preview first)
     int res = fractal->resolution_factor;
     
-    // Process each pixel in assigned rows
+    // Process each pixel of the tile
     for (int y = data->start_y; y < data->end_y; y += res)
     {
-        for (int x = 0; x < WIDTH; x += res)
+        for (int x = data->start_x; x < data->end_x; x += res)
         {
             t_vec3 ray_origin, ray_direction;
             double hit_distance;
@@ -473,7 +455,7 @@ void *render_mandelbrot3d_thread(void *arg)
             for (int fy = 0; fy < res && (y + fy) < data->end_y; fy++)
             {
                 int row_offset = (y + fy) * img->line_len;
-                for (int fx = 0; fx < res && (x + fx) < WIDTH; fx++)
+                for (int fx = 0; fx < res && (x + fx) < data->end_x; fx++)
                 {
                     int offset = row_offset + (x + fx) * bpp_bytes;
                     if (offset >= 0 && offset < img->line_len * HEIGHT)
@@ -517,6 +499,19 @@ void init_mandelbrot3d(t_fractal *fractal)
     display_progress(fractal, "Initializing 2.5D Mandelbrot Terrain...");
 }
 
+// Tile callback for the scheduler
+static void render_mandelbrot3d_tile(void *ctx, int x0, int y0, int x1, int y1)
+{
+    t_mandelbrot3d_thread_data data;
+
+    data.fractal = (t_fractal *)ctx;
+    data.start_x = x0;
+    data.end_x = x1;
+    data.start_y = y0;
+    data.end_y = y1;
+    render_mandelbrot3d_thread(&data);
+}
+
 // Main render function for 3D Mandelbrot
 void render_mandelbrot3d(t_fractal *fractal)
 {
@@ -529,33 +524,36 @@ void render_mandelbrot3d(t_fractal *fractal)
     
     // Progressive rendering for better user experience
     
-    // Define number of threads
-    #define MB3D_THREADS 8
-    
-    pthread_t threads[MB3D_THREADS];
-    t_mandelbrot3d_thread_data thread_data[MB3D_THREADS];
-    
-    // Divide the screen into horizontal stripes for each thread
-    int rows_per_thread = HEIGHT / MB3D_THREADS;
-    
-    // Create and launch threads
-    for (int i = 0; i < MB3D_THREADS; i++)
-    {
-        thread_data[i].fractal = fractal;
-        thread_data[i].start_y = i * rows_per_thread;
-        thread_data[i].end_y = (i == MB3D_THREADS - 1) ? HEIGHT : (i + 1) * rows_per_thread;
-        
-        pthread_create(&threads[i], NULL, render_mandelbrot3d_thread, &thread_data[i]);
-    }
-    
-    // Wait for all threads to complete
-    for (int i = 0; i < MB3D_THREADS; i++)
-    {
-        pthread_join(threads[i], NULL);
-    }
+    // Camera basis once per frame, -1: the terrain camera looks along -z
+    camera_setup(&fractal->camera, -1.0);
+
+    // While the view moves the spacing comes from the frame budget; the
+    // tiles read it from resolution_factor
+    int res = fractal->resolution_factor;
+    int step = adaptive_step(fractal);
+
+    if (step)
+        fractal->resolution_factor = step;
+
+    // Tiles follow the res x res sample grid
+    t_tile_job job;
+
+    tile_job_init(&job, render_mandelbrot3d_tile, fractal,
+        fractal->resolution_factor, fractal->resolution_factor);
+    job.pool = &fractal->pool;
+    run_tile_job(&job);
+    fractal->resolution_factor = res;
+#ifdef DEBUG
+    print_tile_stats(&job, "mandelbrot3d");
+#endif
     
     // Update the display
     draw_image_to_window(fractal);
+    if (step)
+    {
+        adaptive_record(&fractal->adaptive, step, job.wall_ms);
+        return;
+    }
     
     // Show status when rendering is complete
     display_status(fractal);
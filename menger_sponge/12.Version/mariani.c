@@ -0,0 +1,144 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   mariani.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: asplavni <asplavni@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by asplavni          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by asplavni         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+
+//Mariani-Silver subdivision for the 2D fractals. Inside a tile only the
+//border of a rectangle is iterated; when every border pixel has the same
+//count, the inside is filled with it. The fill is approximate for both
+//sets: filaments thinner than a pixel can slip between the border samples
+//and get painted over. Otherwise the rectangle is cut in two along its
+//longer side, the cut line is iterated, and each half is handled the same
+//way with its border already known.
+
+typedef struct s_mariani
+{
+	t_fractal		*fractal;
+	t_escape_kernel	kernel;
+	int				x0; //tile origin and row stride of counts
+	int				y0;
+	int				w;
+	int				*counts;
+}	t_mariani;
+
+static int	*count_at(t_mariani *m, int x, int y)
+{
+	return (&m->counts[(y - m->y0) * m->w + x - m->x0]);
+}
+
+static void	mariani_row(t_mariani *m, int y, int x0, int x1)
+{
+	if (x1 > x0)
+		escape_span(m->fractal, y, x0, x1, count_at(m, x0, y), m->kernel);
+}
+
+static void	mariani_column(t_mariani *m, int x, int y0, int y1)
+{
+	int	column[MARIANI_TILE];
+
+	if (y1 <= y0)
+		return ;
+	escape_column(m->fractal, x, y0, y1, column, m->kernel);
+	for (int y = y0; y < y1; y++)
+		*count_at(m, x, y) = column[y - y0];
+}
+
+static int	border_uniform(t_mariani *m, int x0, int y0, int x1, int y1)
+{
+	int	count;
+
+	count = *count_at(m, x0, y0);
+	for (int x = x0; x < x1; x++)
+		if (*count_at(m, x, y0) != count || *count_at(m, x, y1 - 1) != count)
+			return (0);
+	for (int y = y0 + 1; y < y1 - 1; y++)
+		if (*count_at(m, x0, y) != count || *count_at(m, x1 - 1, y) != count)
+			return (0);
+	return (1);
+}
+
+//Rectangle [x0, x1) x [y0, y1) whose border counts are already known
+static void	mariani_rect(t_mariani *m, int x0, int y0, int x1, int y1)
+{
+	int	count;
+	int	mid;
+
+	if (border_uniform(m, x0, y0, x1, y1))
+	{
+		count = *count_at(m, x0, y0);
+		for (int y = y0 + 1; y < y1 - 1; y++)
+			for (int x = x0 + 1; x < x1 - 1; x++)
+				*count_at(m, x, y) = count;
+	}
+	else if (x1 - x0 <= MARIANI_MIN || y1 - y0 <= MARIANI_MIN)
+	{
+		for (int y = y0 + 1; y < y1 - 1; y++)
+			mariani_row(m, y, x0 + 1, x1 - 1);
+	}
+	else if (x1 - x0 >= y1 - y0)
+	{
+		mid = (x0 + x1) / 2;
+		mariani_column(m, mid, y0 + 1, y1 - 1);
+		mariani_rect(m, x0, y0, mid + 1, y1);
+		mariani_rect(m, mid, y0, x1, y1);
+	}
+	else
+	{
+		mid = (y0 + y1) / 2;
+		mariani_row(m, mid, x0 + 1, x1 - 1);
+		mariani_rect(m, x0, y0, x1, mid + 1);
+		mariani_rect(m, x0, mid, x1, y1);
+	}
+}
+
+//Tile callback for fractal_render_mariani
+void	render_mariani_tile(void *ctx, int x0, int y0, int x1, int y1)
+{
+	int			counts[MARIANI_TILE * MARIANI_TILE];
+	t_mariani	m;
+
+	m = (t_mariani){ctx, escape_pick(ctx), x0, y0, x1 - x0, counts};
+	mariani_row(&m, y0, x0, x1);
+	mariani_row(&m, y1 - 1, x0, x1);
+	mariani_column(&m, x0, y0 + 1, y1 - 1);
+	mariani_column(&m, x1 - 1, y0 + 1, y1 - 1);
+	mariani_rect(&m, x0, y0, x1, y1);
+	for (int y = y0; y < y1; y++)
+		put_count_row(y, x0, x1, count_at(&m, x0, y), m.fractal);
+}
+
+void	fractal_render_mariani(t_fractal *fractal)
+{
+	t_tile_job	job;
+
+	deep_prepare(fractal);
+	tile_job_init(&job, render_mariani_tile, fractal, 1, 1);
+	job.tile_w = MARIANI_TILE;
+	job.tile_h = MARIANI_TILE;
+	job.pool = &fractal->pool;
+	run_tile_job(&job);
+#ifdef DEBUG
+	print_tile_stats(&job, fractal->name);
+#endif
+	draw_image_to_window(fractal);
+}
+
+const char	*render_mode_name(t_render_mode mode)
+{
+	if (mode == RENDER_THREADED)
+		return ("threaded");
+	if (mode == RENDER_HYBRID)
+		return ("hybrid");
+	if (mode == RENDER_MARIANI)
+		return ("mariani");
+	return ("single");
+}
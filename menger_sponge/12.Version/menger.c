@@ -33,10 +33,12 @@
 #define ray_intersect_aabb ray_intersect_aabb_scalar
 #endif
 
-// Add this structure near the top of the file, after the includes
+// Screen area one call of render_menger_thread draws (a scheduler tile)
 typedef struct s_menger_thread_data
 {
     t_fractal   *fractal;
+    int         start_x;
+    int         end_x;
     int         start_y;
     int         end_y;
 } t_menger_thread_data;
@@ -606,6 +608,47 @@ t_vec3	rotate_point(t_vec3 point, t_vec3 rotation)
 	return (result);
 }
 
+//Camera basis and pixel grid for one frame: the rotation is applied to
+//the three axes here instead of to every ray. depth is the camera space
+//z of the image plane, 1.0 for the sponge, -1.0 for mandelbrot3d.
+void	camera_setup(t_camera *camera, double depth)
+{
+	double	scale;
+
+	scale = tan(camera->fov * M_PI / 360.0);
+	camera->forwards = rotate_point((t_vec3){0.0, 0.0, depth}, camera->rotation);
+	camera->right = rotate_point((t_vec3){1.0, 0.0, 0.0}, camera->rotation);
+	camera->up = rotate_point((t_vec3){0.0, 1.0, 0.0}, camera->rotation);
+	camera->ray_dx = vec3_mul(camera->right,
+			2.0 * scale * camera->aspect_ratio / WIDTH);
+	camera->ray_dy = vec3_mul(camera->up, -2.0 * scale / HEIGHT);
+	camera->ray_corner = vec3_add(camera->forwards, vec3_add(
+				vec3_mul(camera->right, -scale * camera->aspect_ratio),
+				vec3_mul(camera->up, scale)));
+}
+
+//Start of pixel row y, shared by every ray of the row
+t_vec3	camera_row(const t_camera *camera, double y)
+{
+	return ((t_vec3){camera->ray_corner.x + y * camera->ray_dy.x,
+		camera->ray_corner.y + y * camera->ray_dy.y,
+		camera->ray_corner.z + y * camera->ray_dy.z});
+}
+
+//Unit direction of pixel x on a row from camera_row: one multiply-add
+//per axis (fused when built with FMA), then the normalization
+t_vec3	camera_ray_dir(const t_camera *camera, t_vec3 row, double x)
+{
+	t_vec3	dir;
+	double	len;
+
+	dir.x = row.x + x * camera->ray_dx.x;
+	dir.y = row.y + x * camera->ray_dx.y;
+	dir.z = row.z + x * camera->ray_dx.z;
+	len = sqrt(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+	return ((t_vec3){dir.x / len, dir.y / len, dir.z / len});
+}
+
 void	project_point(t_vec3 point, t_fractal *fractal, int *x, int *y)
 {
 	double	scale;
@@ -1080,8 +1123,7 @@ void *render_menger_thread(void *arg)
 	t_vec3 ray_dir, ray_pos, hit_point, normal, reflect_dir;
 	double t_min, t_max;
 	int color, is_interior;
-	double fov_scale = tan(fractal->camera.fov * M_PI / 360.0);
-	double aspect_ratio = fractal->camera.aspect_ratio;
+	t_vec3 row;
 
 	t_vec3 light_dir = {0.5, 0.5, -1.0};
 	double len = sqrt(light_dir.x * light_dir.x + light_dir.y * light_dir.y + light_dir.z * light_dir.z);
@@ -1091,16 +1133,10 @@ void *render_menger_thread(void *arg)
 
 	for (int y = data->start_y; y < data->end_y; y += res)
 	{
-		for (int x = 0; x < WIDTH; x += res)
+		row = camera_row(&fractal->camera, y);
+		for (int x = data->start_x; x < data->end_x; x += res)
 		{
-			ray_dir.x = (2.0 * x / (double)WIDTH - 1.0) * fov_scale * aspect_ratio;
-			ray_dir.y = (1.0 - 2.0 * y / (double)HEIGHT) * fov_scale;
-			ray_dir.z = 1.0;
-			ray_dir = rotate_point(ray_dir, fractal->camera.rotation);
-			len = sqrt(ray_dir.x * ray_dir.x + ray_dir.y * ray_dir.y + ray_dir.z * ray_dir.z);
-			ray_dir.x /= len;
-			ray_dir.y /= len;
-			ray_dir.z /= len;
+			ray_dir = camera_ray_dir(&fractal->camera, row, x);
 			ray_pos = fractal->camera.position;
 			color = BLACK;
 
@@ -1220,7 +1256,7 @@ void *render_menger_thread(void *arg)
 			for (int fy = 0; fy < res && (y + fy) < data->end_y; fy++)
 			{
 				int row_offset = (y + fy) * img->line_len;
-				for (int fx = 0; fx < res && (x + fx) < WIDTH; fx++)
+				for (int fx = 0; fx < res && (x + fx) < data->end_x; fx++)
 				{
 					int offset = row_offset + (x + fx) * bpp_bytes;
 					*(unsigned int *)(img->pixels_ptr + offset) = color;
@@ -1234,6 +1270,20 @@ void *render_menger_thread(void *arg)
 
 
 
+// Tile callback for the scheduler
+static void render_menger_tile(void *ctx, int x0, int y0, int x1, int y1)
+{
+    t_menger_thread_data data;
+
+    data.fractal = (t_fractal *)ctx;
+    data.start_x = x0;
+    data.end_x = x1;
+    data.start_y = y0;
+    data.end_y = y1;
+    render_menger_thread(&data);
+}
+
+
 // Replace the render_menger_sponge function with this optimized version
 void	render_menger_sponge(t_fractal *fractal)
 {
@@ -1241,46 +1291,51 @@ void	render_menger_sponge(t_fractal *fractal)
     if (!fractal->is_3d || ft_strncmp(fractal->name, "menger", 6) != 0)
         return;
 
-    // Display rendering status
-    display_progress(fractal, "Rendering Menger sponge...");
+    // While the view moves the spacing comes from the frame budget; the
+    // tiles read it from resolution_factor
+    int res = fractal->resolution_factor;
+    int step = adaptive_step(fractal);
 
-    // Clear the entire image with black to prevent any artifacts
-    int x, y;
-    for (y = 0; y < HEIGHT; y++)
+    if (step)
+        fractal->resolution_factor = step;
+    else
     {
-        for (x = 0; x < WIDTH; x++)
+        // Display rendering status
+        display_progress(fractal, "Rendering Menger sponge...");
+
+        // Clear the entire image with black to prevent any artifacts
+        int x, y;
+        for (y = 0; y < HEIGHT; y++)
         {
-            pixel_put(x, y, &fractal->img, BLACK);
+            for (x = 0; x < WIDTH; x++)
+            {
+                pixel_put(x, y, &fractal->img, BLACK);
+            }
         }
-    }
-
-    // Show black screen first to indicate processing
-    draw_image_to_window(fractal);
-
-    // Define number of threads - adjust based on system capabilities
-    // Using more threads than CPU cores usually doesn't help and can hurt performance
-    #define NUM_THREADS 8  // Adjust based on your CPU cores
 
-    pthread_t threads[NUM_THREADS];
-    t_menger_thread_data thread_data[NUM_THREADS];
-
-    // Divide the screen into horizontal stripes for each thread
-    int rows_per_thread = HEIGHT / NUM_THREADS;
+        // Show black screen first to indicate processing
+        draw_image_to_window(fractal);
+    }
 
-    // Create and launch threads
-    for (int i = 0; i < NUM_THREADS; i++)
-    {
-        thread_data[i].fractal = fractal;
-        thread_data[i].start_y = i * rows_per_thread;
-        thread_data[i].end_y = (i == NUM_THREADS - 1) ? HEIGHT : (i + 1) * rows_per_thread;
+    // Camera basis once per frame, the tiles only read it
+    camera_setup(&fractal->camera, 1.0);
 
-        pthread_create(&threads[i], NULL, render_menger_thread, &thread_data[i]);
-    }
+    // Tiles follow the res x res sample grid
+    t_tile_job job;
 
-    // Wait for all threads to complete
-    for (int i = 0; i < NUM_THREADS; i++)
+    tile_job_init(&job, render_menger_tile, fractal,
+        fractal->resolution_factor, fractal->resolution_factor);
+    job.pool = &fractal->pool;
+    run_tile_job(&job);
+    fractal->resolution_factor = res;
+#ifdef DEBUG
+    print_tile_stats(&job, "menger");
+#endif
+    if (step)
     {
-        pthread_join(threads[i], NULL);
+        draw_image_to_window(fractal);
+        adaptive_record(&fractal->adaptive, step, job.wall_ms);
+        return;
     }
 
     // Final display update - first draw the completed image
@@ -0,0 +1,162 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   mp.c                                               :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: asplavni <asplavni@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by asplavni          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by asplavni         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include <string.h>
+
+//Small fixed-point multiprecision arithmetic for the deep zoom reference
+//orbit. Only what z^2 + c needs: add, sub, mul and conversions. Results
+//are truncated past the last limb; the integer limb must not overflow,
+//which holds for anything below the escape radius.
+
+void	mp_from_double(t_mp *r, double v)
+{
+	double	part;
+
+	memset(r, 0, sizeof(t_mp));
+	r->neg = v < 0;
+	v = fabs(v);
+	part = floor(v);
+	r->limb[0] = (uint32_t)part;
+	v -= part;
+	for (int k = 1; k < MP_LIMBS && v > 0; k++)
+	{
+		v *= 4294967296.0;
+		part = floor(v);
+		r->limb[k] = (uint32_t)part;
+		v -= part;
+	}
+}
+
+//Rounded from the first four significant limbs, enough for 53 bits
+double	mp_to_double(const t_mp *a)
+{
+	double	r;
+	int		first;
+	int		last;
+
+	first = 0;
+	while (first < MP_LIMBS && !a->limb[first])
+		first++;
+	if (first == MP_LIMBS)
+		return (0.0);
+	last = first + 3;
+	if (last >= MP_LIMBS)
+		last = MP_LIMBS - 1;
+	r = 0.0;
+	for (int k = last; k >= first; k--)
+		r += ldexp((double)a->limb[k], -32 * k);
+	return (a->neg ? -r : r);
+}
+
+static int	mag_cmp(const t_mp *a, const t_mp *b)
+{
+	for (int k = 0; k < MP_LIMBS; k++)
+		if (a->limb[k] != b->limb[k])
+			return (a->limb[k] < b->limb[k] ? -1 : 1);
+	return (0);
+}
+
+static void	mag_add(t_mp *r, const t_mp *a, const t_mp *b)
+{
+	uint64_t	carry;
+
+	carry = 0;
+	for (int k = MP_LIMBS - 1; k >= 0; k--)
+	{
+		carry += (uint64_t)a->limb[k] + b->limb[k];
+		r->limb[k] = (uint32_t)carry;
+		carry >>= 32;
+	}
+}
+
+//|a| - |b|, with |a| >= |b|
+static void	mag_sub(t_mp *r, const t_mp *a, const t_mp *b)
+{
+	int64_t	borrow;
+	int64_t	d;
+
+	borrow = 0;
+	for (int k = MP_LIMBS - 1; k >= 0; k--)
+	{
+		d = (int64_t)a->limb[k] - b->limb[k] - borrow;
+		borrow = d < 0;
+		r->limb[k] = (uint32_t)(d + (borrow << 32));
+	}
+}
+
+static void	signed_add(t_mp *r, const t_mp *a, const t_mp *b, int b_neg)
+{
+	if (a->neg == b_neg)
+	{
+		mag_add(r, a, b);
+		r->neg = b_neg;
+	}
+	else if (mag_cmp(a, b) >= 0)
+	{
+		r->neg = a->neg;
+		mag_sub(r, a, b);
+	}
+	else
+	{
+		r->neg = b_neg;
+		mag_sub(r, b, a);
+	}
+}
+
+//r may alias a or b
+void	mp_add(t_mp *r, const t_mp *a, const t_mp *b)
+{
+	signed_add(r, a, b, b->neg);
+}
+
+void	mp_sub(t_mp *r, const t_mp *a, const t_mp *b)
+{
+	signed_add(r, a, b, !b->neg);
+}
+
+//Schoolbook product. Limb i of a times limb j of b weighs 2^(-32(i+j)):
+//its low half lands in column i+j and its high half in column i+j-1, so
+//each column sums 32-bit halves (no 64-bit overflow for 16 limbs) and the
+//carries run once from the least significant kept column up.
+void	mp_mul(t_mp *r, const t_mp *a, const t_mp *b)
+{
+	uint64_t	lo[MP_LIMBS + 1];
+	uint64_t	hi[MP_LIMBS + 2];
+	uint64_t	p;
+	uint64_t	carry;
+	int			neg;
+
+	memset(lo, 0, sizeof(lo));
+	memset(hi, 0, sizeof(hi));
+	for (int i = 0; i < MP_LIMBS; i++)
+	{
+		if (!a->limb[i])
+			continue ;
+		for (int j = 0; i + j <= MP_LIMBS && j < MP_LIMBS; j++)
+		{
+			p = (uint64_t)a->limb[i] * b->limb[j];
+			lo[i + j] += p & 0xFFFFFFFFu;
+			hi[i + j] += p >> 32;
+		}
+	}
+	neg = a->neg != b->neg;
+	carry = 0;
+	for (int k = MP_LIMBS; k >= 0; k--)
+	{
+		carry += lo[k] + hi[k + 1];
+		if (k < MP_LIMBS)
+			r->limb[k] = (uint32_t)carry;
+		carry >>= 32;
+	}
+	r->neg = neg;
+}
@@ -48,29 +48,8 @@ void	mandelbrot_vs_julia(t_complex *complex_z,
 
 void	render_pixel_row(int y, t_fractal *fractal, t_complex z)
 {
-	t_bounds	bounds_x;
-	t_bounds	bounds_y;
-	double		mapped_y;
-	int			x;
-	t_complex	local_z;
-
 	(void)z; // Explicitly mark z as unused to prevent warnings
-	(void)local_z;
-	bounds_x = (t_bounds){-2, +2, 0, WIDTH};
-	bounds_y = (t_bounds){+2, -2, 0, HEIGHT};
-	mapped_y = (map(y, bounds_y) * fractal->zoom) + fractal->shift_y;
-	x = 0;
-	while (x < WIDTH)
-	{
-		local_z.x = (map(x, bounds_x) * fractal->zoom) + fractal->shift_x;
-		local_z.y = mapped_y;
-		
-		// We're calculating the coordinates but not passing them to handle_pixel
-		// Just let handle_pixel do its own coordinate calculation since it does that anyway
-		handle_pixel(x, y, fractal);
-		
-		x++;
-	}
+	handle_pixel_span(y, 0, WIDTH, fractal);
 }
 
 void	draw_image_to_window(t_fractal *fractal)
@@ -81,45 +60,16 @@ void	draw_image_to_window(t_fractal *fractal)
 
 void	fractal_render_multithreaded(t_fractal *fractal)
 {
-	pthread_t		threads[NUM_THREADS];
-	t_thread_data	thread_data[NUM_THREADS];
-	int				i;
-	int				rows_per_thread;
+	t_tile_job	job;
 
-	// Calculate how many rows each thread should process
-	rows_per_thread = HEIGHT / NUM_THREADS;
+	deep_prepare(fractal);
+	tile_job_init(&job, render_fractal_tile, fractal, 1, 1);
+	job.pool = &fractal->pool;
+	run_tile_job(&job);
+#ifdef DEBUG
+	print_tile_stats(&job, fractal->name);
+#endif
 
-	// Create and start the threads
-	i = 0;
-	while (i < NUM_THREADS)
-	{
-		thread_data[i].fractal = fractal;
-		thread_data[i].start_row = i * rows_per_thread;
-		thread_data[i].end_row = (i == NUM_THREADS - 1) ? HEIGHT : (i + 1) * rows_per_thread;
-		
-		if (pthread_create(&threads[i], NULL, thread_render, &thread_data[i]) != 0)
-		{
-			// If thread creation fails, fallback to single-threaded rendering
-			i = 0;
-			while (i < HEIGHT)
-			{
-				render_pixel_row(i, fractal, (t_complex){0, 0});
-				i++;
-			}
-			draw_image_to_window(fractal);
-			return;
-		}
-		i++;
-	}
-
-	// Wait for all threads to complete
-	i = 0;
-	while (i < NUM_THREADS)
-	{
-		pthread_join(threads[i], NULL);
-		i++;
-	}
-	
 	// Update the window with the rendered image
 	draw_image_to_window(fractal);
 }
@@ -130,6 +80,7 @@ void	fractal_render_hybrid(t_fractal *fractal)
 	int	x;
 	int	y;
 
+	deep_prepare(fractal);
 	// First, do a quick low-resolution preview
 	step = 8; // Start with very low resolution
 	y = 0;
@@ -155,6 +106,7 @@ void	fractal_render_single_thread(t_fractal *fractal)
 {
 	int	i;
 
+	deep_prepare(fractal);
 	// Render each row in a single thread
 	i = 0;
 	while (i < HEIGHT)
@@ -188,9 +140,15 @@ void	fractal_render(t_fractal *fractal)
 		return; // Exit early to prevent any 2D rendering
 	}
 	
-	// 2D fractal rendering
-	// Use single-threaded rendering for 2D fractals
-	fractal_render_single_thread(fractal);
+	// 2D fractal rendering, in the mode picked with 'b'
+	if (fractal->render_mode == RENDER_MARIANI)
+		fractal_render_mariani(fractal);
+	else if (fractal->render_mode == RENDER_HYBRID)
+		fractal_render_hybrid(fractal);
+	else if (fractal->render_mode == RENDER_THREADED)
+		fractal_render_multithreaded(fractal);
+	else
+		fractal_render_single_thread(fractal);
 	
 	// Draw the image to window
 	draw_image_to_window(fractal);
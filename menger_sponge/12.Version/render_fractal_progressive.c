@@ -18,6 +18,7 @@ void	fractal_render_progressive(t_fractal *fractal)
 	int	x;
 	int	y;
 
+	deep_prepare(fractal);
 	step = 4;
 	while (step > 0)
 	{
@@ -12,26 +12,17 @@
 
 #include "fractol.h"
 
-void	*thread_render(void *arg)
+//Tile callback for fractal_render_multithreaded
+void	render_fractal_tile(void *ctx, int x0, int y0, int x1, int y1)
 {
-	t_thread_data	*data;
-	t_complex		complex;
-	int				y;
+	t_fractal	*fractal;
+	int			y;
 
-	data = (t_thread_data *)arg;
-	complex.x = 0.0;
-	complex.y = 0.0;
-	
-	if (data->start_row < 0)
-		data->start_row = 0;
-	if (data->end_row > HEIGHT)
-		data->end_row = HEIGHT;
-		
-	y = data->start_row;
-	while (y < data->end_row)
+	fractal = (t_fractal *)ctx;
+	y = y0;
+	while (y < y1)
 	{
-		render_pixel_row(y, data->fractal, complex);
+		handle_pixel_span(y, x0, x1, fractal);
 		y++;
 	}
-	return (NULL);
 }
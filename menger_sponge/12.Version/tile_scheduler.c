@@ -0,0 +1,242 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   tile_scheduler.c                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: asplavni <asplavni@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by asplavni          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by asplavni         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include <string.h>
+#include <time.h>
+
+typedef struct s_tile_worker
+{
+	t_tile_job	*job;
+	int			id;
+}	t_tile_worker;
+
+static double	clock_ms(clockid_t clock)
+{
+	struct timespec	ts;
+
+	clock_gettime(clock, &ts);
+	return (ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0);
+}
+
+//Render threads: one per online core
+int	render_thread_count(void)
+{
+	long	cores;
+
+	cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cores < 1)
+		return (1);
+	if (cores > MAX_RENDER_THREADS)
+		return (MAX_RENDER_THREADS);
+	return ((int)cores);
+}
+
+//Tile sides are TILE_SIZE rounded up to the sample grid of the renderer, so
+//a tile never splits a packet or a res x res block. The job runs on the
+//pool if one is set, otherwise on `threads` threads started for it.
+void	tile_job_init(t_tile_job *job, t_tile_fn render, void *ctx,
+			int align_x, int align_y)
+{
+	job->render = render;
+	job->ctx = ctx;
+	job->tile_w = (TILE_SIZE + align_x - 1) / align_x * align_x;
+	job->tile_h = (TILE_SIZE + align_y - 1) / align_y * align_y;
+	job->threads = render_thread_count();
+	job->pool = NULL;
+}
+
+static int	tile_end(int end, int limit)
+{
+	if (end > limit)
+		return (limit);
+	return (end);
+}
+
+//Takes tiles off the shared counter until there are none left
+static void	run_tiles(t_tile_job *job, int id)
+{
+	int		tile;
+	int		x;
+	int		y;
+	double	start;
+
+	start = clock_ms(CLOCK_THREAD_CPUTIME_ID);
+	while (1)
+	{
+		tile = atomic_fetch_add(&job->next, 1);
+		if (tile >= job->count)
+			break ;
+		x = (tile % job->cols) * job->tile_w;
+		y = (tile / job->cols) * job->tile_h;
+		job->render(job->ctx, x, y, tile_end(x + job->tile_w, WIDTH),
+			tile_end(y + job->tile_h, HEIGHT));
+		job->stats[id].tiles++;
+	}
+	job->stats[id].busy_ms = clock_ms(CLOCK_THREAD_CPUTIME_ID) - start;
+}
+
+static void	*tile_worker(void *arg)
+{
+	t_tile_worker	*worker;
+
+	worker = (t_tile_worker *)arg;
+	run_tiles(worker->job, worker->id);
+	return (NULL);
+}
+
+//Pool threads sleep on `wake` until the generation changes, run the job,
+//and the last one to finish signals `done`. Generation 0 is never a job, so
+//a worker that starts late still picks up the first one.
+static void	*pool_worker(void *arg)
+{
+	t_render_pool	*pool;
+	t_tile_job		*job;
+	unsigned int	seen;
+	int				id;
+
+	pool = (t_render_pool *)arg;
+	pthread_mutex_lock(&pool->lock);
+	id = ++pool->started;
+	seen = 0;
+	while (1)
+	{
+		while (!pool->stop && pool->generation == seen)
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		if (pool->stop)
+			break ;
+		seen = pool->generation;
+		job = pool->job;
+		pthread_mutex_unlock(&pool->lock);
+		run_tiles(job, id);
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->running == 0)
+			pthread_cond_signal(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return (NULL);
+}
+
+//Start threads - 1 workers, the thread running the jobs being the last
+//one. Workers that fail to start just leave a smaller pool.
+void	render_pool_init(t_render_pool *pool, int threads)
+{
+	pool->workers = 0;
+	pool->started = 0;
+	pool->running = 0;
+	pool->generation = 0;
+	pool->stop = 0;
+	pool->job = NULL;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	if (threads > MAX_RENDER_THREADS)
+		threads = MAX_RENDER_THREADS;
+	while (pool->workers < threads - 1 && pthread_create(
+			&pool->ids[pool->workers], NULL, pool_worker, pool) == 0)
+		pool->workers++;
+}
+
+void	render_pool_destroy(t_render_pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	while (pool->workers > 0)
+		pthread_join(pool->ids[--pool->workers], NULL);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->wake);
+	pthread_cond_destroy(&pool->done);
+}
+
+static void	run_on_pool(t_render_pool *pool, t_tile_job *job)
+{
+	job->threads = pool->workers + 1;
+	pthread_mutex_lock(&pool->lock);
+	pool->job = job;
+	pool->running = pool->workers;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	run_tiles(job, 0);
+	pthread_mutex_lock(&pool->lock);
+	while (pool->running > 0)
+		pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static void	run_on_new_threads(t_tile_job *job)
+{
+	pthread_t		ids[MAX_RENDER_THREADS];
+	t_tile_worker	workers[MAX_RENDER_THREADS];
+	int				started;
+
+	if (job->threads < 1)
+		job->threads = 1;
+	if (job->threads > MAX_RENDER_THREADS)
+		job->threads = MAX_RENDER_THREADS;
+	for (int i = 0; i < job->threads; i++)
+		workers[i] = (t_tile_worker){job, i};
+	started = 1;
+	while (started < job->threads && pthread_create(&ids[started], NULL,
+			tile_worker, &workers[started]) == 0)
+		started++;
+	run_tiles(job, 0);
+	for (int i = 1; i < started; i++)
+		pthread_join(ids[i], NULL);
+	job->threads = started;
+}
+
+//Render the whole screen, the caller taking tiles too. Idle time is the
+//render's wall time minus the thread's CPU time, so it also counts time
+//spent waiting for a core.
+void	run_tile_job(t_tile_job *job)
+{
+	double	t0;
+
+	job->cols = (WIDTH + job->tile_w - 1) / job->tile_w;
+	job->count = job->cols * ((HEIGHT + job->tile_h - 1) / job->tile_h);
+	atomic_init(&job->next, 0);
+	memset(job->stats, 0, sizeof(job->stats));
+	t0 = clock_ms(CLOCK_MONOTONIC);
+	if (job->pool)
+		run_on_pool(job->pool, job);
+	else
+		run_on_new_threads(job);
+	job->wall_ms = clock_ms(CLOCK_MONOTONIC) - t0;
+	for (int i = 0; i < job->threads; i++)
+		job->stats[i].idle_ms = fmax(job->wall_ms - job->stats[i].busy_ms, 0);
+}
+
+//Busy/idle per thread, and the slowest thread's busy time over the mean
+//(1.00 is a perfect split)
+void	print_tile_stats(const t_tile_job *job, const char *name)
+{
+	double	total;
+	double	worst;
+
+	total = 0;
+	worst = 0;
+	printf("%s: %d tiles of %dx%d on %d threads, %.1fms\n", name, job->count,
+		job->tile_w, job->tile_h, job->threads, job->wall_ms);
+	for (int i = 0; i < job->threads; i++)
+	{
+		printf("  thread %2d: %5d tiles, busy %8.1fms, idle %8.1fms\n", i,
+			job->stats[i].tiles, job->stats[i].busy_ms, job->stats[i].idle_ms);
+		total += job->stats[i].busy_ms;
+		worst = fmax(worst, job->stats[i].busy_ms);
+	}
+	if (total > 0)
+		printf("  imbalance (max / mean busy): %.2f\n",
+			worst * job->threads / total);
+}
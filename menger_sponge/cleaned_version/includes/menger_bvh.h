@@ -0,0 +1,192 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   menger_bvh.h                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef MENGER_BVH_H
+# define MENGER_BVH_H
+
+# include "miniRT.h"
+
+/*
+ * Internals shared by the flat BVH and the implicit Menger traversal
+ */
+
+//Sub-cube grid positions kept by the hole rule, in build order
+void	menger_sub_cells(int cells[MENGER_CHILDREN][3]);
+//Bounds of the 20 sub-cubes of a cell, same arithmetic for every backend
+void	menger_sub_bounds(t_aabb bounds, int cells[MENGER_CHILDREN][3],
+			t_aabb *sub);
+
+//Flat BVH queries that also count box tests, for the benchmarks
+int		ray_intersect_bvh_counted(const t_flat_bvh *bvh, t_vec3 ray_origin,
+			t_vec3 ray_dir, double *t_min, double *t_max, long *visits);
+int		ray_occluded_bvh_counted(const t_flat_bvh *bvh, t_vec3 ray_origin,
+			t_vec3 ray_dir, long *visits);
+
+//Traversal stack entry: a node and the ray's entry distance into its box
+typedef struct s_bvh_entry
+{
+	uint32_t	node;
+	float		t_near;
+}	t_bvh_entry;
+
+//MENGER_SIMD_LANES floats per register, used by the packet and wide BVH
+//kernels: one lane per ray or one lane per child box
+# if HAS_AVX2
+typedef __m256	t_lanes;
+#  define LANES_SET1 _mm256_set1_ps
+#  define LANES_ZERO _mm256_setzero_ps
+#  define LANES_LOAD _mm256_loadu_ps
+#  define LANES_STORE _mm256_storeu_ps
+#  define LANES_SUB _mm256_sub_ps
+#  define LANES_MUL _mm256_mul_ps
+#  define LANES_MIN _mm256_min_ps
+#  define LANES_MAX _mm256_max_ps
+#  define LANES_AND _mm256_and_ps
+#  define LANES_LE(a, b) _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+#  define LANES_LT(a, b) _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#  define LANES_MASK _mm256_movemask_ps
+# elif HAS_SSE
+typedef __m128	t_lanes;
+#  define LANES_SET1 _mm_set1_ps
+#  define LANES_ZERO _mm_setzero_ps
+#  define LANES_LOAD _mm_loadu_ps
+#  define LANES_STORE _mm_storeu_ps
+#  define LANES_SUB _mm_sub_ps
+#  define LANES_MUL _mm_mul_ps
+#  define LANES_MIN _mm_min_ps
+#  define LANES_MAX _mm_max_ps
+#  define LANES_AND _mm_and_ps
+#  define LANES_LE _mm_cmple_ps
+#  define LANES_LT _mm_cmplt_ps
+#  define LANES_MASK _mm_movemask_ps
+# endif
+
+# if HAS_SSE
+
+static inline int	menger_slab_core(__m128 min, __m128 max,
+						const t_aabb_ray *ray, double *t_min, double *t_max)
+{
+	const __m128	o = _mm_loadu_ps(ray->origin);
+	const __m128	inv = _mm_loadu_ps(ray->inv_dir);
+	__m128			t1;
+	__m128			t2;
+	__m128			tn;
+	__m128			tf;
+
+	t1 = _mm_mul_ps(_mm_sub_ps(min, o), inv);
+	t2 = _mm_mul_ps(_mm_sub_ps(max, o), inv);
+	tn = _mm_min_ps(t1, t2);
+	tf = _mm_max_ps(t1, t2);
+	tn = _mm_max_ss(_mm_max_ss(tn, _mm_shuffle_ps(tn, tn, 0x55)),
+			_mm_shuffle_ps(tn, tn, 0xAA));
+	tf = _mm_min_ss(_mm_min_ss(tf, _mm_shuffle_ps(tf, tf, 0x55)),
+			_mm_shuffle_ps(tf, tf, 0xAA));
+	*t_min = _mm_cvtss_f32(tn);
+	*t_max = _mm_cvtss_f32(tf);
+	return (*t_min <= *t_max && *t_max >= 0);
+}
+
+# else
+
+static inline int	menger_slab_core(const float *min, const float *max,
+						const t_aabb_ray *ray, double *t_min, double *t_max)
+{
+	float	t1;
+	float	t2;
+
+	*t_min = -INFINITY;
+	*t_max = INFINITY;
+	for (int k = 0; k < 3; k++)
+	{
+		t1 = (min[k] - ray->origin[k]) * ray->inv_dir[k];
+		t2 = (max[k] - ray->origin[k]) * ray->inv_dir[k];
+		*t_min = fmax(*t_min, fminf(t1, t2));
+		*t_max = fmin(*t_max, fmaxf(t1, t2));
+	}
+	return (*t_min <= *t_max && *t_max >= 0);
+}
+
+# endif
+
+//Slab test on float bounds against a prepared ray. min and max must each
+//be readable as 4 floats; lane 3 is loaded but never used. Parallel axes
+//carry a huge inverse (see aabb_ray_prepare), which reproduces the
+//epsilon rule of ray_intersect_aabb_scalar without a branch.
+static inline int	menger_slab_test(const float *min, const float *max,
+						const t_aabb_ray *ray, double *t_min, double *t_max)
+{
+# if HAS_SSE
+	return (menger_slab_core(_mm_loadu_ps(min), _mm_loadu_ps(max), ray,
+			t_min, t_max));
+# else
+	return (menger_slab_core(min, max, ray, t_min, t_max));
+# endif
+}
+
+//Same test on double bounds, rounded to float like the flat BVH stores them
+static inline int	menger_slab_test_aabb(const t_aabb *bounds,
+						const t_aabb_ray *ray, double *t_min, double *t_max)
+{
+# if HAS_SSE
+	const __m128	min = _mm_movelh_ps(
+			_mm_cvtpd_ps(_mm_loadu_pd(&bounds->min.x)),
+			_mm_cvtpd_ps(_mm_load_sd(&bounds->min.z)));
+	const __m128	max = _mm_movelh_ps(
+			_mm_cvtpd_ps(_mm_loadu_pd(&bounds->max.x)),
+			_mm_cvtpd_ps(_mm_load_sd(&bounds->max.z)));
+
+	return (menger_slab_core(min, max, ray, t_min, t_max));
+# else
+	const float	min[3] = {bounds->min.x, bounds->min.y, bounds->min.z};
+	const float	max[3] = {bounds->max.x, bounds->max.y, bounds->max.z};
+
+	return (menger_slab_core(min, max, ray, t_min, t_max));
+# endif
+}
+
+# if HAS_AVX2
+
+//Two boxes in one 8-wide pass (used for the two children of a BVH node).
+//Fills t[0..1] for box a, t[2..3] for box b, returns a bit per hit box.
+static inline int	menger_slab_test2(const float *min_a, const float *max_a,
+						const float *min_b, const float *max_b,
+						const t_aabb_ray *ray, double t[4])
+{
+	const __m256	o = _mm256_broadcast_ps((const __m128 *)ray->origin);
+	const __m256	inv = _mm256_broadcast_ps((const __m128 *)ray->inv_dir);
+	__m256			t1;
+	__m256			t2;
+	__m256			tn;
+	__m256			tf;
+
+	t1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(min_a)),
+			_mm_loadu_ps(min_b), 1);
+	t2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(max_a)),
+			_mm_loadu_ps(max_b), 1);
+	t1 = _mm256_mul_ps(_mm256_sub_ps(t1, o), inv);
+	t2 = _mm256_mul_ps(_mm256_sub_ps(t2, o), inv);
+	tn = _mm256_min_ps(t1, t2);
+	tf = _mm256_max_ps(t1, t2);
+	tn = _mm256_max_ps(_mm256_max_ps(tn, _mm256_shuffle_ps(tn, tn, 0x55)),
+			_mm256_shuffle_ps(tn, tn, 0xAA));
+	tf = _mm256_min_ps(_mm256_min_ps(tf, _mm256_shuffle_ps(tf, tf, 0x55)),
+			_mm256_shuffle_ps(tf, tf, 0xAA));
+	t[0] = _mm256_cvtss_f32(tn);
+	t[1] = _mm256_cvtss_f32(tf);
+	t[2] = _mm_cvtss_f32(_mm256_extractf128_ps(tn, 1));
+	t[3] = _mm_cvtss_f32(_mm256_extractf128_ps(tf, 1));
+	return ((t[0] <= t[1] && t[1] >= 0) | (t[2] <= t[3] && t[3] >= 0) << 1);
+}
+
+# endif
+
+#endif
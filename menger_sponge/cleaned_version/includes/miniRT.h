@@ -19,12 +19,13 @@
 # include <math.h>
 # include <pthread.h>
 # include <ctype.h>
+# include <stdint.h>
+# include <stdatomic.h>
 # include "platform_specifics.h"
 
 
 # define WIDTH	1280
 # define HEIGHT	1024
-# define NUM_THREADS 8  // Number of threads for multithreaded rendering
 
 // 3D rendering constants
 # define FOV 60.0
@@ -32,6 +33,44 @@
 # define FAR_PLANE 100.0
 # define MAX_BVH_DEPTH 8
 # define MAX_BVH_NODES 1000
+# define MENGER_CHILDREN 20 // Sub-cubes kept per Menger cell (27 - 7 holes)
+# define MENGER_MAX_BVH_ITERATIONS 10
+# define MENGER_MAX_IMPLICIT_ITERATIONS 12
+# define MENGER_SNAP_ITERATIONS 6 // Deepest level where face snapping is used
+# define MENGER_PARALLEL_BUILD 4 // Below this level threads cost more than the build
+# define MENGER_STACK_SIZE 64 // Traversal stack, BVH depth is 5 * iterations + 1
+
+// Rays per packet: one SIMD lane each, traced as a 4x2 or 2x2 pixel tile
+# if HAS_AVX2
+#  define MENGER_SIMD_LANES 8
+#  define MENGER_PACKET_W 4
+# else
+#  define MENGER_SIMD_LANES 4
+#  define MENGER_PACKET_W 2
+# endif
+# define MENGER_PACKET_SIZE MENGER_SIMD_LANES
+# define MENGER_PACKET_H 2
+// Wide BVH: one child box per SIMD lane
+# define MENGER_WIDE_WIDTH MENGER_SIMD_LANES
+# define MENGER_WIDE_STACK_SIZE 128
+# define MENGER_WIDE_LEAF 0x80000000u // child slot holding a sponge cube
+# define MENGER_WIDE_MIN_ITERATIONS 4 // Shallower, the binary BVH is as fast
+# define ARENA_DEFAULT_BLOCK 65536 // Bytes per arena block
+# define TILE_SIZE 32 // Side of a render tile in pixels, before alignment
+# define MAX_RENDER_THREADS 64
+# define SCENE_BVH_BINS 16 // SAH buckets per axis
+# define SCENE_BVH_MAX_LEAF 4 // Objects per leaf before splitting is forced
+# define SCENE_BVH_TRAVERSAL_COST 1.0 // Box test cost, in object tests
+# define SCENE_BVH_MAX_DEPTH 64
+# define SCENE_BVH_PAD 1e-4 // Slack around node boxes for the float test
+# define SCENE_SOA_LANES 4 // Objects per SIMD kernel call, one AVX2 register
+# define SCENE_FLOAT_EPS 0.005f // Self-hit threshold and shadow offset in float
+# define SPHERE_FIELD_COUNT 10000 // Spheres in the "spheres" scene
+# define PREVIEW_STEP 16 // Sample spacing of the first progressive pass
+# define ADAPTIVE_TARGET_MS 33.0 // Frame budget while the view is moving
+# define ADAPTIVE_IDLE_MS 150.0 // Input quiet this long: full passes
+# define ADAPTIVE_START_STEP 4 // Spacing of the first moving frame
+# define ADAPTIVE_MAX_STEP 16
 
 # define BLACK       0x000000  // RGB(0, 0, 0)
 # define WHITE       0xFFFFFF  // RGB(255, 255, 255)
@@ -90,6 +129,26 @@ typedef struct	s_light
 	struct s_light *next; //pointer to next light (bonuses)
 }	t_light;
 
+//Arena block header, the allocations follow it in the same malloc
+typedef struct s_arena_block
+{
+	struct s_arena_block	*next;
+	size_t					size; //usable bytes
+	size_t					used;
+}	t_arena_block;
+
+//Bump allocator: many small objects, freed all together. A zeroed arena is
+//ready to use with the default block size.
+typedef struct s_arena
+{
+	t_arena_block	*head; //block being filled, full ones behind it
+	size_t			block_size;
+	size_t			allocations;
+	size_t			requested; //bytes asked for, before alignment
+	size_t			reserved; //bytes malloc'd for blocks
+	size_t			blocks;
+}	t_arena;
+
 typedef struct s_aabb
 {
 	t_vec3	min;
@@ -105,6 +164,69 @@ typedef struct s_bvh_node
 	int					iteration;
 }				t_bvh_node;
 
+//Ray prepared once for many box tests: the inverse direction is computed
+//per ray instead of per node (lane 3 is padding for the SIMD kernels)
+typedef struct s_aabb_ray
+{
+	float	origin[4];
+	float	inv_dir[4];
+}				t_aabb_ray;
+
+//Flattened BVH node, stored depth-first: the left child of node i is
+//always node i + 1, so only the right child needs an offset (32 bytes)
+typedef struct s_flat_bvh_node
+{
+	float		min[3];
+	float		max[3];
+	uint32_t	right_offset; //right child index minus this node's index
+	uint16_t	is_leaf;
+	uint16_t	iteration;
+}				t_flat_bvh_node;
+
+//Coherent rays traced through the flat BVH together, one SIMD lane per ray
+//(SoA). The ranges drive the interval test that rejects a box for the whole
+//packet at once; it is only valid when all live rays share direction signs.
+typedef struct s_ray_packet
+{
+	float	origin[3][MENGER_PACKET_SIZE];
+	float	inv_dir[3][MENGER_PACKET_SIZE];
+	float	origin_lo[3];
+	float	origin_hi[3];
+	float	inv_lo[3];
+	float	inv_hi[3];
+	float	mean_dir[3]; //child visit order
+	int		active; //bit per live lane
+	int		coherent;
+}				t_ray_packet;
+
+//Whole flat BVH, header and nodes live in a single allocation
+typedef struct s_flat_bvh
+{
+	t_flat_bvh_node	*nodes;
+	uint32_t		count;
+	uint32_t		capacity; //nodes allocated, kept across prune/refine
+	int				iterations;
+}				t_flat_bvh;
+
+//Wide BVH node: the child boxes sit in SoA so one ray tests all of them in
+//a single SIMD pass. Collapsed from the flat binary BVH.
+typedef struct s_wide_bvh_node
+{
+	float		min[3][MENGER_WIDE_WIDTH];
+	float		max[3][MENGER_WIDE_WIDTH];
+	uint32_t	child[MENGER_WIDE_WIDTH]; //node index or MENGER_WIDE_LEAF
+	uint32_t	count; //used slots, the rest is padding
+}				t_wide_bvh_node;
+
+//Whole wide BVH, header and nodes in a single allocation like t_flat_bvh
+typedef struct s_wide_bvh
+{
+	t_wide_bvh_node	*nodes;
+	uint32_t		count;
+	int				iterations;
+	int				depth;
+}				t_wide_bvh;
+
 typedef struct s_camera
 {
 	t_vec3	position;
@@ -115,6 +237,11 @@ typedef struct s_camera
 	t_vec3	forwards; //forward vector
 	t_vec3	right; //right vector
 	t_vec3	up; //up vector
+	//Pixel grid from camera_setup: pixel (x, y) looks along
+	//ray_corner + x * ray_dx + y * ray_dy
+	t_vec3	ray_corner;
+	t_vec3	ray_dx;
+	t_vec3	ray_dy;
 
 	double	aspect_ratio; //Initialized but not used yet
 	double	near; //Initialized but not used yet
@@ -178,6 +305,47 @@ typedef struct	s_hit_record
 	int			inside; //Flag indicating if the ray is inside the object
 }	t_hit_record;
 
+//Scene BVH over the bounded objects (spheres, cylinders), flattened
+//depth-first: the left child of a node is the next node. Leaves hold
+//`count` objects from objects[first]; planes can't be bounded and are
+//kept in their own list.
+typedef struct s_scene_bvh_node
+{
+	float	min[3]; //float box, rounded outward (32 bytes a node)
+	float	max[3];
+	int		right; //index of the right child, interior nodes only
+	int		first;
+	int		count; //0 for interior nodes
+	int		spheres; //leaf objects are sorted spheres first
+}	t_scene_bvh_node;
+
+//Sphere centers and radii, plane points and normals as structure of
+//arrays for the SIMD kernels (sphere_hits4, plane_hits4), with float
+//copies for the single precision ones (sphere_hits4f, plane_hits4f)
+typedef struct s_scene_soa
+{
+	double	*data; //one block for all the arrays
+	double	*sphere[4]; //x, y, z, radius, indexed like bvh->objects
+	double	*plane[6]; //point x, y, z, normal x, y, z
+	float	*data_f; //same layout in float
+	float	*sphere_f[4];
+	float	*plane_f[6];
+	int		plane_count; //PLANE objects at the front of bvh->planes
+}	t_scene_soa;
+
+typedef struct s_scene_bvh
+{
+	int					built; //0: find_closest_intersection walks the list
+	t_scene_bvh_node	*nodes;
+	int					node_count;
+	t_object			**objects; //bounded objects in leaf order
+	int					object_count;
+	t_object			**planes;
+	int					plane_count;
+	t_scene_soa			soa;
+	int					single; //float sphere/plane kernels, toggled with 'p'
+}	t_scene_bvh;
+
 typedef struct s_img
 {
 	void	*img_ptr;
@@ -187,13 +355,24 @@ typedef struct s_img
 	int		line_len;
 }				t_img;
 
+//How the renderer finds hits on the sponge
+typedef enum e_menger_mode
+{
+	MENGER_MODE_BVH, //prebuilt flat BVH, 20^n leaves in memory
+	MENGER_MODE_WIDE, //flat BVH collapsed to 4/8 children per node
+	MENGER_MODE_IMPLICIT, //subdivision walked per ray, no BVH memory
+	MENGER_MODE_COUNT,
+}	t_menger_mode;
+
 typedef struct s_menger
 {
 	int			iterations;
+	t_menger_mode	mode;
 	double		size;
 	t_vec3		position;
 	t_vec3		rotation;
-	t_bvh_node	*bvh_root;
+	t_flat_bvh	*bvh;
+	t_wide_bvh	*wide; //only built in MENGER_MODE_WIDE
 }				t_menger;
 
 typedef struct s_bounds
@@ -204,6 +383,99 @@ typedef struct s_bounds
 	double	old_max;
 }	t_bounds;
 
+//Renders the pixels [x0, x1) x [y0, y1) of one tile
+typedef void	(*t_tile_fn)(void *ctx, int x0, int y0, int x1, int y1);
+
+//One thread's share of a tiled render
+typedef struct s_tile_stats
+{
+	double	busy_ms; //CPU time spent on tiles
+	double	idle_ms; //render wall time minus busy time
+	int		tiles;
+}	t_tile_stats;
+
+//Render threads kept for the whole run, parked on a condition variable
+//between frames. The thread that submits a job works on it too.
+typedef struct s_render_pool
+{
+	pthread_t		ids[MAX_RENDER_THREADS];
+	int				workers;
+	int				started;
+	int				running; //workers still on the current job
+	unsigned int	generation; //bumped for every job
+	int				stop;
+	struct s_tile_job	*job;
+	pthread_mutex_t	lock;
+	pthread_cond_t	wake;
+	pthread_cond_t	done;
+}	t_render_pool;
+
+//Screen cut into tiles handed out through one atomic counter, so threads
+//that drew cheap tiles take more instead of waiting on the slowest one
+typedef struct s_tile_job
+{
+	t_tile_fn		render;
+	void			*ctx;
+	int				tile_w;
+	int				tile_h;
+	int				threads;
+	t_render_pool	*pool; //NULL: start threads for this job only
+	atomic_uint		*cancel; //tiles stop once it differs from generation
+	unsigned int	generation;
+	int				cols;
+	int				count;
+	atomic_int		next;
+	double			wall_ms;
+	t_tile_stats	stats[MAX_RENDER_THREADS];
+}	t_tile_job;
+
+//What a frame request draws. start_raytracer sets up the object scene
+//whatever the name, so the caller says which renderer it means.
+typedef enum e_frame_kind
+{
+	FRAME_MENGER,
+	FRAME_SCENE,
+}	t_frame_kind;
+
+//Frames rendered off the mlx thread into a back image. Each request
+//bumps `requested`; a frame whose generation is no longer the newest stops
+//between tiles, so only the latest view gets finished and shown. Passes
+//before the last are shown from `preview` while back keeps refining.
+typedef struct s_async_render
+{
+	pthread_t		thread;
+	int				running;
+	int				stop;
+	int				busy; //frame thread is drawing into back
+	unsigned int	taken; //newest generation picked up (or dropped)
+	unsigned int	ready; //finished generation waiting in back, 0: none
+	unsigned int	preview_ready; //generation of the pass in preview, 0: none
+	atomic_uint		requested;
+	struct s_scene	*pending; //scene state of the newest request
+	t_frame_kind	pending_kind; //and what it asked for
+	struct s_scene	*frame; //copy the frame thread renders from
+	int				moved_step; //moving frame measured, for adaptive_record
+	double			moved_ms;
+	t_img			back;
+	t_img			preview; //copy of the last finished pass
+	pthread_mutex_t	lock;
+	pthread_cond_t	wake;
+	pthread_cond_t	idle;
+}	t_async_render;
+
+//Frame budget while the view moves: each moving frame is one pass at
+//`step`, picked from the measured cost of the ones before so it fits in
+//ADAPTIVE_TARGET_MS. When the input stops, the loop hook asks for the
+//normal coarse-to-fine passes.
+typedef struct s_adaptive
+{
+	int		enabled; //toggled with 'v'
+	int		moving; //input came within ADAPTIVE_IDLE_MS, full passes owed
+	int		step; //sample spacing of the next moving frame
+	double	full_ms; //smoothed estimate of a frame at spacing 1
+	double	last_input; //get_time_ms of the latest input
+}	t_adaptive;
+
 typedef struct s_scene
 {
 	char		*name; //input file name
@@ -218,6 +490,12 @@ typedef struct s_scene
 	t_camera	camera;
 	t_light		*lights; //Linked list of lights
 	t_object	*objects; //Linked list of objects
+	t_arena		arena; //Owns lights, objects and their data
+	t_scene_bvh	bvh; //Over `objects`, rebuilt by scene_bvh_build
+	t_render_pool	pool; //Render threads, started in scene_init
+	t_async_render	async; //Frames off the event thread
+	int			refine; //without it: spacing of the next object scene pass, 0: done
+	t_adaptive	adaptive;
 
 	//for bonuses
 	int 		sample; //for anti-aliasing
@@ -240,6 +518,10 @@ typedef struct s_scene
 	int			resolution_factor;  // For controlling render resolution
 }				t_scene;
 
+//One coarse-to-fine pass of a scene at a sample spacing, like
+//render_menger_pass and render_scene_pass
+typedef void	(*t_pass_fn)(t_scene *, t_tile_job *, int, int);
+
 typedef struct s_thread_data
 {
 	int			start_row;
@@ -269,20 +551,98 @@ void		draw_image_to_window(t_scene *scene);
 int			ft_strncmp(char *s1, char *s2, int n);
 void		write_string_to_file_descriptor(char *str, int file_descriptor);
 
+//time utils
+double		get_time_ms(void);
+
+//tile scheduler
+int			render_thread_count(void);
+void		render_pool_init(t_render_pool *pool, int threads);
+void		render_pool_destroy(t_render_pool *pool);
+void		tile_job_init(t_tile_job *job, t_tile_fn render, void *ctx,
+				int align_x, int align_y);
+void		run_tile_job(t_tile_job *job);
+void		print_tile_stats(const t_tile_job *job, const char *name);
+
+//asynchronous rendering
+void		render_async_start(t_scene *scene);
+void		render_async_stop(t_scene *scene);
+void		render_async_request(t_scene *scene, t_frame_kind kind);
+void		render_async_wait(t_scene *scene);
+int			render_async_present(t_scene *scene);
+
+//adaptive resolution
+void		adaptive_init(t_adaptive *adaptive);
+void		adaptive_input(t_adaptive *adaptive);
+int			adaptive_step(const t_scene *scene);
+double		adaptive_frame_ms(const t_tile_job *job);
+void		adaptive_record(t_adaptive *adaptive, int step, double ms);
+int			render_loop_hook(t_scene *scene);
+
+//arena
+void		arena_init(t_arena *arena, size_t block_size);
+void		*arena_alloc(t_arena *arena, size_t size);
+void		arena_destroy(t_arena *arena);
+void		arena_print_stats(const t_arena *arena, const char *name);
+
+//benchmark
+int			run_benchmarks(int ac, char **av);
+
 // 3D rendering functions
 void		init_3d(t_scene *scene);
 void		render_menger_sponge(t_scene *scene);
+void		render_menger_frame(t_scene *scene, t_tile_job *job);
+void		render_menger_pass(t_scene *scene, t_tile_job *job, int step,
+				int reuse);
+int			menger_preview_step(t_scene *scene);
 t_vec3		rotate_point(t_vec3 point, t_vec3 rotation);
+void		camera_setup(t_camera *camera, int width, int height);
+t_vec3		camera_row(const t_camera *camera, double y);
+t_vec3		camera_ray_dir(const t_camera *camera, t_vec3 row, double x);
+t_vec3		reflect_ray(t_vec3 incident, t_vec3 normal);
+
+// BVH functions (flat layout, used by the renderer)
+t_flat_bvh	*build_menger_bvh(int max_iterations);
+t_flat_bvh	*build_menger_bvh_threads(int max_iterations, int threads);
+int			menger_build_threads(void);
+t_flat_bvh	*refine_menger_bvh(t_flat_bvh *bvh);
+t_flat_bvh	*prune_menger_bvh(t_flat_bvh *bvh);
+size_t		menger_bvh_node_count(int iterations);
+void		free_bvh(t_flat_bvh *bvh);
+int			ray_intersect_bvh(const t_flat_bvh *bvh, t_vec3 ray_origin,
+							t_vec3 ray_dir, double *t_min, double *t_max);
+int			ray_occluded_bvh(const t_flat_bvh *bvh, t_vec3 ray_origin,
+							t_vec3 ray_dir);
+
+void		ray_packet_prepare(t_ray_packet *packet, const t_vec3 *origins,
+							const t_vec3 *dirs, int active);
+int			ray_intersect_bvh_packet(const t_flat_bvh *bvh,
+							const t_ray_packet *packet, double *t_min,
+							double *t_max);
+
+t_wide_bvh	*build_menger_wide_bvh(const t_flat_bvh *bvh);
+void		free_wide_bvh(t_wide_bvh *wide);
+int			ray_intersect_wide_bvh(const t_wide_bvh *wide, t_vec3 ray_origin,
+							t_vec3 ray_dir, double *t_min, double *t_max);
+int			ray_occluded_wide_bvh(const t_wide_bvh *wide, t_vec3 ray_origin,
+							t_vec3 ray_dir);
 
-// BVH functions
-t_bvh_node	*build_menger_bvh(int max_iterations);
-void		free_bvh(t_bvh_node *node);
-int			ray_intersect_bvh(t_bvh_node *node, t_vec3 ray_origin,
+int			ray_intersect_menger_implicit(int iterations, t_vec3 ray_origin,
+							t_vec3 ray_dir, double *t_min, double *t_max);
+int			ray_occluded_menger_implicit(int iterations, t_vec3 ray_origin,
+							t_vec3 ray_dir);
+int			menger_max_iterations(t_scene *scene);
+void		menger_toggle_mode(t_scene *scene);
+int			menger_rebuild(t_scene *scene, int iterations);
+
+// Pointer BVH (reference layout for benchmarks)
+t_bvh_node	*build_menger_bvh_tree(t_arena *arena, int max_iterations);
+int			ray_intersect_bvh_tree(t_bvh_node *node, t_vec3 ray_origin,
 							t_vec3 ray_dir, double *t_min, double *t_max);
 int			ray_intersect_aabb_scalar(t_aabb bounds, t_vec3 ray_origin,
 							t_vec3 ray_dir, double *t_min, double *t_max);
 int			ray_intersect_aabb_simd(t_aabb bounds, t_vec3 origin,
 									t_vec3 dir, double *out_tmin, double *out_tmax);
+void		aabb_ray_prepare(t_aabb_ray *ray, t_vec3 origin, t_vec3 dir);
 
 //Vector utilities
 t_vec3		vec3_create(double x, double y, double z);
@@ -308,9 +668,12 @@ t_material	create_material(t_color color);
 
 //object creation
 void		add_object(t_scene *scene, t_object *object);
-t_object	*create_sphere(t_vec3 center, double diameter, t_color color);
-t_object	*create_cylinder(t_vec3 center, t_vec3 axis, double diameter, double height);
-t_object	*create_plane(t_vec3 point, t_vec3 normal, t_color color);
+t_object	*create_sphere(t_arena *arena, t_vec3 center, double diameter,
+				t_color color);
+t_object	*create_cylinder(t_arena *arena, t_vec3 center, t_vec3 axis,
+				double diameter, double height);
+t_object	*create_plane(t_arena *arena, t_vec3 point, t_vec3 normal,
+				t_color color);
 
 //object intersection
 int			ray_sphere_intersect(t_ray ray, t_sphere sphere, double *t);
@@ -322,13 +685,38 @@ int			ray_plane_intersect(t_ray ray, t_plane plane, double *t);
 
 //lights
 void		add_light(t_scene *scene, t_light *light);
-t_light		*create_light(t_vec3 position, double intensity, t_color color);
+t_light		*create_light(t_arena *arena, t_vec3 position, double intensity,
+				t_color color);
 
 //rendering test
 void		render_simple_scene(t_scene *scene);
 void		render_complex_scene(t_scene *scene);
+void		render_scene_pass(t_scene *scene, t_tile_job *job, int step,
+				int reuse);
+void		render_scene_refine(t_scene *scene);
+void		set_up_scene_plane(t_scene *scene);
+void		set_up_scene_spheres(t_scene *scene, int count);
 void		set_up_scene_two_sphere(t_scene *scene);
 
+//scene BVH
+int			scene_bvh_build(t_scene_bvh *bvh, t_object *objects);
+void		scene_bvh_free(t_scene_bvh *bvh);
+int			scene_bvh_closest(const t_scene_bvh *bvh, t_ray ray, double *t,
+				t_object **hit_object);
+int			scene_bvh_occluded(const t_scene_bvh *bvh, t_ray ray,
+				double max_t);
+int			intersect_object(t_object *object, t_ray ray, double *t);
+int			scene_soa_build(t_scene_bvh *bvh);
+void		scene_soa_free(t_scene_soa *soa);
+void		sphere_hits4(const t_scene_soa *soa, int i, t_ray ray,
+				double t[4]);
+void		plane_hits4(const t_scene_soa *soa, int i, t_ray ray,
+				double t[4]);
+void		sphere_hits4f(const t_scene_soa *soa, int i, t_ray ray,
+				double t[4]);
+void		plane_hits4f(const t_scene_soa *soa, int i, t_ray ray,
+				double t[4]);
+
 //shadows
 int			is_in_shadow(t_scene *scene, t_vec3 hit_point, t_vec3 light_dir, double light_distance);
 
@@ -87,4 +87,37 @@
 
 # endif
 
+/*
+ * SIMD support for the ray-AABB kernels
+ */
+
+# if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define HAS_NEON 1
+# else
+#  define HAS_NEON 0
+# endif
+
+// SSE2 is part of the x86_64 baseline, AVX2 needs `make SIMD=avx2`
+# if defined(__SSE2__)
+#  include <immintrin.h>
+#  define HAS_SSE 1
+# else
+#  define HAS_SSE 0
+# endif
+# if defined(__AVX2__)
+#  define HAS_AVX2 1
+# else
+#  define HAS_AVX2 0
+# endif
+
+// Only use SIMD on platforms where it's available. On x86 the per-call
+// kernel stays scalar: its early-outs beat SIMD once the three divisions
+// are paid per box, the gain comes from t_aabb_ray (inverse per ray).
+# if HAS_NEON
+#  define ray_intersect_aabb ray_intersect_aabb_simd
+# else
+#  define ray_intersect_aabb ray_intersect_aabb_scalar
+# endif
+
 #endif
@@ -0,0 +1,95 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   adaptive.c                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+
+void	adaptive_init(t_adaptive *adaptive)
+{
+	adaptive->enabled = 1;
+	adaptive->moving = 0;
+	adaptive->step = ADAPTIVE_START_STEP;
+	adaptive->full_ms = 0.0;
+	adaptive->last_input = 0.0;
+}
+
+//Input that changes the view: frames drawn from now on are moving frames
+//until ADAPTIVE_IDLE_MS pass without another call
+void	adaptive_input(t_adaptive *adaptive)
+{
+	if (!adaptive->enabled)
+		return ;
+	adaptive->moving = 1;
+	adaptive->last_input = get_time_ms();
+}
+
+//Sample spacing of the next frame, 0 if it should get the full passes.
+//Never finer than the resolution factor the full passes stop at.
+int	adaptive_step(const t_scene *scene)
+{
+	if (!scene->adaptive.enabled || !scene->adaptive.moving)
+		return (0);
+	if (scene->adaptive.step < scene->resolution_factor)
+		return (scene->resolution_factor);
+	return (scene->adaptive.step);
+}
+
+//Wall time of the whole pass, extrapolated from the tiles done when it
+//was cancelled halfway. 0 if no tile was drawn.
+double	adaptive_frame_ms(const t_tile_job *job)
+{
+	int	done;
+
+	done = 0;
+	for (int i = 0; i < job->threads; i++)
+		done += job->stats[i].tiles;
+	if (!done)
+		return (0.0);
+	return (job->wall_ms * job->count / done);
+}
+
+//Moving frame of spacing `step` took `ms`: its cost times step * step is
+//an estimate of a full frame, smoothed over the frames before. The next
+//step is the smallest spacing, power of two or not, that fits the budget.
+void	adaptive_record(t_adaptive *adaptive, int step, double ms)
+{
+	double	full;
+	int		next;
+
+	if (step <= 0 || ms <= 0.0)
+		return ;
+	full = ms * step * step;
+	if (adaptive->full_ms > 0.0)
+		full = 0.5 * (adaptive->full_ms + full);
+	adaptive->full_ms = full;
+	next = (int)ceil(sqrt(full / ADAPTIVE_TARGET_MS));
+	if (next < 1)
+		next = 1;
+	if (next > ADAPTIVE_MAX_STEP)
+		next = ADAPTIVE_MAX_STEP;
+	adaptive->step = next;
+}
+
+//mlx loop hook: once the input has stopped, the last moving frame is
+//replaced by the full passes. Then the async frames get presented.
+int	render_loop_hook(t_scene *scene)
+{
+	if (scene->adaptive.moving
+		&& get_time_ms() - scene->adaptive.last_input > ADAPTIVE_IDLE_MS)
+	{
+		scene->adaptive.moving = 0;
+		if (!ft_strncmp(scene->name, "menger", 6))
+			render_menger_sponge(scene);
+		else
+			render_complex_scene(scene);
+	}
+	return (render_async_present(scene));
+}
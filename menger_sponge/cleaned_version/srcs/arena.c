@@ -0,0 +1,118 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   arena.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+
+//Allocations are rounded up to this, enough for the doubles and pointers in
+//scene objects and BVH nodes
+#define ARENA_ALIGN 8
+
+static size_t	align_up(size_t size)
+{
+	return ((size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1));
+}
+
+void	arena_init(t_arena *arena, size_t block_size)
+{
+	arena->head = NULL;
+	arena->block_size = block_size;
+	if (arena->block_size == 0)
+		arena->block_size = ARENA_DEFAULT_BLOCK;
+	arena->allocations = 0;
+	arena->requested = 0;
+	arena->reserved = 0;
+	arena->blocks = 0;
+}
+
+//Oversized requests get their own block, slotted behind the current one so
+//small allocations keep filling it
+static t_arena_block	*arena_new_block(t_arena *arena, size_t size)
+{
+	t_arena_block	*block;
+	size_t			data;
+
+	data = arena->block_size;
+	if (size > data)
+		data = size;
+	block = malloc(align_up(sizeof(t_arena_block)) + data);
+	if (!block)
+		return (NULL);
+	block->size = data;
+	block->used = 0;
+	arena->reserved += data;
+	arena->blocks++;
+	if (arena->head && size > arena->block_size)
+	{
+		block->next = arena->head->next;
+		arena->head->next = block;
+	}
+	else
+	{
+		block->next = arena->head;
+		arena->head = block;
+	}
+	return (block);
+}
+
+//Bump allocation from the current block. Memory is only given back all at
+//once by arena_destroy.
+void	*arena_alloc(t_arena *arena, size_t size)
+{
+	t_arena_block	*block;
+	void			*ptr;
+	size_t			aligned;
+
+	if (arena->block_size == 0)
+		arena_init(arena, 0);
+	aligned = align_up(size);
+	block = arena->head;
+	if (!block || block->size - block->used < aligned)
+		block = arena_new_block(arena, aligned);
+	if (!block)
+		return (NULL);
+	ptr = (char *)block + align_up(sizeof(t_arena_block)) + block->used;
+	block->used += aligned;
+	arena->allocations++;
+	arena->requested += size;
+	return (ptr);
+}
+
+//One free per block, whatever the number of objects allocated
+void	arena_destroy(t_arena *arena)
+{
+	t_arena_block	*next;
+
+	while (arena->head)
+	{
+		next = arena->head->next;
+		free(arena->head);
+		arena->head = next;
+	}
+	arena_init(arena, arena->block_size);
+}
+
+//Fragmentation is the share of reserved bytes not asked for: alignment
+//padding, block tails left when a request didn't fit, and the unused end of
+//the current block
+void	arena_print_stats(const t_arena *arena, const char *name)
+{
+	double	fragmentation;
+
+	fragmentation = 0.0;
+	if (arena->reserved)
+		fragmentation = 100.0 * (arena->reserved - arena->requested)
+			/ arena->reserved;
+	printf("arena %s: %zu allocations, %zu blocks, %.1f KiB used of "
+		"%.1f KiB reserved (%.1f%% fragmentation)\n", name,
+		arena->allocations, arena->blocks, arena->requested / 1024.0,
+		arena->reserved / 1024.0, fragmentation);
+}
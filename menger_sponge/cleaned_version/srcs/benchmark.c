@@ -0,0 +1,1372 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   benchmark.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include <string.h>
+#include "menger_bvh.h"
+
+#define PRECISION_TOLERANCE 8 // Channel levels the float path may be off by
+#define PRECISION_MAX_OVER 0.5 // Percent of pixels allowed past the tolerance
+
+//Headless benchmarks, run with: ./minirt bench <name> [args]
+//No window is opened, so these can run on render boxes without a display.
+
+typedef struct s_ray_batch
+{
+	t_vec3	origin;
+	t_vec3	*dirs;
+	int		count;
+	int		cols; //rays are stored row by row, cols x rows
+	int		rows;
+}	t_ray_batch;
+
+//Primary rays of the top view camera from init_3d, generated exactly like
+//render_menger_thread does, one ray every `step` pixels. The pitch is +1.57
+//(as on key 3) so the rays look down onto the sponge.
+static int	make_top_view_rays(t_ray_batch *batch, int step)
+{
+	t_camera	camera;
+	t_vec3		row;
+
+	camera.position = (t_vec3){0.0, 3.0, 0.0};
+	camera.rotation = (t_vec3){1.57, 0.0, 0.0};
+	camera.fov = 80.0;
+	camera_setup(&camera, WIDTH, HEIGHT);
+	batch->origin = camera.position;
+	batch->count = 0;
+	batch->cols = (WIDTH + step - 1) / step;
+	batch->rows = (HEIGHT + step - 1) / step;
+	batch->dirs = malloc(sizeof(t_vec3) * batch->cols * batch->rows);
+	if (!batch->dirs)
+		return (0);
+	for (int y = 0; y < HEIGHT; y += step)
+	{
+		row = camera_row(&camera, y);
+		for (int x = 0; x < WIDTH; x += step)
+			batch->dirs[batch->count++] = camera_ray_dir(&camera, row, x);
+	}
+	return (1);
+}
+
+//Flat BVH vs pointer BVH, closest hit on the top view, iterations 1..max
+static int	bench_bvh(int max_iterations, int step)
+{
+	t_ray_batch	rays;
+	t_arena		arena;
+	t_bvh_node	*tree;
+	t_flat_bvh	*flat;
+	double		t0, t_build_tree, t_build_flat, t_tree, t_flat;
+	double		t_min, t_max;
+	int			hits_tree, hits_flat;
+
+	if (!make_top_view_rays(&rays, step))
+		return (1);
+	printf("BVH layout benchmark: %d rays per frame (top view, step %d)\n",
+		rays.count, step);
+	printf("%4s %10s %10s %10s %12s %12s %8s\n", "iter", "nodes",
+		"tree build", "flat build", "tree Mray/s", "flat Mray/s", "speedup");
+	for (int it = 1; it <= max_iterations; it++)
+	{
+		t0 = get_time_ms();
+		arena_init(&arena, ARENA_DEFAULT_BLOCK);
+		tree = build_menger_bvh_tree(&arena, it);
+		t_build_tree = get_time_ms() - t0;
+		t0 = get_time_ms();
+		flat = build_menger_bvh(it);
+		t_build_flat = get_time_ms() - t0;
+		if (!tree || !flat)
+		{
+			printf("%4d allocation failed\n", it);
+			arena_destroy(&arena);
+			free_bvh(flat);
+			break ;
+		}
+		hits_tree = 0;
+		t0 = get_time_ms();
+		for (int i = 0; i < rays.count; i++)
+			hits_tree += ray_intersect_bvh_tree(tree, rays.origin,
+					rays.dirs[i], &t_min, &t_max);
+		t_tree = get_time_ms() - t0;
+		hits_flat = 0;
+		t0 = get_time_ms();
+		for (int i = 0; i < rays.count; i++)
+			hits_flat += ray_intersect_bvh(flat, rays.origin,
+					rays.dirs[i], &t_min, &t_max);
+		t_flat = get_time_ms() - t0;
+		printf("%4d %10u %8.1fms %8.1fms %12.2f %12.2f %7.2fx%s\n", it,
+			flat->count, t_build_tree, t_build_flat,
+			rays.count / (t_tree * 1000.0), rays.count / (t_flat * 1000.0),
+			t_tree / t_flat, hits_tree != hits_flat ? " (hit mismatch)" : "");
+		arena_destroy(&arena);
+		free_bvh(flat);
+	}
+	free(rays.dirs);
+	return (0);
+}
+
+//Implicit traversal vs flat BVH: checks both give the exact same hits
+//while the BVH fits in memory, then times the implicit path alone
+static int	bench_implicit(int max_iterations, int step)
+{
+	t_ray_batch	rays;
+	t_flat_bvh	*flat;
+	double		t0, t_bvh, t_impl;
+	double		a_min, a_max, b_min, b_max;
+	int			hit_a, hit_b, mismatches;
+
+	if (!make_top_view_rays(&rays, step))
+		return (1);
+	printf("Implicit traversal benchmark: %d rays per frame (step %d)\n",
+		rays.count, step);
+	printf("%4s %12s %12s %12s\n", "iter", "bvh Mray/s", "impl Mray/s",
+		"mismatches");
+	for (int it = 1; it <= max_iterations; it++)
+	{
+		flat = NULL;
+		if (it <= 4)
+			flat = build_menger_bvh(it);
+		mismatches = 0;
+		t_bvh = 0;
+		if (flat)
+		{
+			t0 = get_time_ms();
+			for (int i = 0; i < rays.count; i++)
+				ray_intersect_bvh(flat, rays.origin, rays.dirs[i],
+					&a_min, &a_max);
+			t_bvh = get_time_ms() - t0;
+			for (int i = 0; i < rays.count; i++)
+			{
+				hit_a = ray_intersect_bvh(flat, rays.origin, rays.dirs[i],
+						&a_min, &a_max);
+				hit_b = ray_intersect_menger_implicit(it, rays.origin,
+						rays.dirs[i], &b_min, &b_max);
+				mismatches += (hit_a != hit_b || (hit_a && a_min != b_min));
+			}
+		}
+		t0 = get_time_ms();
+		for (int i = 0; i < rays.count; i++)
+			ray_intersect_menger_implicit(it, rays.origin, rays.dirs[i],
+				&b_min, &b_max);
+		t_impl = get_time_ms() - t0;
+		if (flat)
+			printf("%4d %12.2f %12.2f %12d\n", it,
+				rays.count / (t_bvh * 1000.0), rays.count / (t_impl * 1000.0),
+				mismatches);
+		else
+			printf("%4d %12s %12.2f %12s\n", it, "-",
+				rays.count / (t_impl * 1000.0), "-");
+		free_bvh(flat);
+	}
+	free(rays.dirs);
+	return (0);
+}
+
+//Flat BVH build time per level and thread count, each parallel build is
+//compared node for node with the single threaded one
+static int	bench_build(int max_iterations)
+{
+	static const int	threads[4] = {2, 4, 8, 16};
+	t_flat_bvh			*serial;
+	t_flat_bvh			*parallel;
+	double				t0;
+	int					same;
+
+	printf("BVH build benchmark: %d online cores\n", menger_build_threads());
+	printf("%4s %10s %10s", "iter", "nodes", "1 thread");
+	for (int i = 0; i < 4; i++)
+		printf(" %7d th", threads[i]);
+	printf(" %10s\n", "identical");
+	for (int it = 1; it <= max_iterations; it++)
+	{
+		t0 = get_time_ms();
+		serial = build_menger_bvh_threads(it, 1);
+		if (!serial)
+		{
+			printf("%4d allocation failed\n", it);
+			break ;
+		}
+		printf("%4d %10u %8.1fms", it, serial->count, get_time_ms() - t0);
+		same = 1;
+		for (int i = 0; i < 4; i++)
+		{
+			t0 = get_time_ms();
+			parallel = build_menger_bvh_threads(it, threads[i]);
+			if (!parallel)
+			{
+				printf(" %10s", "-");
+				continue ;
+			}
+			printf(" %8.1fms", get_time_ms() - t0);
+			same &= !memcmp(serial->nodes, parallel->nodes,
+					serial->count * sizeof(t_flat_bvh_node));
+			free_bvh(parallel);
+		}
+		printf(" %10s\n", same ? "yes" : "NO");
+		fflush(stdout);
+		free_bvh(serial);
+	}
+	return (0);
+}
+
+//Level changes: full rebuild vs in-place refine (n - 1 -> n) and prune
+//(n + 1 -> n), both checked node for node against the full build
+static int	same_bvh(const t_flat_bvh *a, const t_flat_bvh *b)
+{
+	return (a && b && a->count == b->count && !memcmp(a->nodes, b->nodes,
+			a->count * sizeof(t_flat_bvh_node)));
+}
+
+//Times one refine (it - 1 -> it) and one prune (it + 1 -> it) against a
+//full build of level it, and checks that all three trees are identical
+static int	bench_refine(int max_iterations)
+{
+	t_flat_bvh	*full;
+	t_flat_bvh	*step;
+	t_flat_bvh	*moved;
+	double		t0, t_full, t_refine, t_prune;
+	int			same;
+
+	printf("Incremental BVH benchmark\n");
+	printf("%4s %10s %12s %12s %12s %10s\n", "iter", "nodes", "full build",
+		"refine up", "prune down", "identical");
+	for (int it = 1; it <= max_iterations; it++)
+	{
+		t0 = get_time_ms();
+		full = build_menger_bvh(it);
+		t_full = get_time_ms() - t0;
+		step = build_menger_bvh(it - 1);
+		t0 = get_time_ms();
+		moved = NULL;
+		if (full && step)
+			moved = refine_menger_bvh(step);
+		t_refine = get_time_ms() - t0;
+		if (moved)
+			step = moved;
+		same = same_bvh(step, full);
+		free_bvh(step);
+		step = build_menger_bvh(it + 1);
+		t0 = get_time_ms();
+		if (step)
+			step = prune_menger_bvh(step);
+		t_prune = get_time_ms() - t0;
+		same &= same_bvh(step, full);
+		free_bvh(step);
+		if (!full)
+		{
+			printf("%4d allocation failed\n", it);
+			return (1);
+		}
+		printf("%4d %10u %10.1fms %10.1fms %10.1fms %10s\n", it, full->count,
+			t_full, t_refine, t_prune, same ? "yes" : "NO");
+		free_bvh(full);
+	}
+	return (0);
+}
+
+//Pointer BVH built into an arena: build and teardown time, allocator stats
+static int	bench_arena(int max_iterations)
+{
+	t_arena		arena;
+	t_bvh_node	*tree;
+	double		t0, t_build, t_free;
+	size_t		nodes;
+	char		name[32];
+
+	printf("Arena benchmark: pointer BVH, %d-byte blocks\n",
+		ARENA_DEFAULT_BLOCK);
+	printf("%4s %12s %12s %12s\n", "iter", "nodes", "build", "teardown");
+	for (int it = 1; it <= max_iterations; it++)
+	{
+		arena_init(&arena, ARENA_DEFAULT_BLOCK);
+		t0 = get_time_ms();
+		tree = build_menger_bvh_tree(&arena, it);
+		t_build = get_time_ms() - t0;
+		if (!tree)
+		{
+			printf("%4d allocation failed\n", it);
+			arena_destroy(&arena);
+			return (1);
+		}
+		snprintf(name, sizeof(name), "level %d", it);
+		arena_print_stats(&arena, name);
+		nodes = arena.allocations;
+		t0 = get_time_ms();
+		arena_destroy(&arena);
+		t_free = get_time_ms() - t0;
+		printf("%4d %12zu %10.1fms %10.2fms\n", it, nodes, t_build, t_free);
+	}
+	return (0);
+}
+
+//Off-screen Menger scene on the top view camera of make_top_view_rays
+static int	make_bench_scene(t_scene *scene, int iterations, int res)
+{
+	memset(scene, 0, sizeof(t_scene));
+	scene->name = "menger";
+	scene->is_3d = 1;
+	scene->resolution_factor = res;
+	scene->camera.position = (t_vec3){0.0, 3.0, 0.0};
+	scene->camera.rotation = (t_vec3){1.57, 0.0, 0.0};
+	scene->camera.fov = 80.0;
+	scene->camera.aspect_ratio = (double)WIDTH / HEIGHT;
+	scene->menger.iterations = iterations;
+	scene->menger.mode = MENGER_MODE_BVH;
+	scene->img.bpp = 32;
+	scene->img.line_len = WIDTH * 4;
+	scene->img.pixels_ptr = malloc(WIDTH * HEIGHT * 4);
+	scene->menger.bvh = build_menger_bvh(iterations);
+	if (scene->img.pixels_ptr && scene->menger.bvh)
+		return (1);
+	free(scene->img.pixels_ptr);
+	free_bvh(scene->menger.bvh);
+	return (0);
+}
+
+//One Menger frame split in row stripes, one per thread, then in tiles off
+//the shared counter. Same image either way; the stats show the load balance.
+static int	bench_tiles(int iterations, int res, int threads)
+{
+	t_scene		scene;
+	t_tile_job	job;
+	char		*stripes;
+
+	if (!make_bench_scene(&scene, iterations, res))
+		return (1);
+	stripes = malloc(WIDTH * HEIGHT * 4);
+	if (!stripes)
+	{
+		free(scene.img.pixels_ptr);
+		free_bvh(scene.menger.bvh);
+		return (1);
+	}
+	printf("Tile scheduler benchmark: iterations %d, resolution %d\n",
+		iterations, res);
+	job.tile_w = WIDTH;
+	job.tile_h = (HEIGHT + threads - 1) / threads;
+	job.threads = threads;
+	job.pool = NULL;
+	job.cancel = NULL;
+	render_menger_frame(&scene, &job);
+	print_tile_stats(&job, "stripes");
+	memcpy(stripes, scene.img.pixels_ptr, WIDTH * HEIGHT * 4);
+	job.tile_w = 0;
+	job.tile_h = 0;
+	render_menger_frame(&scene, &job);
+	print_tile_stats(&job, "tiles");
+	printf("images %s\n", memcmp(stripes, scene.img.pixels_ptr,
+			WIDTH * HEIGHT * 4) ? "DIFFER" : "identical");
+	free(stripes);
+	free(scene.img.pixels_ptr);
+	free_bvh(scene.menger.bvh);
+	return (0);
+}
+
+//Coarse-to-fine passes against one pass at the resolution factor: time to
+//each pass (the first is the preview) and the final image, which must match
+static int	bench_progressive(int iterations, int res)
+{
+	t_scene		scene;
+	t_tile_job	job;
+	char		*single;
+	double		t0;
+	int			step;
+
+	if (!make_bench_scene(&scene, iterations, res))
+		return (1);
+	single = malloc(WIDTH * HEIGHT * 4);
+	if (!single)
+	{
+		free(scene.img.pixels_ptr);
+		free_bvh(scene.menger.bvh);
+		return (1);
+	}
+	printf("Progressive benchmark: iterations %d, resolution %d\n",
+		iterations, res);
+	job.tile_w = 0;
+	job.tile_h = 0;
+	job.threads = 0;
+	job.pool = NULL;
+	job.cancel = NULL;
+	render_menger_frame(&scene, &job);
+	printf("  single pass:      %8.2f ms\n", job.wall_ms);
+	memcpy(single, scene.img.pixels_ptr, WIDTH * HEIGHT * 4);
+	memset(scene.img.pixels_ptr, 0, WIDTH * HEIGHT * 4);
+	t0 = get_time_ms();
+	step = menger_preview_step(&scene);
+	for (int pass = 0; step >= res; pass++, step /= 2)
+	{
+		job.tile_w = 0;
+		job.tile_h = 0;
+		render_menger_pass(&scene, &job, step, pass > 0);
+		printf("  pass %d, step %2d: %8.2f ms (%8.2f ms total)\n", pass,
+			step, job.wall_ms, get_time_ms() - t0);
+	}
+	printf("images %s\n", memcmp(single, scene.img.pixels_ptr,
+			WIDTH * HEIGHT * 4) ? "DIFFER" : "identical");
+	free(single);
+	free(scene.img.pixels_ptr);
+	free_bvh(scene.menger.bvh);
+	return (0);
+}
+
+//Primary ray of pixel (x, y) as the renderers made it before
+//camera_setup: the whole rotation per pixel
+static t_vec3	rotated_ray_dir(const t_camera *camera, int x, int y,
+					double fov_scale)
+{
+	t_vec3	dir;
+
+	dir.x = (2.0 * x / (double)WIDTH - 1.0) * fov_scale
+		* camera->aspect_ratio;
+	dir.y = (1.0 - 2.0 * y / (double)HEIGHT) * fov_scale;
+	dir.z = 1.0;
+	return (vec3_normalize(rotate_point(dir, camera->rotation)));
+}
+
+//All primary rays of a frame, per pixel rotate_point against the basis
+//from camera_setup, best of `frames`. The directions are summed so the
+//loops can't be dropped, and must agree to rounding.
+static int	bench_camera(int frames)
+{
+	t_camera	camera;
+	t_vec3		row, dir, sum[2];
+	double		t0, best[2], worst, fov_scale;
+
+	camera.rotation = (t_vec3){-0.6, 0.8, 0.1};
+	camera.fov = 55.0;
+	camera.aspect_ratio = (double)WIDTH / HEIGHT;
+	fov_scale = tan(camera.fov * M_PI / 360.0);
+	best[0] = INFINITY;
+	best[1] = INFINITY;
+	for (int f = 0; f < frames; f++)
+	{
+		sum[0] = (t_vec3){0.0, 0.0, 0.0};
+		t0 = get_time_ms();
+		for (int y = 0; y < HEIGHT; y++)
+			for (int x = 0; x < WIDTH; x++)
+				sum[0] = vec3_add(sum[0],
+						rotated_ray_dir(&camera, x, y, fov_scale));
+		best[0] = fmin(best[0], get_time_ms() - t0);
+		sum[1] = (t_vec3){0.0, 0.0, 0.0};
+		t0 = get_time_ms();
+		camera_setup(&camera, WIDTH, HEIGHT);
+		for (int y = 0; y < HEIGHT; y++)
+		{
+			row = camera_row(&camera, y);
+			for (int x = 0; x < WIDTH; x++)
+				sum[1] = vec3_add(sum[1], camera_ray_dir(&camera, row, x));
+		}
+		best[1] = fmin(best[1], get_time_ms() - t0);
+	}
+	worst = 0.0;
+	for (int y = 0; y < HEIGHT; y++)
+	{
+		row = camera_row(&camera, y);
+		for (int x = 0; x < WIDTH; x++)
+		{
+			dir = vec3_subtract(camera_ray_dir(&camera, row, x),
+					rotated_ray_dir(&camera, x, y, fov_scale));
+			worst = fmax(worst, vec3_length(dir));
+		}
+	}
+	printf("Primary rays, %dx%d, best of %d frames\n", WIDTH, HEIGHT, frames);
+	printf("  rotate_point per pixel: %8.2f ms (sum %.3f)\n", best[0],
+		sum[0].x + sum[0].y + sum[0].z);
+	printf("  camera_setup basis:     %8.2f ms (sum %.3f), %.1fx\n", best[1],
+		sum[1].x + sum[1].y + sum[1].z, best[0] / best[1]);
+	printf("  largest direction difference %.1e\n", worst);
+	return (worst > 1e-12);
+}
+
+//Headless object-list scene with an image of the window size
+static int	make_object_scene(t_scene *scene)
+{
+	memset(scene, 0, sizeof(t_scene));
+	scene->width = WIDTH;
+	scene->height = HEIGHT;
+	scene->img.bpp = 32;
+	scene->img.line_len = WIDTH * 4;
+	scene->img.pixels_ptr = malloc(WIDTH * HEIGHT * 4);
+	if (!scene->img.pixels_ptr)
+		return (0);
+	arena_init(&scene->arena, ARENA_DEFAULT_BLOCK);
+	return (1);
+}
+
+//`frames` moving frames, the camera turning a little each time, sized by
+//the adaptive controller like the interactive renderers do, then the full
+//resolution frame the idle pass ends with
+static void	adaptive_frames(t_scene *scene, t_pass_fn pass, int frames)
+{
+	t_tile_job	job;
+	double		ms, sum;
+	int			step, counted;
+
+	adaptive_init(&scene->adaptive);
+	scene->adaptive.moving = 1;
+	sum = 0.0;
+	counted = 0;
+	printf("  moving:");
+	for (int f = 0; f < frames; f++)
+	{
+		step = adaptive_step(scene);
+		tile_job_init(&job, NULL, NULL, 1, 1);
+		job.tile_w = 0;
+		job.tile_h = 0;
+		job.threads = 0;
+		pass(scene, &job, step, 0);
+		ms = adaptive_frame_ms(&job);
+		adaptive_record(&scene->adaptive, step, ms);
+		printf(" %d:%.0fms", step, ms);
+		if (f >= frames / 2)
+		{
+			sum += ms;
+			counted++;
+		}
+		scene->camera.rotation.y += 0.02;
+	}
+	tile_job_init(&job, NULL, NULL, 1, 1);
+	job.tile_w = 0;
+	job.tile_h = 0;
+	job.threads = 0;
+	pass(scene, &job, scene->resolution_factor, 0);
+	printf("\n  settled at %.1f ms a frame (target %.0f), idle pass %.1f ms\n",
+		sum / counted, ADAPTIVE_TARGET_MS, job.wall_ms);
+}
+
+//Adaptive resolution on the Menger sponge and the plane scene: the step
+//of every moving frame (any spacing, not just powers of two) and its
+//time, which should settle near ADAPTIVE_TARGET_MS
+static int	bench_adaptive(int iterations, int frames)
+{
+	t_scene	scene;
+
+	if (!make_bench_scene(&scene, iterations, 1))
+		return (1);
+	printf("Menger sponge, %d iterations, %d moving frames\n", iterations,
+		frames);
+	adaptive_frames(&scene, render_menger_pass, frames);
+	free_bvh(scene.menger.bvh);
+	free(scene.img.pixels_ptr);
+	if (!make_object_scene(&scene))
+		return (1);
+	set_up_scene_plane(&scene);
+	scene.resolution_factor = 1;
+	scene_bvh_build(&scene.bvh, scene.objects);
+	printf("Plane scene, %d moving frames\n", frames);
+	adaptive_frames(&scene, render_scene_pass, frames);
+	scene_bvh_free(&scene.bvh);
+	arena_destroy(&scene.arena);
+	free(scene.img.pixels_ptr);
+	return (0);
+}
+
+//Plane scene from the object list at full resolution on 1, 2, 4, ...
+//threads up to max_threads: best of `frames` frames, speedup against one
+//thread, and the image must not depend on the thread count
+static int	bench_scene(int max_threads, int frames)
+{
+	t_scene		scene;
+	t_tile_job	job;
+	char		*single;
+	double		best, base;
+
+	single = malloc(WIDTH * HEIGHT * 4);
+	if (!single || !make_object_scene(&scene))
+	{
+		free(single);
+		return (1);
+	}
+	set_up_scene_plane(&scene);
+	printf("Object list scene: %dx%d, best of %d frames\n", WIDTH, HEIGHT,
+		frames);
+	printf("%8s %10s %8s %10s\n", "threads", "frame", "speedup", "image");
+	base = 0;
+	for (int threads = 1; threads <= max_threads; threads *= 2)
+	{
+		best = INFINITY;
+		for (int i = 0; i < frames; i++)
+		{
+			job.tile_w = 0;
+			job.tile_h = 0;
+			job.threads = threads;
+			job.pool = NULL;
+			job.cancel = NULL;
+			render_scene_pass(&scene, &job, 1, 0);
+			best = fmin(best, job.wall_ms);
+		}
+		if (threads == 1)
+		{
+			base = best;
+			memcpy(single, scene.img.pixels_ptr, WIDTH * HEIGHT * 4);
+		}
+		printf("%8d %8.1fms %7.2fx %10s\n", threads, best, base / best,
+			memcmp(single, scene.img.pixels_ptr, WIDTH * HEIGHT * 4)
+			? "DIFFERS" : "same");
+		if (threads < max_threads && threads * 2 > max_threads)
+			threads = max_threads / 2;
+	}
+	arena_destroy(&scene.arena);
+	free(single);
+	free(scene.img.pixels_ptr);
+	return (0);
+}
+
+//Camera rays every `step` pixels through a field of `count` spheres,
+//walking the object list and then through the scene BVH: build time,
+//frame times and the two images, which must match. The full resolution
+//BVH frame shows whether the field is interactive.
+static int	bench_spheres(int count, int step)
+{
+	t_scene		scene;
+	t_tile_job	job;
+	char		*list;
+	double		t0, t_build, t_list;
+
+	list = malloc(WIDTH * HEIGHT * 4);
+	if (!list || !make_object_scene(&scene))
+	{
+		free(list);
+		return (1);
+	}
+	set_up_scene_spheres(&scene, count);
+	printf("Sphere field: %d spheres, rays every %d pixels\n", count, step);
+	tile_job_init(&job, NULL, NULL, 1, 1);
+	job.tile_w = 0;
+	job.tile_h = 0;
+	render_scene_pass(&scene, &job, step, 0);
+	t_list = job.wall_ms;
+	memcpy(list, scene.img.pixels_ptr, WIDTH * HEIGHT * 4);
+	t0 = get_time_ms();
+	scene_bvh_build(&scene.bvh, scene.objects);
+	t_build = get_time_ms() - t0;
+	printf("  BVH build:  %10.1f ms, %d nodes, %d planes aside\n", t_build,
+		scene.bvh.node_count, scene.bvh.plane_count);
+	job.tile_w = 0;
+	job.tile_h = 0;
+	render_scene_pass(&scene, &job, step, 0);
+	printf("  list:       %10.1f ms\n", t_list);
+	printf("  BVH:        %10.1f ms (%.0fx)\n", job.wall_ms,
+		t_list / job.wall_ms);
+	printf("images %s\n", memcmp(list, scene.img.pixels_ptr,
+			WIDTH * HEIGHT * 4) ? "DIFFER" : "identical");
+	job.tile_w = 0;
+	job.tile_h = 0;
+	render_scene_pass(&scene, &job, 1, 0);
+	printf("  BVH, full resolution: %.1f ms on %d threads\n", job.wall_ms,
+		job.threads);
+	scene_bvh_free(&scene.bvh);
+	arena_destroy(&scene.arena);
+	free(list);
+	free(scene.img.pixels_ptr);
+	return (0);
+}
+
+//Per channel difference between two frames: share of pixels that differ
+//at all and by more than PRECISION_TOLERANCE levels, largest and mean
+//channel difference. Returns the share over the tolerance, in percent.
+static double	image_diff(const unsigned char *a, const unsigned char *b)
+{
+	long	differ, over, sum;
+	int		d, worst, max;
+
+	differ = 0;
+	over = 0;
+	sum = 0;
+	max = 0;
+	for (long i = 0; i < (long)WIDTH * HEIGHT; i++)
+	{
+		worst = 0;
+		for (int c = 0; c < 3; c++)
+		{
+			d = abs(a[i * 4 + c] - b[i * 4 + c]);
+			sum += d;
+			if (d > worst)
+				worst = d;
+		}
+		differ += worst > 0;
+		over += worst > PRECISION_TOLERANCE;
+		if (worst > max)
+			max = worst;
+	}
+	printf("  pixels differing: %6.3f%%, over %d levels: %6.3f%%\n",
+		100.0 * differ / ((long)WIDTH * HEIGHT), PRECISION_TOLERANCE,
+		100.0 * over / ((long)WIDTH * HEIGHT));
+	printf("  channel diff: max %d, mean %.4f\n", max,
+		(double)sum / ((long)WIDTH * HEIGHT * 3));
+	return (100.0 * over / ((long)WIDTH * HEIGHT));
+}
+
+//One full resolution frame of the double and of the float kernels
+static double	precision_frames(t_scene *scene, char *reference)
+{
+	t_tile_job	job;
+	double		t_double;
+
+	tile_job_init(&job, NULL, NULL, 1, 1);
+	job.tile_w = 0;
+	job.tile_h = 0;
+	scene->bvh.single = 0;
+	render_scene_pass(scene, &job, 1, 0);
+	t_double = job.wall_ms;
+	memcpy(reference, scene->img.pixels_ptr, WIDTH * HEIGHT * 4);
+	job.tile_w = 0;
+	job.tile_h = 0;
+	scene->bvh.single = 1;
+	render_scene_pass(scene, &job, 1, 0);
+	printf("  double: %8.1f ms, float: %8.1f ms (%.2fx)\n", t_double,
+		job.wall_ms, t_double / job.wall_ms);
+	return (image_diff((unsigned char *)reference,
+			(unsigned char *)scene->img.pixels_ptr));
+}
+
+//Sphere field of `count` spheres, or the plane scene for 0
+static double	precision_scene(int count, char *reference)
+{
+	t_scene	scene;
+	double	over;
+
+	if (!make_object_scene(&scene))
+		return (INFINITY);
+	if (count)
+	{
+		set_up_scene_spheres(&scene, count);
+		printf("Sphere field, %d spheres:\n", count);
+	}
+	else
+	{
+		set_up_scene_plane(&scene);
+		printf("Plane scene:\n");
+	}
+	scene_bvh_build(&scene.bvh, scene.objects);
+	over = precision_frames(&scene, reference);
+	scene_bvh_free(&scene.bvh);
+	arena_destroy(&scene.arena);
+	free(scene.img.pixels_ptr);
+	return (over);
+}
+
+//Float against double kernels on the sphere field and the plane scene,
+//full resolution: frame times and the image difference, which must stay
+//within PRECISION_MAX_OVER percent of pixels off by more than
+//PRECISION_TOLERANCE levels
+static int	bench_precision(int count)
+{
+	char	*reference;
+	double	over;
+
+	reference = malloc(WIDTH * HEIGHT * 4);
+	if (!reference)
+		return (1);
+	over = precision_scene(count, reference);
+	over = fmax(over, precision_scene(0, reference));
+	free(reference);
+	printf("float path %s (limit %.2f%% of pixels)\n",
+		over <= PRECISION_MAX_OVER ? "within bounds" : "OVER BOUNDS",
+		PRECISION_MAX_OVER);
+	return (over > PRECISION_MAX_OVER);
+}
+
+static void	empty_tile(void *ctx, int x0, int y0, int x1, int y1)
+{
+	(void)ctx;
+	(void)x0;
+	(void)y0;
+	(void)x1;
+	(void)y1;
+}
+
+//Cost of handing a frame to `threads` threads with nothing to draw (a
+//single empty tile): pthread_create/join per frame against the pool
+static int	bench_pool(int threads, int frames)
+{
+	t_render_pool	pool;
+	t_tile_job		job;
+	double			t0, t_spawn, t_pool;
+
+	tile_job_init(&job, empty_tile, NULL, WIDTH, HEIGHT);
+	job.threads = threads;
+	t0 = get_time_ms();
+	for (int i = 0; i < frames; i++)
+		run_tile_job(&job);
+	t_spawn = get_time_ms() - t0;
+	render_pool_init(&pool, threads);
+	job.pool = &pool;
+	t0 = get_time_ms();
+	for (int i = 0; i < frames; i++)
+		run_tile_job(&job);
+	t_pool = get_time_ms() - t0;
+	render_pool_destroy(&pool);
+	printf("Frame dispatch, %d threads, %d empty frames\n", threads, frames);
+	printf("  create/join: %8.1f us per frame\n", t_spawn * 1000.0 / frames);
+	printf("  pool:        %8.1f us per frame\n", t_pool * 1000.0 / frames);
+	return (0);
+}
+
+//Closest hits of the whole batch traced as MENGER_PACKET_W x MENGER_PACKET_H
+//tiles, like render_menger_thread. Counts lanes that disagree with the
+//single ray path when `check` is set.
+static int	trace_packets(const t_flat_bvh *flat, const t_ray_batch *rays,
+				int check)
+{
+	t_ray_packet	packet;
+	t_vec3			origins[MENGER_PACKET_SIZE];
+	t_vec3			dirs[MENGER_PACKET_SIZE];
+	double			t_min[MENGER_PACKET_SIZE], t_max[MENGER_PACKET_SIZE];
+	double			s_min, s_max;
+	int				active, hits, col, row, mismatches;
+
+	mismatches = 0;
+	for (int y = 0; y < rays->rows; y += MENGER_PACKET_H)
+	{
+		for (int x = 0; x < rays->cols; x += MENGER_PACKET_W)
+		{
+			active = 0;
+			for (int lane = 0; lane < MENGER_PACKET_SIZE; lane++)
+			{
+				col = x + lane % MENGER_PACKET_W;
+				row = y + lane / MENGER_PACKET_W;
+				if (col >= rays->cols || row >= rays->rows)
+					continue ;
+				active |= 1 << lane;
+				origins[lane] = rays->origin;
+				dirs[lane] = rays->dirs[row * rays->cols + col];
+			}
+			ray_packet_prepare(&packet, origins, dirs, active);
+			hits = ray_intersect_bvh_packet(flat, &packet, t_min, t_max);
+			for (int lane = 0; check && lane < MENGER_PACKET_SIZE; lane++)
+			{
+				if (!(active & (1 << lane)))
+					continue ;
+				if (ray_intersect_bvh(flat, origins[lane], dirs[lane], &s_min,
+						&s_max) != !!(hits & (1 << lane))
+					|| ((hits & (1 << lane)) && s_min != t_min[lane]))
+					mismatches++;
+			}
+		}
+	}
+	return (mismatches);
+}
+
+//Packet vs single ray traversal of the flat BVH on the top view
+static int	bench_packet(int max_iterations, int step)
+{
+	t_ray_batch	rays;
+	t_flat_bvh	*flat;
+	double		t0, t_single, t_packet;
+	double		t_min, t_max;
+
+	if (!make_top_view_rays(&rays, step))
+		return (1);
+	printf("Packet traversal benchmark: %d rays per frame (step %d), "
+		"%dx%d packets\n", rays.count, step, MENGER_PACKET_W, MENGER_PACKET_H);
+	printf("%4s %13s %13s %8s %11s\n", "iter", "single Mray/s",
+		"packet Mray/s", "speedup", "mismatches");
+	for (int it = 1; it <= max_iterations; it++)
+	{
+		flat = build_menger_bvh(it);
+		if (!flat)
+		{
+			printf("%4d allocation failed\n", it);
+			break ;
+		}
+		t0 = get_time_ms();
+		for (int i = 0; i < rays.count; i++)
+			ray_intersect_bvh(flat, rays.origin, rays.dirs[i], &t_min, &t_max);
+		t_single = get_time_ms() - t0;
+		t0 = get_time_ms();
+		trace_packets(flat, &rays, 0);
+		t_packet = get_time_ms() - t0;
+		printf("%4d %13.2f %13.2f %7.2fx %11d\n", it,
+			rays.count / (t_single * 1000.0), rays.count / (t_packet * 1000.0),
+			t_single / t_packet, trace_packets(flat, &rays, 1));
+		free_bvh(flat);
+	}
+	free(rays.dirs);
+	return (0);
+}
+
+//Binary flat BVH vs its wide collapse: size, collapse time, rays/sec and
+//hits that differ between the two
+static int	bench_wide(int max_iterations, int step)
+{
+	t_ray_batch	rays;
+	t_flat_bvh	*flat;
+	t_wide_bvh	*wide;
+	double		t0, t_collapse, t_flat, t_wide;
+	double		a_min, a_max, b_min, b_max;
+	int			hit_a, hit_b, mismatches;
+
+	if (!make_top_view_rays(&rays, step))
+		return (1);
+	printf("Wide BVH benchmark: %d rays per frame (step %d), %d children "
+		"per node\n", rays.count, step, MENGER_WIDE_WIDTH);
+	printf("%4s %9s %9s %6s %10s %12s %12s %8s %11s\n", "iter", "bin MB",
+		"wide MB", "depth", "collapse", "bin Mray/s", "wide Mray/s",
+		"speedup", "mismatches");
+	for (int it = 1; it <= max_iterations; it++)
+	{
+		flat = build_menger_bvh(it);
+		t0 = get_time_ms();
+		wide = build_menger_wide_bvh(flat);
+		t_collapse = get_time_ms() - t0;
+		if (!flat || !wide)
+		{
+			printf("%4d allocation failed\n", it);
+			free_bvh(flat);
+			free_wide_bvh(wide);
+			break ;
+		}
+		t0 = get_time_ms();
+		for (int i = 0; i < rays.count; i++)
+			ray_intersect_bvh(flat, rays.origin, rays.dirs[i], &a_min, &a_max);
+		t_flat = get_time_ms() - t0;
+		t0 = get_time_ms();
+		for (int i = 0; i < rays.count; i++)
+			ray_intersect_wide_bvh(wide, rays.origin, rays.dirs[i], &b_min,
+				&b_max);
+		t_wide = get_time_ms() - t0;
+		mismatches = 0;
+		for (int i = 0; i < rays.count; i++)
+		{
+			hit_a = ray_intersect_bvh(flat, rays.origin, rays.dirs[i],
+					&a_min, &a_max);
+			hit_b = ray_intersect_wide_bvh(wide, rays.origin, rays.dirs[i],
+					&b_min, &b_max);
+			mismatches += (hit_a != hit_b || (hit_a && a_min != b_min));
+		}
+		printf("%4d %9.1f %9.1f %6d %8.1fms %12.2f %12.2f %7.2fx %11d\n", it,
+			flat->count * sizeof(t_flat_bvh_node) / 1048576.0,
+			wide->count * sizeof(t_wide_bvh_node) / 1048576.0, wide->depth,
+			t_collapse, rays.count / (t_flat * 1000.0),
+			rays.count / (t_wide * 1000.0), t_flat / t_wide, mismatches);
+		free_bvh(flat);
+		free_wide_bvh(wide);
+	}
+	free(rays.dirs);
+	return (0);
+}
+
+typedef struct s_ray_set
+{
+	t_vec3	*origins;
+	t_vec3	*dirs;
+	int		count;
+}	t_ray_set;
+
+//Secondary rays leaving the primary hits of the top view: mirror
+//reflections like shade_menger_hit, or shadow rays towards its light.
+//The face normal is the axis whose coordinate sits on the cell grid.
+static int	make_secondary_rays(const t_flat_bvh *flat, const t_ray_batch *rays,
+				int shadow, t_ray_set *set)
+{
+	const t_vec3	to_light = vec3_normalize((t_vec3){-0.5, -0.5, 1.0});
+	const double	size = 2.0 / pow(3.0, flat->iterations);
+	double			t_min, t_max, dist[3], p[3], d[3];
+	t_vec3			hit, normal;
+	int				axis;
+
+	set->count = 0;
+	set->origins = malloc(sizeof(t_vec3) * rays->count);
+	set->dirs = malloc(sizeof(t_vec3) * rays->count);
+	if (!set->origins || !set->dirs)
+		return (0);
+	for (int i = 0; i < rays->count; i++)
+	{
+		if (!ray_intersect_bvh(flat, rays->origin, rays->dirs[i], &t_min,
+				&t_max) || t_min <= 0)
+			continue ;
+		hit = vec3_add(rays->origin, vec3_scale(rays->dirs[i], t_min));
+		p[0] = hit.x;
+		p[1] = hit.y;
+		p[2] = hit.z;
+		d[0] = rays->dirs[i].x;
+		d[1] = rays->dirs[i].y;
+		d[2] = rays->dirs[i].z;
+		axis = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			dist[k] = fabs(remainder(p[k] + 1.0, size));
+			if (dist[k] < dist[axis])
+				axis = k;
+		}
+		normal = (t_vec3){0, 0, 0};
+		*(&normal.x + axis) = (d[axis] > 0) ? -1.0 : 1.0;
+		set->origins[set->count] = vec3_add(hit, vec3_scale(normal, 0.001));
+		if (shadow)
+			set->dirs[set->count++] = to_light;
+		else
+			set->dirs[set->count++] = reflect_ray(rays->dirs[i], normal);
+	}
+	return (1);
+}
+
+//Any-hit vs closest-hit on reflection and shadow rays: both must agree
+//on hit or miss, the any-hit query should get there with fewer box tests
+static int	bench_occlusion(int max_iterations, int step)
+{
+	static const char	*kinds[2] = {"reflect", "shadow"};
+	t_ray_batch			rays;
+	t_ray_set			set;
+	t_flat_bvh			*flat;
+	double				t0, t_closest, t_any, t_min, t_max;
+	long				v_closest, v_any;
+	int					mismatches;
+
+	if (!make_top_view_rays(&rays, step))
+		return (1);
+	printf("Occlusion benchmark: secondary rays from the top view (step %d)\n",
+		step);
+	printf("%4s %8s %8s %14s %14s %10s %10s %7s %11s\n", "iter", "rays",
+		"kind", "closest Mray/s", "any Mray/s", "tests/ray", "any/ray",
+		"saved", "mismatches");
+	for (int it = 1; it <= max_iterations; it++)
+	{
+		flat = build_menger_bvh(it);
+		if (!flat)
+		{
+			printf("%4d allocation failed\n", it);
+			break ;
+		}
+		for (int kind = 0; kind < 2; kind++)
+		{
+			if (!make_secondary_rays(flat, &rays, kind, &set))
+				return (1);
+			t0 = get_time_ms();
+			for (int i = 0; i < set.count; i++)
+				ray_intersect_bvh(flat, set.origins[i], set.dirs[i], &t_min,
+					&t_max);
+			t_closest = get_time_ms() - t0;
+			t0 = get_time_ms();
+			for (int i = 0; i < set.count; i++)
+				ray_occluded_bvh(flat, set.origins[i], set.dirs[i]);
+			t_any = get_time_ms() - t0;
+			v_closest = 0;
+			v_any = 0;
+			mismatches = 0;
+			for (int i = 0; i < set.count; i++)
+				mismatches += ray_intersect_bvh_counted(flat, set.origins[i],
+						set.dirs[i], &t_min, &t_max, &v_closest)
+					!= ray_occluded_bvh_counted(flat, set.origins[i],
+						set.dirs[i], &v_any);
+			printf("%4d %8d %8s %14.2f %14.2f %10.1f %10.1f %6.1f%% %11d\n",
+				it, set.count, kinds[kind], set.count / (t_closest * 1000.0),
+				set.count / (t_any * 1000.0),
+				(double)v_closest / set.count, (double)v_any / set.count,
+				100.0 * (v_closest - v_any) / v_closest, mismatches);
+			free(set.origins);
+			free(set.dirs);
+		}
+		free_bvh(flat);
+	}
+	free(rays.dirs);
+	return (0);
+}
+
+static void	print_kernel(const char *name, double ms, long tests,
+				long hits, double base_ms)
+{
+	printf("%-28s %8.1fms %10.1f Mtest/s %6.2fx  hits %ld\n", name, ms,
+		tests / (ms * 1000.0), base_ms / ms, hits);
+}
+
+//Ray-AABB kernels alone: every top view ray against every box of a
+//level-3 sponge BVH
+static int	bench_aabb(int step)
+{
+	t_ray_batch	rays;
+	t_flat_bvh	*flat;
+	t_aabb		*boxes;
+	t_aabb_ray	ray;
+	double		t0, base, ms, t_min, t_max;
+	long		hits, tests;
+
+	flat = build_menger_bvh(3);
+	if (!flat || !make_top_view_rays(&rays, step))
+		return (1);
+	boxes = malloc(sizeof(t_aabb) * flat->count);
+	if (!boxes)
+		return (1);
+	for (uint32_t i = 0; i < flat->count; i++)
+	{
+		boxes[i].min = (t_vec3){flat->nodes[i].min[0], flat->nodes[i].min[1],
+			flat->nodes[i].min[2]};
+		boxes[i].max = (t_vec3){flat->nodes[i].max[0], flat->nodes[i].max[1],
+			flat->nodes[i].max[2]};
+	}
+	tests = (long)rays.count * flat->count;
+	printf("Ray-AABB kernel benchmark: %d rays x %u boxes (SSE %d, AVX2 %d)\n",
+		rays.count, flat->count, HAS_SSE, HAS_AVX2);
+	hits = 0;
+	t0 = get_time_ms();
+	for (int r = 0; r < rays.count; r++)
+		for (uint32_t i = 0; i < flat->count; i++)
+			hits += ray_intersect_aabb_scalar(boxes[i], rays.origin,
+					rays.dirs[r], &t_min, &t_max);
+	base = get_time_ms() - t0;
+	print_kernel("scalar, inverse per box", base, tests, hits, base);
+	hits = 0;
+	t0 = get_time_ms();
+	for (int r = 0; r < rays.count; r++)
+	{
+		aabb_ray_prepare(&ray, rays.origin, rays.dirs[r]);
+		for (uint32_t i = 0; i < flat->count; i++)
+			hits += menger_slab_test(flat->nodes[i].min, flat->nodes[i].max,
+					&ray, &t_min, &t_max);
+	}
+	ms = get_time_ms() - t0;
+	print_kernel("float slab, inverse per ray", ms, tests, hits, base);
+#if HAS_AVX2
+	double	t[4];
+	int		mask;
+
+	hits = 0;
+	t0 = get_time_ms();
+	for (int r = 0; r < rays.count; r++)
+	{
+		aabb_ray_prepare(&ray, rays.origin, rays.dirs[r]);
+		for (uint32_t i = 0; i + 1 < flat->count; i += 2)
+		{
+			mask = menger_slab_test2(flat->nodes[i].min, flat->nodes[i].max,
+					flat->nodes[i + 1].min, flat->nodes[i + 1].max, &ray, t);
+			hits += (mask & 1) + (mask >> 1);
+		}
+		if (flat->count % 2)
+			hits += menger_slab_test(flat->nodes[flat->count - 1].min,
+					flat->nodes[flat->count - 1].max, &ray, &t_min, &t_max);
+	}
+	ms = get_time_ms() - t0;
+	print_kernel("AVX2 box pairs, per ray", ms, tests, hits, base);
+#endif
+	free(boxes);
+	free(rays.dirs);
+	free_bvh(flat);
+	return (0);
+}
+
+//SoA kernel of the precision set on the tree
+static void	soa_hits(const t_scene_bvh *bvh, int planes, int i, t_ray ray,
+				double t[4])
+{
+	if (planes && bvh->single)
+		plane_hits4f(&bvh->soa, i, ray, t);
+	else if (planes)
+		plane_hits4(&bvh->soa, i, ray, t);
+	else if (bvh->single)
+		sphere_hits4f(&bvh->soa, i, ray, t);
+	else
+		sphere_hits4(&bvh->soa, i, ray, t);
+}
+
+//Scalar intersect_object against the SoA kernels, four objects per call:
+//`count` spheres and 64 planes against every top view ray. The scalar
+//code may get FMAs fused in by the compiler (SIMD=avx2), and the float
+//kernels round differently, so lanes can be off: reports hit/miss
+//disagreements and the largest relative difference in t.
+static long	soa_kernel(const t_scene_bvh *bvh, const t_ray_batch *rays,
+				int n, int planes)
+{
+	double	t[SCENE_SOA_LANES];
+	double	ts, worst;
+	t_ray	ray;
+	long	diff;
+
+	diff = 0;
+	worst = 0.0;
+	ray.origin = rays->origin;
+	for (int r = 0; r < rays->count; r++)
+	{
+		ray.direction = rays->dirs[r];
+		for (int i = 0; i < n; i += SCENE_SOA_LANES)
+		{
+			soa_hits(bvh, planes, i, ray, t);
+			for (int k = 0; k < SCENE_SOA_LANES; k++)
+			{
+				if (!intersect_object((planes ? bvh->planes : bvh->objects)
+					[i + k], ray, &ts))
+					ts = INFINITY;
+				if ((ts < INFINITY) != (t[k] < INFINITY))
+					diff++;
+				else if (ts < INFINITY)
+					worst = fmax(worst, fabs(ts - t[k]) / fabs(ts));
+			}
+		}
+	}
+	printf("  hit/miss differences %ld, largest relative t difference %.1e\n",
+		diff, worst);
+	return (diff);
+}
+
+static double	scalar_kernel(t_object **objects, int n,
+					const t_ray_batch *rays, long *hits)
+{
+	double	t0, t;
+	t_ray	ray;
+
+	*hits = 0;
+	ray.origin = rays->origin;
+	t0 = get_time_ms();
+	for (int r = 0; r < rays->count; r++)
+	{
+		ray.direction = rays->dirs[r];
+		for (int i = 0; i < n; i++)
+			*hits += intersect_object(objects[i], ray, &t);
+	}
+	return (get_time_ms() - t0);
+}
+
+static double	simd_kernel(const t_scene_bvh *bvh, int n, int planes,
+					const t_ray_batch *rays, long *hits)
+{
+	double	t0, t[SCENE_SOA_LANES];
+	t_ray	ray;
+
+	*hits = 0;
+	ray.origin = rays->origin;
+	t0 = get_time_ms();
+	for (int r = 0; r < rays->count; r++)
+	{
+		ray.direction = rays->dirs[r];
+		for (int i = 0; i < n; i += SCENE_SOA_LANES)
+		{
+			soa_hits(bvh, planes, i, ray, t);
+			for (int k = 0; k < SCENE_SOA_LANES; k++)
+				*hits += t[k] < INFINITY;
+		}
+	}
+	return (get_time_ms() - t0);
+}
+
+static int	bench_soa(int count, int step)
+{
+	t_scene		scene;
+	t_ray_batch	rays;
+	double		base, ms;
+	long		hits, tests;
+	int			planes;
+
+	if (!make_object_scene(&scene) || !make_top_view_rays(&rays, step))
+		return (1);
+	set_up_scene_spheres(&scene, count);
+	for (int i = 0; i < 64; i++)
+		add_object(&scene, create_plane(&scene.arena, vec3_create(0.0,
+					-2.0 - i, 0.0), vec3_create(0.1 * i, 1.0, -0.05 * i),
+				create_color(0, 0, 0)));
+	if (!scene_bvh_build(&scene.bvh, scene.objects))
+		return (1);
+	count = scene.bvh.object_count / SCENE_SOA_LANES * SCENE_SOA_LANES;
+	planes = scene.bvh.soa.plane_count / SCENE_SOA_LANES * SCENE_SOA_LANES;
+	printf("SoA kernels: %d rays, %d spheres, %d planes (AVX2 %d)\n",
+		rays.count, count, planes, HAS_AVX2);
+	tests = (long)rays.count * count;
+	base = scalar_kernel(scene.bvh.objects, count, &rays, &hits);
+	print_kernel("spheres, intersect_object", base, tests, hits, base);
+	ms = simd_kernel(&scene.bvh, count, 0, &rays, &hits);
+	print_kernel("spheres, sphere_hits4", ms, tests, hits, base);
+	soa_kernel(&scene.bvh, &rays, count, 0);
+	scene.bvh.single = 1;
+	ms = simd_kernel(&scene.bvh, count, 0, &rays, &hits);
+	print_kernel("spheres, sphere_hits4f", ms, tests, hits, base);
+	soa_kernel(&scene.bvh, &rays, count, 0);
+	scene.bvh.single = 0;
+	tests = (long)rays.count * planes;
+	base = scalar_kernel(scene.bvh.planes, planes, &rays, &hits);
+	print_kernel("planes, intersect_object", base, tests, hits, base);
+	ms = simd_kernel(&scene.bvh, planes, 1, &rays, &hits);
+	print_kernel("planes, plane_hits4", ms, tests, hits, base);
+	soa_kernel(&scene.bvh, &rays, planes, 1);
+	scene.bvh.single = 1;
+	ms = simd_kernel(&scene.bvh, planes, 1, &rays, &hits);
+	print_kernel("planes, plane_hits4f", ms, tests, hits, base);
+	soa_kernel(&scene.bvh, &rays, planes, 1);
+	scene_bvh_free(&scene.bvh);
+	arena_destroy(&scene.arena);
+	free(scene.img.pixels_ptr);
+	free(rays.dirs);
+	return (0);
+}
+
+static int	bench_arg(int ac, char **av, int index, int fallback)
+{
+	if (ac > index && atoi(av[index]) > 0)
+		return (atoi(av[index]));
+	return (fallback);
+}
+
+int	run_benchmarks(int ac, char **av)
+{
+	if (ac >= 3 && !ft_strncmp(av[2], "bvh", 4))
+		return (bench_bvh(bench_arg(ac, av, 3, 5), bench_arg(ac, av, 4, 1)));
+	if (ac >= 3 && !ft_strncmp(av[2], "build", 6))
+		return (bench_build(bench_arg(ac, av, 3, 5)));
+	if (ac >= 3 && !ft_strncmp(av[2], "refine", 7))
+		return (bench_refine(bench_arg(ac, av, 3, 4)));
+	if (ac >= 3 && !ft_strncmp(av[2], "implicit", 9))
+		return (bench_implicit(bench_arg(ac, av, 3,
+					MENGER_MAX_IMPLICIT_ITERATIONS), bench_arg(ac, av, 4, 4)));
+	if (ac >= 3 && !ft_strncmp(av[2], "packet", 7))
+		return (bench_packet(bench_arg(ac, av, 3, 5), bench_arg(ac, av, 4, 1)));
+	if (ac >= 3 && !ft_strncmp(av[2], "wide", 5))
+		return (bench_wide(bench_arg(ac, av, 3, 5), bench_arg(ac, av, 4, 1)));
+	if (ac >= 3 && !ft_strncmp(av[2], "occlusion", 10))
+		return (bench_occlusion(bench_arg(ac, av, 3, 5),
+				bench_arg(ac, av, 4, 2)));
+	if (ac >= 3 && !ft_strncmp(av[2], "tiles", 6))
+		return (bench_tiles(bench_arg(ac, av, 3, 4), bench_arg(ac, av, 4, 1),
+				bench_arg(ac, av, 5, 8)));
+	if (ac >= 3 && !ft_strncmp(av[2], "progressive", 12))
+		return (bench_progressive(bench_arg(ac, av, 3, 4),
+				bench_arg(ac, av, 4, 1)));
+	if (ac >= 3 && !ft_strncmp(av[2], "scene", 6))
+		return (bench_scene(bench_arg(ac, av, 3, render_thread_count()),
+				bench_arg(ac, av, 4, 3)));
+	if (ac >= 3 && !ft_strncmp(av[2], "spheres", 8))
+		return (bench_spheres(bench_arg(ac, av, 3, SPHERE_FIELD_COUNT),
+				bench_arg(ac, av, 4, 8)));
+	if (ac >= 3 && !ft_strncmp(av[2], "soa", 4))
+		return (bench_soa(bench_arg(ac, av, 3, 1024),
+				bench_arg(ac, av, 4, 16)));
+	if (ac >= 3 && !ft_strncmp(av[2], "precision", 10))
+		return (bench_precision(bench_arg(ac, av, 3, SPHERE_FIELD_COUNT)));
+	if (ac >= 3 && !ft_strncmp(av[2], "adaptive", 9))
+		return (bench_adaptive(bench_arg(ac, av, 3, 4),
+				bench_arg(ac, av, 4, 20)));
+	if (ac >= 3 && !ft_strncmp(av[2], "camera", 7))
+		return (bench_camera(bench_arg(ac, av, 3, 10)));
+	if (ac >= 3 && !ft_strncmp(av[2], "pool", 5))
+		return (bench_pool(bench_arg(ac, av, 3, render_thread_count()),
+				bench_arg(ac, av, 4, 1000)));
+	if (ac >= 3 && !ft_strncmp(av[2], "arena", 6))
+		return (bench_arena(bench_arg(ac, av, 3, 4)));
+	if (ac >= 3 && !ft_strncmp(av[2], "aabb", 5))
+		return (bench_aabb(bench_arg(ac, av, 3, 16)));
+	write_string_to_file_descriptor("Usage: ./minirt bench <name> [args]\n"
+		"  bvh [max_iterations=5] [pixel_step=1]\n"
+		"  build [max_iterations=5]\n"
+		"  refine [max_iterations=4]\n"
+		"  implicit [max_iterations=12] [pixel_step=4]\n"
+		"  packet [max_iterations=5] [pixel_step=1]\n"
+		"  wide [max_iterations=5] [pixel_step=1]\n"
+		"  occlusion [max_iterations=5] [pixel_step=2]\n"
+		"  arena [max_iterations=4]\n"
+		"  tiles [iterations=4] [resolution=1] [threads=8]\n"
+		"  progressive [iterations=4] [resolution=1]\n"
+		"  scene [max_threads=cores] [frames=3]\n"
+		"  spheres [count=10000] [pixel_step=8]\n"
+		"  soa [spheres=1024] [pixel_step=16]\n"
+		"  precision [spheres=10000]\n"
+		"  adaptive [iterations=4] [frames=20]\n"
+		"  camera [frames=10]\n"
+		"  pool [threads=cores] [frames=1000]\n"
+		"  aabb [pixel_step=16]\n", STDERR_FILENO);
+	return (1);
+}
@@ -19,18 +19,23 @@ void display_status(t_scene *scene)
 {
 	char status[100];
 
-	if (!ft_strncmp(scene->name, "sphere", 6))
+	if (ft_strncmp(scene->name, "menger", 6))
 	{
-		// Simple sphere status
-		snprintf(status, 100, "Simple Sphere | Camera: (%.1f, %.1f, %.1f)",
-				scene->camera.position.x, scene->camera.position.y, scene->camera.position.z);
+		// Object scene status (plane or spheres)
+		snprintf(status, 100, "Simple Sphere | Camera: (%.1f, %.1f, %.1f) | %s%s",
+				scene->camera.position.x, scene->camera.position.y, scene->camera.position.z,
+				scene->bvh.single ? "float" : "double",
+				scene->adaptive.enabled ? " | Adaptive" : "");
 	}
 	// Format status text based on scene type
 	else if (scene->is_3d)
 	{
 		// 3D mode status
-		snprintf(status, 100, "3D Mode | Iterations: %d | Resolution: %d",
-				scene->menger.iterations, scene->resolution_factor);
+		snprintf(status, 100, "3D Mode | Iterations: %d | Resolution: %d | %s%s",
+				scene->menger.iterations, scene->resolution_factor,
+				scene->menger.mode == MENGER_MODE_IMPLICIT ? "Implicit"
+				: scene->menger.mode == MENGER_MODE_WIDE ? "Wide BVH" : "BVH",
+				scene->adaptive.enabled ? " | Adaptive" : "");
 	}
 	else
 	{
@@ -58,13 +63,18 @@ int	close_handler(t_scene *scene)
 		return (0);
 	freed = 1;
 
+	// Stop the frame thread before anything it reads goes away
+	render_async_stop(scene);
 	cleanup_scene(scene);
+	render_pool_destroy(&scene->pool);
 
 	// Free BVH for Menger sponge if it exists
-	if (!ft_strncmp(scene->name, "menger", 6) && scene->menger.bvh_root)
+	if (!ft_strncmp(scene->name, "menger", 6))
 	{
-		free_bvh(scene->menger.bvh_root);
-		scene->menger.bvh_root = NULL;
+		free_bvh(scene->menger.bvh);
+		scene->menger.bvh = NULL;
+		free_wide_bvh(scene->menger.wide);
+		scene->menger.wide = NULL;
 	}
 
 	// Clear all other resources
@@ -95,6 +105,17 @@ int	close_handler(t_scene *scene)
 	return (0);
 }
 
+// The camera or the view changed: frames go to the frame budget until
+// the input stops
+static void	render_view(t_scene *scene)
+{
+	adaptive_input(&scene->adaptive);
+	if (!ft_strncmp(scene->name, "menger", 6))
+		render_menger_sponge(scene);
+	else
+		render_complex_scene(scene);
+}
+
 //Used
 int	key_handler(int keysym, t_scene *scene)
 {
@@ -219,10 +240,7 @@ int	key_handler(int keysym, t_scene *scene)
 	// Re-render if camera has changed
 	if (camera_changed)
 	{
-		if (!ft_strncmp(scene->name, "sphere", 6))
-			render_complex_scene(scene);
-		else if (!ft_strncmp(scene->name, "menger", 6))
-			render_menger_sponge(scene);
+		render_view(scene);
 		return (0);
 	}
 	// Reset camera position
@@ -233,10 +251,7 @@ int	key_handler(int keysym, t_scene *scene)
 #endif
 	{
 		scene->camera.position = (t_vec3){0.0, 0.0, -5.0};
-		if (!ft_strncmp(scene->name, "sphere", 6))
-			render_complex_scene(scene);
-		else if (!ft_strncmp(scene->name, "menger", 6))
-			render_menger_sponge(scene);
+		render_view(scene);
 		return (0);
 	}
 	#ifdef __APPLE__
@@ -247,7 +262,14 @@ int	key_handler(int keysym, t_scene *scene)
 		{
 			if (!ft_strncmp(scene->name, "menger", 6))
 			{
-				if (scene->menger.iterations < 10)
+				if (scene->menger.iterations < menger_max_iterations(scene)
+					&& scene->menger.mode == MENGER_MODE_IMPLICIT)
+				{
+					// Nothing to rebuild, the traversal follows the level
+					scene->menger.iterations++;
+					render_menger_sponge(scene);
+				}
+				else if (scene->menger.iterations < menger_max_iterations(scene))
 				{
 					// Show loading message before reconstruction
 					display_progress(scene, "Rebuilding Menger sponge...");
@@ -255,10 +277,7 @@ int	key_handler(int keysym, t_scene *scene)
 
 					// Update iterations and rebuild BVH
 					scene->menger.iterations++;
-					if (scene->menger.bvh_root)
-						free_bvh(scene->menger.bvh_root);
-					scene->menger.bvh_root = build_menger_bvh(scene->menger.iterations);
-					if (!scene->menger.bvh_root)
+					if (!menger_rebuild(scene, scene->menger.iterations))
 					{
 						scene->menger.iterations--;
 					}
@@ -276,7 +295,13 @@ int	key_handler(int keysym, t_scene *scene)
 		{
 			if (!ft_strncmp(scene->name, "menger", 6))
 			{
-				if (scene->menger.iterations > 0)
+				if (scene->menger.iterations > 0
+					&& scene->menger.mode == MENGER_MODE_IMPLICIT)
+				{
+					scene->menger.iterations--;
+					render_menger_sponge(scene);
+				}
+				else if (scene->menger.iterations > 0)
 				{
 					// Show loading message before reconstruction
 					display_progress(scene, "Rebuilding Menger sponge...");
@@ -284,10 +309,7 @@ int	key_handler(int keysym, t_scene *scene)
 
 					// Update iterations and rebuild BVH
 					scene->menger.iterations--;
-					if (scene->menger.bvh_root)
-						free_bvh(scene->menger.bvh_root);
-					scene->menger.bvh_root = build_menger_bvh(scene->menger.iterations);
-					if (!scene->menger.bvh_root)
+					if (!menger_rebuild(scene, scene->menger.iterations))
 					{
 						scene->menger.iterations++;
 					}
@@ -297,6 +319,43 @@ int	key_handler(int keysym, t_scene *scene)
 				}
 			}
 		}
+		// Cycle Menger traversal: BVH, wide BVH, implicit subdivision
+#ifdef __APPLE__
+		else if (keysym == KEY_B)
+#else
+		else if (keysym == XK_b)
+#endif
+		{
+			if (!ft_strncmp(scene->name, "menger", 6))
+			{
+				menger_toggle_mode(scene);
+				render_menger_sponge(scene);
+			}
+		}
+		// Adaptive resolution while moving, on or off
+#ifdef __APPLE__
+		else if (keysym == KEY_V)
+#else
+		else if (keysym == XK_v)
+#endif
+		{
+			scene->adaptive.enabled = !scene->adaptive.enabled;
+			scene->adaptive.moving = 0;
+			display_status(scene);
+		}
+		// Object scene precision: double or float kernels
+#ifdef __APPLE__
+		else if (keysym == KEY_P)
+#else
+		else if (keysym == XK_p)
+#endif
+		{
+			if (ft_strncmp(scene->name, "menger", 6) && scene->bvh.built)
+			{
+				scene->bvh.single = !scene->bvh.single;
+				render_complex_scene(scene);
+			}
+		}
 		// Resolution control for performance
 #ifdef __APPLE__
 		else if (keysym == KEY_bracketleft && scene->resolution_factor < 16)
@@ -331,10 +390,7 @@ int	key_handler(int keysym, t_scene *scene)
 		{
 			scene->camera.position = (t_vec3){0, 0, -3};
 			scene->camera.rotation = (t_vec3){0, 0, 0};
-			if (!ft_strncmp(scene->name, "menger", 6))
-				render_menger_sponge(scene);
-			else if (!ft_strncmp(scene->name, "sphere", 6))
-				render_complex_scene(scene);
+			render_view(scene);
 		}
 		// Debug camera positions
 #ifdef __APPLE__
@@ -345,10 +401,7 @@ int	key_handler(int keysym, t_scene *scene)
 		{
 			scene->camera.position = (t_vec3){0.0, 0.0, -4.0};
 			scene->camera.rotation = (t_vec3){0.0, 0.0, 0.0};
-			if (!ft_strncmp(scene->name, "menger", 6))
-				render_menger_sponge(scene);
-			else if (!ft_strncmp(scene->name, "sphere", 6))
-				render_complex_scene(scene);
+			render_view(scene);
 		}
 #ifdef __APPLE__
 		else if (keysym == KEY_2)
@@ -358,10 +411,7 @@ int	key_handler(int keysym, t_scene *scene)
 		{
 			scene->camera.position = (t_vec3){4.0, 0.0, 0.0}; //camera on the right side
 			scene->camera.rotation = (t_vec3){0.0, -1.57, 0.0}; //-90 degrees angle around Y
-			if (!ft_strncmp(scene->name, "menger", 6))
-				render_menger_sponge(scene);
-			else if (!ft_strncmp(scene->name, "sphere", 6))
-				render_complex_scene(scene);
+			render_view(scene);
 		}
 #ifdef __APPLE__
 		else if (keysym == KEY_3)
@@ -371,10 +421,7 @@ int	key_handler(int keysym, t_scene *scene)
 		{
 			scene->camera.position = (t_vec3){0.0, 4.0, 2.0};
 			scene->camera.rotation = (t_vec3){1.57, 0.0, 0.0};
-			if (!ft_strncmp(scene->name, "menger", 6))
-				render_menger_sponge(scene);
-			else if (!ft_strncmp(scene->name, "sphere", 6))
-				render_complex_scene(scene);
+			render_view(scene);
 		}
 #ifdef __APPLE__
 		else if (keysym == KEY_4)
@@ -384,10 +431,7 @@ int	key_handler(int keysym, t_scene *scene)
 		{
 			scene->camera.position = (t_vec3){2.4, 0.4, -2.8};
 			scene->camera.rotation = (t_vec3){0.15, -0.7, 0.0};
-			if (!ft_strncmp(scene->name, "menger", 6))
-				render_menger_sponge(scene);
-			else if (!ft_strncmp(scene->name, "sphere", 6))
-				render_complex_scene(scene);
+			render_view(scene);
 		}
 #ifdef __APPLE__
 		else if (keysym == KEY_5)
@@ -397,10 +441,7 @@ int	key_handler(int keysym, t_scene *scene)
 		{
 			scene->camera.position = (t_vec3){2.4, 2.0, -2.8};
 			scene->camera.rotation = (t_vec3){0.45, -0.7, 0.0};
-			if (!ft_strncmp(scene->name, "menger", 6))
-				render_menger_sponge(scene);
-			else if (!ft_strncmp(scene->name, "sphere", 6))
-				render_complex_scene(scene);
+			render_view(scene);
 		}
 #ifdef __APPLE__
 else if (keysym == KEY_6)
@@ -410,10 +451,7 @@ else if (keysym == XK_6) //Side view (left)
 		{
 			scene->camera.position = (t_vec3){-4.0, 0.0, 1.0}; //camera on the left side
 			scene->camera.rotation = (t_vec3){0.0, 1.57, 0.0};; // 90 degrees angle around Y
-			if (!ft_strncmp(scene->name, "menger", 6))
-				render_menger_sponge(scene);
-			else
-				render_complex_scene(scene);
+			render_view(scene);
 		}
 #ifdef __APPLE__
 else if (keysym == KEY_7)
@@ -424,10 +462,7 @@ else if (keysym == XK_7) //Bottom view
 			// Position to look at the bottom cap
 			scene->camera.position = vec3_create(0.0, -4.0, 2.0);
 			scene->camera.rotation = vec3_create(-1.57, 0.0, 0.0); // Look straight up
-			if (!ft_strncmp(scene->name, "menger", 6))
-				render_menger_sponge(scene);
-			else
-				render_complex_scene(scene);
+			render_view(scene);
 		}
 
 		// Ensure we're in 3D mode and render
@@ -699,6 +734,7 @@ int	mouse_handler(int button, int x, int y, t_scene *scene)
 	// For 3D mode - handle camera controls
 	if (scene->is_3d)
 	{
+		adaptive_input(&scene->adaptive);
 		// Adjust camera position based on mouse scroll
 #ifdef __APPLE__
 		if (button == MOUSE_SCROLL_DOWN)  // Zoom out
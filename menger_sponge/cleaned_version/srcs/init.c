@@ -31,6 +31,7 @@ static void	data_init(t_scene *scene)
 	scene->ambient.color = create_color(255,255 ,255); //white by default
 	scene->lights = NULL;
 	scene->objects = NULL;
+	arena_init(&scene->arena, ARENA_DEFAULT_BLOCK);
 
 	//Bonus
 	scene->sample = 1;
@@ -47,6 +48,8 @@ static void	data_init(t_scene *scene)
 	scene->prev_mouse_x = 0;
 	scene->prev_mouse_y = 0;
 	scene->resolution_factor = 4;  // Default resolution factor
+	scene->refine = 0;
+	adaptive_init(&scene->adaptive);
 
 	// Initialize camera defaults for 3D scenes
 	scene->is_3d = 0;  // Default to 2D mode - needs to be cleaned out
@@ -59,10 +62,12 @@ static void	data_init(t_scene *scene)
 
 	// Initialize Menger sponge defaults
 	scene->menger.iterations = 0;
+	scene->menger.mode = MENGER_MODE_BVH;
 	scene->menger.size = 1.0;
 	scene->menger.position = (t_vec3){0.0, 0.0, 0.0};
 	scene->menger.rotation = (t_vec3){0.0, 0.0, 0.0};
-	scene->menger.bvh_root = NULL;
+	scene->menger.bvh = NULL;
+	scene->menger.wide = NULL;
 }
 
 //Used
@@ -73,6 +78,7 @@ static void	events_init(t_scene *scene)
 	mlx_hook(scene->mlx_window, 4, 1L<<2, mouse_handler, scene);
 	mlx_hook(scene->mlx_window, 5, 1L<<3, mouse_release, scene);
 	mlx_hook(scene->mlx_window, 17, 0, close_handler, scene);
+	mlx_loop_hook(scene->mlx_connection, render_loop_hook, scene);
 #else
 	mlx_hook(scene->mlx_window, KeyPress,
 		KeyPressMask, key_handler, scene);
@@ -82,6 +88,7 @@ static void	events_init(t_scene *scene)
 		ButtonReleaseMask, mouse_release, scene);
 	mlx_hook(scene->mlx_window, DestroyNotify,
 		StructureNotifyMask, close_handler, scene);
+	mlx_loop_hook(scene->mlx_connection, render_loop_hook, scene);
 #endif
 }
 
@@ -122,4 +129,6 @@ void	scene_init(t_scene *scene)
 	data_init(scene);
 	scene_mlx_init(scene);
 	events_init(scene);
+	render_pool_init(&scene->pool, render_thread_count());
+	render_async_start(scene);
 }
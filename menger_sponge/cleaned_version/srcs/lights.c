@@ -13,11 +13,12 @@
 #include "platform.h"
 
 //Note: need to create color struct beforehand
-t_light	*create_light(t_vec3 position, double intensity, t_color color)
+t_light	*create_light(t_arena *arena, t_vec3 position, double intensity,
+			t_color color)
 {
 	t_light	*light;
 
-	light = malloc(sizeof(t_light));
+	light = arena_alloc(arena, sizeof(t_light));
 	if (!light)
 		return (NULL);
 	light->color = color;
@@ -13,31 +13,18 @@
 #include "platform.h"
 #include <string.h>
 
+//Lights, objects and their data all sit in the scene arena
 void cleanup_scene(t_scene *scene)
 {
-	t_object *obj;
-	t_object *next_obj;
-	t_light *light;
-	t_light *next_light;
-
 	if (!scene)
 		return;
-	obj = scene->objects;
-	while (obj)
-	{
-		next_obj = obj->next;
-		if (obj->data)
-			free(obj->data);
-		free(obj);
-		obj = next_obj;
-	}
-	light = scene->lights;
-	while (light)
-	{
-		next_light = light->next;
-		free(light);
-		light = next_light;
-	}
+#ifdef DEBUG
+	arena_print_stats(&scene->arena, "scene");
+#endif
+	scene_bvh_free(&scene->bvh);
+	arena_destroy(&scene->arena);
+	scene->objects = NULL;
+	scene->lights = NULL;
 }
 
 void	start_raytracer(t_scene *scene, char *name)
@@ -45,6 +32,11 @@ void	start_raytracer(t_scene *scene, char *name)
 	scene->name = name;
 	scene_init(scene);
 	//init_3d(scene);
+	if (!scene->objects && !ft_strncmp(name, "spheres", 7))
+		set_up_scene_spheres(scene, SPHERE_FIELD_COUNT);
+	else if (!scene->objects)
+		set_up_scene_plane(scene);
+	scene_bvh_build(&scene->bvh, scene->objects);
 
 	//render_simple_scene(scene);
 	render_complex_scene(scene);
@@ -82,6 +74,8 @@ int	main(int ac, char **av)
 	//	int test_number = atoi(av[2]);
 	//	setup_camera_test_position(&scene, test_number);
 	//}
+	if (ac >= 2 && !ft_strncmp(av[1], "bench", 6))
+		return (run_benchmarks(ac, av));
 	if (ac == 2)
 		start_raytracer(&scene, av[1]);
 	else
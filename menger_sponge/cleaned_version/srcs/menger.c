@@ -15,33 +15,25 @@
 #include <stdlib.h>
 #include <pthread.h>
 
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-# include <arm_neon.h>
-# define HAS_NEON 1
-#else
-# define HAS_NEON 0
-#endif
-
-// Only use SIMD on platforms where it's available
-#if HAS_NEON
-#define ray_intersect_aabb ray_intersect_aabb_simd
-#else
-#define ray_intersect_aabb ray_intersect_aabb_scalar
-#endif
-
-// Add this structure near the top of the file, after the includes
+// Per-frame render state shared by all tiles, plus the bounds of the tile
+// being drawn (set on a local copy)
 typedef struct s_menger_thread_data
 {
     t_scene   *scene;
-    int         start_y;
+    t_camera    camera; // copy with the basis set up for this pass
+    t_vec3      light_dir;
+    int         step; // sample spacing of this pass, fills step x step
+    int         reuse; // samples on the step * 2 grid are already drawn
+    int         end_x;
     int         end_y;
 } t_menger_thread_data;
 
 
-// Function to create and initialize a new BVH node
-static t_bvh_node *create_bvh_node(t_aabb bounds, int is_leaf, int iteration)
+// Function to create and initialize a new BVH node, taken from the tree's arena
+static t_bvh_node *create_bvh_node(t_arena *arena, t_aabb bounds, int is_leaf,
+                                   int iteration)
 {
-    t_bvh_node *node = (t_bvh_node *)malloc(sizeof(t_bvh_node));
+    t_bvh_node *node = (t_bvh_node *)arena_alloc(arena, sizeof(t_bvh_node));
     if (!node)
         return (NULL);
 
@@ -55,19 +47,17 @@ static t_bvh_node *create_bvh_node(t_aabb bounds, int is_leaf, int iteration)
 }
 
 
-// Recursive function to build a BVH for the Menger sponge
-t_bvh_node *build_menger_bvh_recursive(t_aabb bounds, int current_iter, int max_iter)
+// Recursive function to build a pointer BVH for the Menger sponge
+// (kept as the reference layout for the flat BVH benchmark)
+t_bvh_node *build_menger_bvh_recursive(t_arena *arena, t_aabb bounds,
+                                       int current_iter, int max_iter)
 {
     // Base case: if we've reached the maximum iterations or we're at depth 0
     if (current_iter <= 0)
     {
-        return create_bvh_node(bounds, 1, current_iter);
+        return create_bvh_node(arena, bounds, 1, current_iter);
     }
 
-    t_bvh_node *node = create_bvh_node(bounds, 0, current_iter);
-    if (!node)
-        return (NULL);
-
     // Calculate dimensions of the current box
     double width = bounds.max.x - bounds.min.x;
 
@@ -103,113 +93,73 @@ t_bvh_node *build_menger_bvh_recursive(t_aabb bounds, int current_iter, int max_
                 sub_bounds.max.z = sub_bounds.min.z + sub_size;
 
                 // Recursively build a BVH for this sub-cube (with decreased iteration)
-                t_bvh_node *child = build_menger_bvh_recursive(sub_bounds, current_iter - 1, max_iter);
+                t_bvh_node *child = build_menger_bvh_recursive(arena, sub_bounds, current_iter - 1, max_iter);
 
-                if (child)
-                {
-                    // Store this child for later binary tree construction
-                    children[child_count++] = child;
-                }
+                // Nothing to clean up on failure, the arena owns every node
+                if (!child)
+                    return (NULL);
+                // Store this child for later binary tree construction
+                children[child_count++] = child;
             }
         }
     }
 
     // Now build a balanced binary tree from the collected children
-    if (child_count > 0)
+    // Repeatedly merge pairs of nodes until we have a single root; the
+    // merged root stands for this cell, so no node is allocated up front
+    while (child_count > 1)
     {
-        // For simplicity, we'll use a naive approach to build a roughly balanced tree
-        // Repeatedly merge pairs of nodes until we have a single root
-        while (child_count > 1)
+        int new_count = 0;
+        for (int i = 0; i < child_count; i += 2)
         {
-            int new_count = 0;
-            for (int i = 0; i < child_count; i += 2)
+            if (i + 1 < child_count)
             {
-                if (i + 1 < child_count)
-                {
-                    // Create an internal node for this pair
-                    t_aabb combined_bounds;
-
-                    // Compute combined bounds
-                    combined_bounds.min.x = fmin(children[i]->bounds.min.x, children[i+1]->bounds.min.x);
-                    combined_bounds.min.y = fmin(children[i]->bounds.min.y, children[i+1]->bounds.min.y);
-                    combined_bounds.min.z = fmin(children[i]->bounds.min.z, children[i+1]->bounds.min.z);
-
-                    combined_bounds.max.x = fmax(children[i]->bounds.max.x, children[i+1]->bounds.max.x);
-                    combined_bounds.max.y = fmax(children[i]->bounds.max.y, children[i+1]->bounds.max.y);
-                    combined_bounds.max.z = fmax(children[i]->bounds.max.z, children[i+1]->bounds.max.z);
-
-                    t_bvh_node *parent = create_bvh_node(combined_bounds, 0, current_iter);
-                    parent->left = children[i];
-                    parent->right = children[i+1];
-
-                    children[new_count++] = parent;
-                }
-                else
-                {
-                    // Odd number of nodes, just keep this one
-                    children[new_count++] = children[i];
-                }
-            }
-            child_count = new_count;
-        }
+                // Create an internal node for this pair
+                t_aabb combined_bounds;
 
-        // The final node becomes the root's left child
-        if (child_count == 1)
-        {
-            // Free the original node and use the combined one instead
-            t_bvh_node *temp = node;
-            node = children[0];
+                // Compute combined bounds
+                combined_bounds.min.x = fmin(children[i]->bounds.min.x, children[i+1]->bounds.min.x);
+                combined_bounds.min.y = fmin(children[i]->bounds.min.y, children[i+1]->bounds.min.y);
+                combined_bounds.min.z = fmin(children[i]->bounds.min.z, children[i+1]->bounds.min.z);
+
+                combined_bounds.max.x = fmax(children[i]->bounds.max.x, children[i+1]->bounds.max.x);
+                combined_bounds.max.y = fmax(children[i]->bounds.max.y, children[i+1]->bounds.max.y);
+                combined_bounds.max.z = fmax(children[i]->bounds.max.z, children[i+1]->bounds.max.z);
 
-            // Update iteration value from the original node
-            node->iteration = temp->iteration;
+                t_bvh_node *parent = create_bvh_node(arena, combined_bounds, 0, current_iter);
+                if (!parent)
+                    return (NULL);
+                parent->left = children[i];
+                parent->right = children[i+1];
 
-            free(temp);
+                children[new_count++] = parent;
+            }
+            else
+            {
+                // Odd number of nodes, just keep this one
+                children[new_count++] = children[i];
+            }
         }
-    }
-    else
-    {
-        // If we didn't add any children, make this a leaf
-        node->is_leaf = 1;
+        child_count = new_count;
     }
 
-    return node;
+    // If we didn't add any children, make this a leaf
+    if (child_count == 0)
+        return create_bvh_node(arena, bounds, 1, current_iter);
+    children[0]->iteration = current_iter;
+    return children[0];
 }
 
 
-// Main function to build the BVH
-t_bvh_node *build_menger_bvh(int max_iterations)
+// Main function to build the pointer BVH. All nodes come from `arena`,
+// which frees the whole tree at once.
+t_bvh_node *build_menger_bvh_tree(t_arena *arena, int max_iterations)
 {
     t_aabb bounds;
     bounds.min = (t_vec3){-1.0, -1.0, -1.0};
     bounds.max = (t_vec3){1.0, 1.0, 1.0};
 
-    return build_menger_bvh_recursive(bounds, max_iterations, max_iterations);
-}
-
-
-// Free the BVH tree
-void free_bvh(t_bvh_node *node)
-{
-    if (!node)
-    {
-        return;
-    }
-
-    // Free children first
-    if (node->left)
-    {
-        free_bvh(node->left);
-        node->left = NULL;
-    }
-
-    if (node->right)
-    {
-        free_bvh(node->right);
-        node->right = NULL;
-    }
-
-    // Finally free this node
-    free(node);
+    return build_menger_bvh_recursive(arena, bounds, max_iterations, max_iterations);
 }
 
 
@@ -343,8 +293,8 @@ int ray_intersect_aabb_simd(t_aabb bounds, t_vec3 origin, t_vec3 dir, double *ou
 #endif
 
 
-//optimized version of the ray_intersect_bvh function
-int ray_intersect_bvh(t_bvh_node *node, t_vec3 ray_origin, t_vec3 ray_dir,
+//optimized version of the ray_intersect_bvh function (pointer tree)
+int ray_intersect_bvh_tree(t_bvh_node *node, t_vec3 ray_origin, t_vec3 ray_dir,
                       double *t_min, double *t_max)
 {
     if (!node)
@@ -390,14 +340,14 @@ int ray_intersect_bvh(t_bvh_node *node, t_vec3 ray_origin, t_vec3 ray_dir,
     }
 
     double temp_min, temp_max;
-    if (ray_intersect_bvh(first, ray_origin, ray_dir, &temp_min, &temp_max)) {
+    if (ray_intersect_bvh_tree(first, ray_origin, ray_dir, &temp_min, &temp_max)) {
         *t_min = temp_min;
         *t_max = temp_max;
 
         // Check second child only if it might have a closer hit
         if (second && second_tmin < temp_min) {
             double other_min, other_max;
-            if (ray_intersect_bvh(second, ray_origin, ray_dir, &other_min, &other_max) && other_min < *t_min) {
+            if (ray_intersect_bvh_tree(second, ray_origin, ray_dir, &other_min, &other_max) && other_min < *t_min) {
                 *t_min = other_min;
                 *t_max = other_max;
             }
@@ -406,7 +356,7 @@ int ray_intersect_bvh(t_bvh_node *node, t_vec3 ray_origin, t_vec3 ray_dir,
     }
 
     // If first missed, try second
-    if (second && ray_intersect_bvh(second, ray_origin, ray_dir, &temp_min, &temp_max)) {
+    if (second && ray_intersect_bvh_tree(second, ray_origin, ray_dir, &temp_min, &temp_max)) {
         *t_min = temp_min;
         *t_max = temp_max;
         return 1;
@@ -502,12 +452,14 @@ void	init_3d(t_scene *scene)
 	scene->menger.size = 1.0;
 	scene->menger.position = (t_vec3){0, 0, 0};
 	scene->menger.rotation = (t_vec3){0, 0, 0};
+	scene->menger.mode = MENGER_MODE_BVH;
 
-	// Initialize the BVH root to NULL
-	scene->menger.bvh_root = NULL;
+	// Initialize the BVH to NULL
+	scene->menger.bvh = NULL;
+	scene->menger.wide = NULL;
 
-	// Build the BVH for the Menger sponge
-	scene->menger.bvh_root = build_menger_bvh(scene->menger.iterations);
+	// Build the flat BVH for the Menger sponge
+	scene->menger.bvh = build_menger_bvh(scene->menger.iterations);
 
 	// Set a reasonable default resolution factor for performance
 	scene->resolution_factor = 2;  // Higher quality default (smaller value)
@@ -567,171 +519,408 @@ static int is_menger_iteration(t_vec3 point, int iterations)
 #endif
 
 
-//optimized version of the render_menger_sponge function (inline pixel fill)
-void *render_menger_thread(void *arg)
+// Closest hit on the sponge through the selected traversal backend
+static int menger_intersect(t_scene *scene, t_vec3 ray_origin, t_vec3 ray_dir,
+                            double *t_min, double *t_max)
 {
-	t_menger_thread_data *data = (t_menger_thread_data *)arg;
-	t_scene *scene = data->scene;
-	t_img *img = &scene->img;
-	int res = scene->resolution_factor;
-	int bpp_bytes = img->bpp / 8;
+    if (scene->menger.mode == MENGER_MODE_IMPLICIT)
+        return ray_intersect_menger_implicit(scene->menger.iterations,
+                                             ray_origin, ray_dir, t_min, t_max);
+    if (scene->menger.mode == MENGER_MODE_WIDE)
+        return ray_intersect_wide_bvh(scene->menger.wide, ray_origin, ray_dir, t_min, t_max);
+    return ray_intersect_bvh(scene->menger.bvh, ray_origin, ray_dir, t_min, t_max);
+}
+
+
+// Any-hit counterpart of menger_intersect, for rays that only need to know
+// whether something is in the way (reflections, shadows)
+static int menger_occluded(t_scene *scene, t_vec3 ray_origin, t_vec3 ray_dir)
+{
+    if (scene->menger.mode == MENGER_MODE_IMPLICIT)
+        return ray_occluded_menger_implicit(scene->menger.iterations,
+                                            ray_origin, ray_dir);
+    if (scene->menger.mode == MENGER_MODE_WIDE)
+        return ray_occluded_wide_bvh(scene->menger.wide, ray_origin, ray_dir);
+    return ray_occluded_bvh(scene->menger.bvh, ray_origin, ray_dir);
+}
+
 
-	t_vec3 ray_dir, ray_pos, hit_point, normal, reflect_dir;
-	double t_min, t_max;
+// Highest iteration count the current backend can render
+int menger_max_iterations(t_scene *scene)
+{
+    if (scene->menger.mode == MENGER_MODE_IMPLICIT)
+        return MENGER_MAX_IMPLICIT_ITERATIONS;
+    return MENGER_MAX_BVH_ITERATIONS;
+}
+
+
+// +/- move one level at a time: the current BVH is refined or pruned in
+// place instead of rebuilt. NULL means do a full build (old BVH intact).
+static t_flat_bvh *menger_step_bvh(t_flat_bvh *bvh, int iterations)
+{
+    if (!bvh)
+        return NULL;
+    if (iterations == bvh->iterations + 1)
+        return refine_menger_bvh(bvh);
+    if (iterations == bvh->iterations - 1)
+        return prune_menger_bvh(bvh);
+    return NULL;
+}
+
+// Build what the current mode traverses at `iterations` and swap it in.
+// On failure the previous structure is kept and 0 is returned. Wide mode
+// drops back to the binary BVH below MENGER_WIDE_MIN_ITERATIONS.
+int menger_rebuild(t_scene *scene, int iterations)
+{
+    t_flat_bvh *bvh;
+    t_wide_bvh *wide;
+
+    // The frame thread may be tracing the structure about to be replaced
+    render_async_wait(scene);
+
+    if (scene->menger.mode == MENGER_MODE_IMPLICIT)
+        return 1;
+    if (iterations > MENGER_MAX_BVH_ITERATIONS)
+        return 0;
+    bvh = menger_step_bvh(scene->menger.bvh, iterations);
+    if (bvh)
+    {
+        scene->menger.bvh = bvh;
+        return 1;
+    }
+    bvh = build_menger_bvh(iterations);
+    if (!bvh)
+        return 0;
+    // Too shallow for the wide BVH to pay off, keep the binary one
+    if (scene->menger.mode == MENGER_MODE_WIDE
+        && iterations < MENGER_WIDE_MIN_ITERATIONS)
+    {
+        free_wide_bvh(scene->menger.wide);
+        scene->menger.wide = NULL;
+        scene->menger.mode = MENGER_MODE_BVH;
+    }
+    if (scene->menger.mode == MENGER_MODE_BVH)
+    {
+        free_bvh(scene->menger.bvh);
+        scene->menger.bvh = bvh;
+        return 1;
+    }
+    // The wide BVH is collapsed from the binary one, which is then dropped
+    wide = build_menger_wide_bvh(bvh);
+    free_bvh(bvh);
+    if (!wide)
+        return 0;
+    free_wide_bvh(scene->menger.wide);
+    scene->menger.wide = wide;
+    return 1;
+}
+
+
+// Cycle BVH -> wide BVH -> implicit traversal. Only the structure of the
+// active mode is kept; if it can't be built at this depth we go implicit.
+// The wide BVH is skipped below MENGER_WIDE_MIN_ITERATIONS.
+void menger_toggle_mode(t_scene *scene)
+{
+    render_async_wait(scene);
+    scene->menger.mode = (scene->menger.mode + 1) % MENGER_MODE_COUNT;
+    if (scene->menger.mode == MENGER_MODE_WIDE
+        && scene->menger.iterations < MENGER_WIDE_MIN_ITERATIONS)
+        scene->menger.mode = MENGER_MODE_IMPLICIT;
+    if (scene->menger.mode != MENGER_MODE_IMPLICIT)
+        display_progress(scene, "Building Menger BVH...");
+    if (!menger_rebuild(scene, scene->menger.iterations))
+        scene->menger.mode = MENGER_MODE_IMPLICIT;
+    if (scene->menger.mode != MENGER_MODE_BVH)
+    {
+        free_bvh(scene->menger.bvh);
+        scene->menger.bvh = NULL;
+    }
+    if (scene->menger.mode != MENGER_MODE_WIDE)
+    {
+        free_wide_bvh(scene->menger.wide);
+        scene->menger.wide = NULL;
+    }
+}
+
+
+// Shading of the plain cube (iteration 0)
+static int shade_menger_cube(t_vec3 ray_pos, t_vec3 ray_dir, double t_min, t_vec3 light_dir)
+{
+	t_vec3 hit_point, normal;
+	int color;
+	int exterior_color = 0xAACCDD;
+	int interior_color = 0xFFA500;
+
+	hit_point = (t_vec3){
+		ray_pos.x + ray_dir.x * t_min,
+		ray_pos.y + ray_dir.y * t_min,
+		ray_pos.z + ray_dir.z * t_min
+	};
+
+	double eps = 0.001;
+	normal = (t_vec3){0, 0, 0};
+
+	if (fabs(hit_point.x - 1.0) < eps) normal.x = 1.0;
+	else if (fabs(hit_point.x + 1.0) < eps) normal.x = -1.0;
+	else if (fabs(hit_point.y - 1.0) < eps) normal.y = 1.0;
+	else if (fabs(hit_point.y + 1.0) < eps) normal.y = -1.0;
+	else if (fabs(hit_point.z - 1.0) < eps) normal.z = 1.0;
+	else if (fabs(hit_point.z + 1.0) < eps) normal.z = -1.0;
+
+	color = (normal.x || normal.y || normal.z) ? exterior_color : interior_color;
+
+	// Lighting
+	double dot = -(normal.x * light_dir.x + normal.y * light_dir.y + normal.z * light_dir.z);
+	double intensity = fmax(0.2, 0.2 + fmax(dot, 0.0) * 0.7);
+
+	int r = ((color >> 16) & 0xFF) * intensity;
+	int g = ((color >> 8) & 0xFF) * intensity;
+	int b = (color & 0xFF) * intensity;
+	return (r << 16) | (g << 8) | b;
+}
+
+
+// Shading of a sponge hit at distance t_min, with one reflection ray
+static int shade_menger_hit(t_scene *scene, t_vec3 ray_pos, t_vec3 ray_dir,
+							double t_min, t_vec3 light_dir)
+{
+	t_vec3 hit_point, normal, reflect_dir;
 	int color, is_interior;
-	double fov_scale = tan(scene->camera.fov * M_PI / 360.0);
-	double aspect_ratio = scene->camera.aspect_ratio;
+	int exterior_color = 0xAACCDD;
+	int interior_color = 0xFFA500;
+
+	hit_point = (t_vec3){
+		ray_pos.x + ray_dir.x * t_min,
+		ray_pos.y + ray_dir.y * t_min,
+		ray_pos.z + ray_dir.z * t_min
+	};
+
+	// === Interior/exterior and normal estimation ===
+	double eps = 0.001;
+	double size = 2.0 / pow(3.0, scene->menger.iterations);
+	double ax = fabs(hit_point.x);
+	double ay = fabs(hit_point.y);
+	double az = fabs(hit_point.z);
+
+	is_interior = !(fabs(ax - 1.0) < eps || fabs(ay - 1.0) < eps || fabs(az - 1.0) < eps);
+	normal = (t_vec3){0, 0, 0};
+
+	// Try snapping to cube face boundaries (too many faces to
+	// scan at implicit-only depths, the estimate below is used)
+	for (double b = -1.0 + size;
+		scene->menger.iterations <= MENGER_SNAP_ITERATIONS && b <= 1.0; b += size)
+	{
+		if (fabs(hit_point.x - b) < eps) { normal.x = 1.0; break; }
+		if (fabs(hit_point.y - b) < eps) { normal.y = 1.0; break; }
+		if (fabs(hit_point.z - b) < eps) { normal.z = 1.0; break; }
+		if (fabs(hit_point.x + b) < eps) { normal.x = -1.0; break; }
+		if (fabs(hit_point.y + b) < eps) { normal.y = -1.0; break; }
+		if (fabs(hit_point.z + b) < eps) { normal.z = -1.0; break; }
+	}
+
+	// Fallback: estimate closest normal
+	if (normal.x == 0 && normal.y == 0 && normal.z == 0)
+	{
+		double dx = fmin(fabs(fmod(ax, size)), fabs(size - fmod(ax, size)));
+		double dy = fmin(fabs(fmod(ay, size)), fabs(size - fmod(ay, size)));
+		double dz = fmin(fabs(fmod(az, size)), fabs(size - fmod(az, size)));
+
+		if (dx <= dy && dx <= dz) normal.x = (hit_point.x > 0) ? 1.0 : -1.0;
+		else if (dy <= dx && dy <= dz) normal.y = (hit_point.y > 0) ? 1.0 : -1.0;
+		else normal.z = (hit_point.z > 0) ? 1.0 : -1.0;
+	}
+
+	color = is_interior ? interior_color : exterior_color;
+
+	// Ambient + light
+	double ambient = 0.3;
+	double dot = -(normal.x * light_dir.x + normal.y * light_dir.y + normal.z * light_dir.z);
+	double light_intensity = (dot > 0) ? (ambient + dot * 0.7) : ambient;
+
+	// Reflection
+	double reflectivity = is_interior ? 0.3 : 0.15;
+	reflect_dir = reflect_ray(ray_dir, normal);
+	int reflected_color = get_environment_color(reflect_dir);
+
+	t_vec3 reflect_origin = {
+		hit_point.x + normal.x * 0.001,
+		hit_point.y + normal.y * 0.001,
+		hit_point.z + normal.z * 0.001
+	};
+
+	if (menger_occluded(scene, reflect_origin, reflect_dir))
+	{
+		reflected_color = is_interior ? 0x221100 : 0x8899AA;
+	}
+
+	color = blend_colors(color, reflected_color, reflectivity);
+
+	// Apply lighting
+	int r = ((color >> 16) & 0xFF) * light_intensity;
+	int g = ((color >> 8) & 0xFF) * light_intensity;
+	int b = (color & 0xFF) * light_intensity;
+	return (r << 16) | (g << 8) | b;
+}
 
-	t_vec3 light_dir = {0.5, 0.5, -1.0};
-	double len = sqrt(light_dir.x * light_dir.x + light_dir.y * light_dir.y + light_dir.z * light_dir.z);
-	light_dir.x /= len;
-	light_dir.y /= len;
-	light_dir.z /= len;
 
-	for (int y = data->start_y; y < data->end_y; y += res)
+// Fill the step x step block of one sample, clipped to the tile
+static void fill_menger_block(t_menger_thread_data *data, int x, int y, int color)
+{
+	t_img *img = &data->scene->img;
+	int res = data->step;
+	int bpp_bytes = img->bpp / 8;
+
+	for (int fy = 0; fy < res && (y + fy) < data->end_y; fy++)
 	{
-		for (int x = 0; x < WIDTH; x += res)
+		int row_offset = (y + fy) * img->line_len;
+		for (int fx = 0; fx < res && (x + fx) < data->end_x; fx++)
 		{
-			ray_dir.x = (2.0 * x / (double)WIDTH - 1.0) * fov_scale * aspect_ratio;
-			ray_dir.y = (1.0 - 2.0 * y / (double)HEIGHT) * fov_scale;
-			ray_dir.z = 1.0;
-			ray_dir = rotate_point(ray_dir, scene->camera.rotation);
-			len = sqrt(ray_dir.x * ray_dir.x + ray_dir.y * ray_dir.y + ray_dir.z * ray_dir.z);
-			ray_dir.x /= len;
-			ray_dir.y /= len;
-			ray_dir.z /= len;
-			ray_pos = scene->camera.position;
-			color = BLACK;
-
-			int exterior_color = 0xAACCDD;
-			int interior_color = 0xFFA500;
+			int offset = row_offset + (x + fx) * bpp_bytes;
+			*(unsigned int *)(img->pixels_ptr + offset) = color;
+		}
+	}
+}
+
+
+// One MENGER_PACKET_W x MENGER_PACKET_H tile of samples. With the BVH the
+// primary rays are traced as one packet, samples outside the tile or kept
+// from the previous pass are dead lanes. Reflection rays go through the
+// single ray path.
+static void render_menger_packet(t_menger_thread_data *data, int x, int y)
+{
+	t_scene *scene = data->scene;
+	t_vec3 light_dir = data->light_dir;
+	int res = data->step;
+	t_vec3 origins[MENGER_PACKET_SIZE], dirs[MENGER_PACKET_SIZE];
+	double t_min[MENGER_PACKET_SIZE], t_max[MENGER_PACKET_SIZE];
+	int px[MENGER_PACKET_SIZE], py[MENGER_PACKET_SIZE];
+	int active = 0, hits = 0;
+	t_ray_packet packet;
+	t_aabb cube = {{-1.0, -1.0, -1.0}, {1.0, 1.0, 1.0}};
+
+	for (int lane = 0; lane < MENGER_PACKET_SIZE; lane++)
+	{
+		px[lane] = x + (lane % MENGER_PACKET_W) * res;
+		py[lane] = y + (lane / MENGER_PACKET_W) * res;
+		if (px[lane] >= data->end_x || py[lane] >= data->end_y)
+			continue;
+		if (data->reuse && px[lane] % (res * 2) == 0 && py[lane] % (res * 2) == 0)
+			continue;
+		active |= 1 << lane;
+		origins[lane] = scene->camera.position;
+		dirs[lane] = camera_ray_dir(&data->camera,
+				camera_row(&data->camera, py[lane]), px[lane]);
+	}
+
+	if (scene->menger.iterations == 0)
+	{
+		for (int lane = 0; lane < MENGER_PACKET_SIZE; lane++)
+			if ((active & (1 << lane)) && ray_intersect_aabb(cube, origins[lane],
+					dirs[lane], &t_min[lane], &t_max[lane]) && t_min[lane] > 0)
+				hits |= 1 << lane;
+	}
+	else if (scene->menger.mode == MENGER_MODE_BVH && scene->menger.bvh)
+	{
+		ray_packet_prepare(&packet, origins, dirs, active);
+		hits = ray_intersect_bvh_packet(scene->menger.bvh, &packet, t_min, t_max);
+	}
+	else if (scene->menger.mode != MENGER_MODE_BVH)
+	{
+		for (int lane = 0; lane < MENGER_PACKET_SIZE; lane++)
+			if ((active & (1 << lane)) && menger_intersect(scene, origins[lane],
+					dirs[lane], &t_min[lane], &t_max[lane]))
+				hits |= 1 << lane;
+	}
 
+	for (int lane = 0; lane < MENGER_PACKET_SIZE; lane++)
+	{
+		if (!(active & (1 << lane)))
+			continue;
+		int color = BLACK;
+		if ((hits & (1 << lane)) && t_min[lane] > 0)
+		{
 			if (scene->menger.iterations == 0)
-			{
-				t_aabb cube = {{-1.0, -1.0, -1.0}, {1.0, 1.0, 1.0}};
-				if (ray_intersect_aabb(cube, ray_pos, ray_dir, &t_min, &t_max) && t_min > 0)
-				{
-					hit_point = (t_vec3){
-						ray_pos.x + ray_dir.x * t_min,
-						ray_pos.y + ray_dir.y * t_min,
-						ray_pos.z + ray_dir.z * t_min
-					};
-
-					double eps = 0.001;
-					normal = (t_vec3){0, 0, 0};
-
-					if (fabs(hit_point.x - 1.0) < eps) normal.x = 1.0;
-					else if (fabs(hit_point.x + 1.0) < eps) normal.x = -1.0;
-					else if (fabs(hit_point.y - 1.0) < eps) normal.y = 1.0;
-					else if (fabs(hit_point.y + 1.0) < eps) normal.y = -1.0;
-					else if (fabs(hit_point.z - 1.0) < eps) normal.z = 1.0;
-					else if (fabs(hit_point.z + 1.0) < eps) normal.z = -1.0;
-
-					color = (normal.x || normal.y || normal.z) ? exterior_color : interior_color;
-
-					// Lighting
-					double dot = -(normal.x * light_dir.x + normal.y * light_dir.y + normal.z * light_dir.z);
-					double intensity = fmax(0.2, 0.2 + fmax(dot, 0.0) * 0.7);
-
-					int r = ((color >> 16) & 0xFF) * intensity;
-					int g = ((color >> 8) & 0xFF) * intensity;
-					int b = (color & 0xFF) * intensity;
-					color = (r << 16) | (g << 8) | b;
-				}
-			}
-			else if (scene->menger.bvh_root)
-			{
-				if (ray_intersect_bvh(scene->menger.bvh_root, ray_pos, ray_dir, &t_min, &t_max) && t_min > 0)
-				{
-					hit_point = (t_vec3){
-						ray_pos.x + ray_dir.x * t_min,
-						ray_pos.y + ray_dir.y * t_min,
-						ray_pos.z + ray_dir.z * t_min
-					};
-
-					// === Interior/exterior and normal estimation ===
-					double eps = 0.001;
-					double size = 2.0 / pow(3.0, scene->menger.iterations);
-					double ax = fabs(hit_point.x);
-					double ay = fabs(hit_point.y);
-					double az = fabs(hit_point.z);
-
-					is_interior = !(fabs(ax - 1.0) < eps || fabs(ay - 1.0) < eps || fabs(az - 1.0) < eps);
-					normal = (t_vec3){0, 0, 0};
-
-					// Try snapping to cube face boundaries
-					for (double b = -1.0 + size; b <= 1.0; b += size)
-					{
-						if (fabs(hit_point.x - b) < eps) { normal.x = 1.0; break; }
-						if (fabs(hit_point.y - b) < eps) { normal.y = 1.0; break; }
-						if (fabs(hit_point.z - b) < eps) { normal.z = 1.0; break; }
-						if (fabs(hit_point.x + b) < eps) { normal.x = -1.0; break; }
-						if (fabs(hit_point.y + b) < eps) { normal.y = -1.0; break; }
-						if (fabs(hit_point.z + b) < eps) { normal.z = -1.0; break; }
-					}
-
-					// Fallback: estimate closest normal
-					if (normal.x == 0 && normal.y == 0 && normal.z == 0)
-					{
-						double dx = fmin(fabs(fmod(ax, size)), fabs(size - fmod(ax, size)));
-						double dy = fmin(fabs(fmod(ay, size)), fabs(size - fmod(ay, size)));
-						double dz = fmin(fabs(fmod(az, size)), fabs(size - fmod(az, size)));
-
-						if (dx <= dy && dx <= dz) normal.x = (hit_point.x > 0) ? 1.0 : -1.0;
-						else if (dy <= dx && dy <= dz) normal.y = (hit_point.y > 0) ? 1.0 : -1.0;
-						else normal.z = (hit_point.z > 0) ? 1.0 : -1.0;
-					}
-
-					color = is_interior ? interior_color : exterior_color;
-
-					// Ambient + light
-					double ambient = 0.3;
-					double dot = -(normal.x * light_dir.x + normal.y * light_dir.y + normal.z * light_dir.z);
-					double light_intensity = (dot > 0) ? (ambient + dot * 0.7) : ambient;
-
-					// Reflection
-					double reflectivity = is_interior ? 0.3 : 0.15;
-					reflect_dir = reflect_ray(ray_dir, normal);
-					int reflected_color = get_environment_color(reflect_dir);
-
-					t_vec3 reflect_origin = {
-						hit_point.x + normal.x * 0.001,
-						hit_point.y + normal.y * 0.001,
-						hit_point.z + normal.z * 0.001
-					};
-
-					if (ray_intersect_bvh(scene->menger.bvh_root, reflect_origin, reflect_dir, &t_min, &t_max))
-					{
-						reflected_color = is_interior ? 0x221100 : 0x8899AA;
-					}
-
-					color = blend_colors(color, reflected_color, reflectivity);
-
-					// Apply lighting
-					int r = ((color >> 16) & 0xFF) * light_intensity;
-					int g = ((color >> 8) & 0xFF) * light_intensity;
-					int b = (color & 0xFF) * light_intensity;
-					color = (r << 16) | (g << 8) | b;
-				}
-			}
-
-			// === INLINE PIXEL FILL ===
-			for (int fy = 0; fy < res && (y + fy) < data->end_y; fy++)
-			{
-				int row_offset = (y + fy) * img->line_len;
-				for (int fx = 0; fx < res && (x + fx) < WIDTH; fx++)
-				{
-					int offset = row_offset + (x + fx) * bpp_bytes;
-					*(unsigned int *)(img->pixels_ptr + offset) = color;
-				}
-			}
+				color = shade_menger_cube(origins[lane], dirs[lane], t_min[lane], light_dir);
+			else
+				color = shade_menger_hit(scene, origins[lane], dirs[lane], t_min[lane], light_dir);
 		}
+		fill_menger_block(data, px[lane], py[lane], color);
+	}
+}
+
+
+// Tile callback for the scheduler. Tiles are aligned to the packet grid,
+// so every packet lies inside one tile.
+static void render_menger_tile(void *ctx, int x0, int y0, int x1, int y1)
+{
+	t_menger_thread_data data = *(t_menger_thread_data *)ctx;
+	int res = data.step;
+
+	data.end_x = x1;
+	data.end_y = y1;
+	for (int y = y0; y < y1; y += res * MENGER_PACKET_H)
+	{
+		for (int x = x0; x < x1; x += res * MENGER_PACKET_W)
+			render_menger_packet(&data, x, y);
 	}
+}
+
+
+// One coarse-to-fine pass into scene->img: a sample every `step` pixels,
+// each filling its step x step block. With `reuse` the samples on the
+// step * 2 grid are left as the previous pass drew them. `job` comes back
+// with the per-thread stats; tile_w/tile_h/threads may be set beforehand,
+// 0 means the default, and job->pool picks the threads (NULL starts
+// threads for this pass).
+void render_menger_pass(t_scene *scene, t_tile_job *job, int step, int reuse)
+{
+	t_menger_thread_data data;
+	t_tile_job defaults;
+
+	t_vec3 light_dir = {0.5, 0.5, -1.0};
+	double len = sqrt(light_dir.x * light_dir.x + light_dir.y * light_dir.y + light_dir.z * light_dir.z);
+	light_dir.x /= len;
+	light_dir.y /= len;
+	light_dir.z /= len;
+
+	data.scene = scene;
+	data.camera = scene->camera;
+	camera_setup(&data.camera, WIDTH, HEIGHT);
+	data.light_dir = light_dir;
+	data.step = step;
+	data.reuse = reuse;
+	tile_job_init(&defaults, render_menger_tile, &data,
+		step * MENGER_PACKET_W, step * MENGER_PACKET_H);
+	job->render = defaults.render;
+	job->ctx = &data;
+	if (job->tile_w <= 0)
+		job->tile_w = defaults.tile_w;
+	if (job->tile_h <= 0)
+		job->tile_h = defaults.tile_h;
+	if (job->threads <= 0)
+		job->threads = defaults.threads;
+	run_tile_job(job);
+}
 
-	return NULL;
+
+// Whole frame in one pass at the resolution factor
+void render_menger_frame(t_scene *scene, t_tile_job *job)
+{
+	render_menger_pass(scene, job, scene->resolution_factor, 0);
 }
 
 
+// First step of the progressive passes: the resolution factor doubled up
+// to PREVIEW_STEP, so halving it each pass ends on the resolution factor
+int menger_preview_step(t_scene *scene)
+{
+	int step = scene->resolution_factor;
+
+	while (step * 2 <= PREVIEW_STEP)
+		step *= 2;
+	return step;
+}
+
 
 // Replace the render_menger_sponge function with this optimized version
 void	render_menger_sponge(t_scene *scene)
@@ -740,53 +929,49 @@ void	render_menger_sponge(t_scene *scene)
     if (!scene->is_3d || ft_strncmp(scene->name, "menger", 6) != 0)
         return;
 
-    // Display rendering status
-    display_progress(scene, "Rendering Menger sponge...");
-
-    // Clear the entire image with black to prevent any artifacts
-    int x, y;
-    for (y = 0; y < HEIGHT; y++)
+    // With the frame thread up, just ask for the new view; the loop hook
+    // shows it when it's done
+    if (scene->async.running)
     {
-        for (x = 0; x < WIDTH; x++)
-        {
-            pixel_put(x, y, &scene->img, BLACK);
-        }
+        render_async_request(scene, FRAME_MENGER);
+        return;
     }
 
-    // Show black screen first to indicate processing
-    draw_image_to_window(scene);
+    t_tile_job job;
+    int step = adaptive_step(scene);
 
-    // Define number of threads - adjust based on system capabilities
-    // Using more threads than CPU cores usually doesn't help and can hurt performance
-    #define NUM_THREADS 8  // Adjust based on your CPU cores
-
-    pthread_t threads[NUM_THREADS];
-    t_menger_thread_data thread_data[NUM_THREADS];
-
-    // Divide the screen into horizontal stripes for each thread
-    int rows_per_thread = HEIGHT / NUM_THREADS;
-
-    // Create and launch threads
-    for (int i = 0; i < NUM_THREADS; i++)
+    // While the view moves, one pass sized to the frame budget
+    if (step)
     {
-        thread_data[i].scene = scene;
-        thread_data[i].start_y = i * rows_per_thread;
-        thread_data[i].end_y = (i == NUM_THREADS - 1) ? HEIGHT : (i + 1) * rows_per_thread;
-
-        pthread_create(&threads[i], NULL, render_menger_thread, &thread_data[i]);
+        job.tile_w = 0;
+        job.tile_h = 0;
+        job.threads = 0;
+        job.pool = &scene->pool;
+        job.cancel = NULL;
+        render_menger_pass(scene, &job, step, 0);
+        adaptive_record(&scene->adaptive, step, adaptive_frame_ms(&job));
+        draw_image_to_window(scene);
+        return;
     }
 
-    // Wait for all threads to complete
-    for (int i = 0; i < NUM_THREADS; i++)
+    // Coarse preview first, then halve the spacing each pass; every pass
+    // only traces the samples the one before didn't have
+    step = menger_preview_step(scene);
+
+    for (int pass = 0; step >= scene->resolution_factor; pass++, step /= 2)
     {
-        pthread_join(threads[i], NULL);
+        job.tile_w = 0;
+        job.tile_h = 0;
+        job.threads = 0;
+        job.pool = &scene->pool;
+        job.cancel = NULL;
+        render_menger_pass(scene, &job, step, pass > 0);
+#ifdef DEBUG
+        print_tile_stats(&job, "menger");
+#endif
+        draw_image_to_window(scene);
     }
 
-    // Final display update - first draw the completed image
-    draw_image_to_window(scene);
-
-    // THEN display status information on top of it
+    // Status on top of the finished image
     display_status(scene);
-
-    // No need for progress message after rendering as status shows the info
 }
@@ -0,0 +1,675 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   menger_bvh.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include "menger_bvh.h"
+
+// Shape of the pairwise merge that build_menger_bvh_recursive applies to
+// the sub-cubes of a cell. Ids below MENGER_CHILDREN are sub-cubes, the
+// others are merge nodes (id - MENGER_CHILDREN indexes left/right).
+typedef struct s_merge_shape
+{
+	int	left[MENGER_CHILDREN - 1];
+	int	right[MENGER_CHILDREN - 1];
+	int	root;
+}	t_merge_shape;
+
+typedef struct s_build_queue	t_build_queue;
+
+typedef struct s_flat_builder
+{
+	t_flat_bvh_node	*nodes;
+	uint32_t		next;
+	t_merge_shape	shape;
+	int				cells[MENGER_CHILDREN][3];
+	t_build_queue	*defer; //layout pass of a parallel build, else NULL
+}	t_flat_builder;
+
+// Parallel build: the top-level sub-cubes become tasks. Their subtrees have
+// a known size, so each task gets its slice of the node array up front and
+// workers write straight into it, no stitching needed afterwards.
+typedef struct s_build_task
+{
+	t_aabb		bounds;
+	uint32_t	start;
+}	t_build_task;
+
+struct s_build_queue
+{
+	t_flat_builder	proto; //shape and cells shared by the workers
+	t_build_task	tasks[MENGER_CHILDREN];
+	int				task_count;
+	int				task_iter;
+	uint32_t		merges[MENGER_CHILDREN - 1]; //top merge nodes, children first
+	int				merge_count;
+	int				next_task;
+	pthread_mutex_t	lock;
+};
+
+// Number of nodes in the BVH for a given iteration count:
+// N(0) = 1, N(n) = 20 * N(n - 1) + 19 (20 sub-trees and 19 merge nodes)
+size_t	menger_bvh_node_count(int iterations)
+{
+	size_t	count;
+
+	count = 1;
+	while (iterations-- > 0)
+	{
+		if (count > (SIZE_MAX - (MENGER_CHILDREN - 1)) / MENGER_CHILDREN)
+			return (0);
+		count = count * MENGER_CHILDREN + (MENGER_CHILDREN - 1);
+	}
+	return (count);
+}
+
+// Same hole rule and visiting order as build_menger_bvh_recursive
+void	menger_sub_cells(int cells[MENGER_CHILDREN][3])
+{
+	int	n;
+
+	n = 0;
+	for (int x = 0; x < 3; x++)
+	{
+		for (int y = 0; y < 3; y++)
+		{
+			for (int z = 0; z < 3; z++)
+			{
+				if ((x == 1 && y == 1) || (x == 1 && z == 1)
+					|| (y == 1 && z == 1))
+					continue ;
+				cells[n][0] = x;
+				cells[n][1] = y;
+				cells[n][2] = z;
+				n++;
+			}
+		}
+	}
+}
+
+void	menger_sub_bounds(t_aabb bounds, int cells[MENGER_CHILDREN][3],
+			t_aabb *sub)
+{
+	double	sub_size;
+
+	sub_size = (bounds.max.x - bounds.min.x) / 3.0;
+	for (int i = 0; i < MENGER_CHILDREN; i++)
+	{
+		sub[i].min.x = bounds.min.x + cells[i][0] * sub_size;
+		sub[i].min.y = bounds.min.y + cells[i][1] * sub_size;
+		sub[i].min.z = bounds.min.z + cells[i][2] * sub_size;
+		sub[i].max.x = sub[i].min.x + sub_size;
+		sub[i].max.y = sub[i].min.y + sub_size;
+		sub[i].max.z = sub[i].min.z + sub_size;
+	}
+}
+
+// Replay the pairwise merge loop on ids to record the tree shape once
+static void	init_merge_shape(t_merge_shape *shape)
+{
+	int	ids[MENGER_CHILDREN];
+	int	count;
+	int	new_count;
+	int	next;
+
+	for (int i = 0; i < MENGER_CHILDREN; i++)
+		ids[i] = i;
+	count = MENGER_CHILDREN;
+	next = MENGER_CHILDREN;
+	while (count > 1)
+	{
+		new_count = 0;
+		for (int i = 0; i < count; i += 2)
+		{
+			if (i + 1 < count)
+			{
+				shape->left[next - MENGER_CHILDREN] = ids[i];
+				shape->right[next - MENGER_CHILDREN] = ids[i + 1];
+				ids[new_count++] = next++;
+			}
+			else
+				ids[new_count++] = ids[i];
+		}
+		count = new_count;
+	}
+	shape->root = ids[0];
+}
+
+static void	set_node_bounds(t_flat_bvh_node *node, t_aabb bounds)
+{
+	node->min[0] = (float)bounds.min.x;
+	node->min[1] = (float)bounds.min.y;
+	node->min[2] = (float)bounds.min.z;
+	node->max[0] = (float)bounds.max.x;
+	node->max[1] = (float)bounds.max.y;
+	node->max[2] = (float)bounds.max.z;
+}
+
+static uint32_t	emit_cell(t_flat_builder *b, t_aabb bounds, int iter);
+
+static void	set_merge_bounds(t_flat_bvh_node *nodes, uint32_t idx,
+				uint32_t left, uint32_t right)
+{
+	for (int k = 0; k < 3; k++)
+	{
+		nodes[idx].min[k] = fminf(nodes[left].min[k], nodes[right].min[k]);
+		nodes[idx].max[k] = fmaxf(nodes[left].max[k], nodes[right].max[k]);
+	}
+}
+
+static uint32_t	emit_merge(t_flat_builder *b, int id, t_aabb *sub, int iter)
+{
+	uint32_t		idx;
+	uint32_t		left;
+	uint32_t		right;
+	t_flat_bvh_node	*node;
+
+	if (id < MENGER_CHILDREN)
+		return (emit_cell(b, sub[id], iter - 1));
+	idx = b->next++;
+	left = emit_merge(b, b->shape.left[id - MENGER_CHILDREN], sub, iter);
+	right = emit_merge(b, b->shape.right[id - MENGER_CHILDREN], sub, iter);
+	node = &b->nodes[idx];
+	// Children still to be built: bounds are set once the tasks are done
+	if (b->defer)
+		b->defer->merges[b->defer->merge_count++] = idx;
+	else
+		set_merge_bounds(b->nodes, idx, left, right);
+	node->right_offset = right - idx;
+	node->is_leaf = 0;
+	node->iteration = iter;
+	return (idx);
+}
+
+// Emit one Menger cell depth-first: a leaf at iteration 0, otherwise the
+// merge tree over its 20 sub-cubes (the merge root takes the cell's place)
+static uint32_t	emit_cell(t_flat_builder *b, t_aabb bounds, int iter)
+{
+	t_aabb			sub[MENGER_CHILDREN];
+	uint32_t		idx;
+
+	if (b->defer && iter == b->defer->task_iter)
+	{
+		// Reserve the slice, a worker fills it later
+		idx = b->next;
+		b->defer->tasks[b->defer->task_count++] = (t_build_task){bounds, idx};
+		b->next += menger_bvh_node_count(iter);
+		return (idx);
+	}
+	if (iter <= 0)
+	{
+		idx = b->next++;
+		set_node_bounds(&b->nodes[idx], bounds);
+		b->nodes[idx].right_offset = 0;
+		b->nodes[idx].is_leaf = 1;
+		b->nodes[idx].iteration = 0;
+		return (idx);
+	}
+	menger_sub_bounds(bounds, b->cells, sub);
+	return (emit_merge(b, b->shape.root, sub, iter));
+}
+
+static void	init_builder(t_flat_builder *builder, t_flat_bvh *bvh)
+{
+	builder->nodes = bvh->nodes;
+	builder->next = 0;
+	builder->defer = NULL;
+	menger_sub_cells(builder->cells);
+	init_merge_shape(&builder->shape);
+}
+
+static void	*build_worker(void *arg)
+{
+	t_build_queue	*queue;
+	t_flat_builder	builder;
+	int				task;
+
+	queue = (t_build_queue *)arg;
+	builder = queue->proto;
+	while (1)
+	{
+		pthread_mutex_lock(&queue->lock);
+		task = queue->next_task++;
+		pthread_mutex_unlock(&queue->lock);
+		if (task >= queue->task_count)
+			break ;
+		builder.next = queue->tasks[task].start;
+		emit_cell(&builder, queue->tasks[task].bounds, queue->task_iter);
+	}
+	return (NULL);
+}
+
+// Lay out the top level, build the 20 sub-cube subtrees on `threads`
+// threads (the caller is one of them), then bound the top merge nodes in
+// the order they were recorded, children before parents. Threads that
+// fail to start just leave more work to the others.
+static void	build_parallel(t_flat_builder *b, t_aabb bounds, int iter,
+				int threads)
+{
+	t_build_queue	queue;
+	pthread_t		ids[MENGER_CHILDREN];
+	int				started;
+	uint32_t		idx;
+
+	queue.proto = *b;
+	queue.task_count = 0;
+	queue.task_iter = iter - 1;
+	queue.merge_count = 0;
+	queue.next_task = 0;
+	pthread_mutex_init(&queue.lock, NULL);
+	b->defer = &queue;
+	emit_cell(b, bounds, iter);
+	b->defer = NULL;
+	if (threads > MENGER_CHILDREN)
+		threads = MENGER_CHILDREN;
+	started = 0;
+	while (started < threads - 1
+		&& pthread_create(&ids[started], NULL, build_worker, &queue) == 0)
+		started++;
+	build_worker(&queue);
+	while (started-- > 0)
+		pthread_join(ids[started], NULL);
+	pthread_mutex_destroy(&queue.lock);
+	for (int i = 0; i < queue.merge_count; i++)
+	{
+		idx = queue.merges[i];
+		set_merge_bounds(b->nodes, idx, idx + 1,
+			idx + b->nodes[idx].right_offset);
+	}
+}
+
+// Fill bvh->nodes with the tree for bvh->iterations
+static void	emit_tree(t_flat_bvh *bvh, int threads)
+{
+	t_flat_builder	builder;
+	t_aabb			bounds;
+
+	init_builder(&builder, bvh);
+	bounds.min = (t_vec3){-1.0, -1.0, -1.0};
+	bounds.max = (t_vec3){1.0, 1.0, 1.0};
+	if (threads > 1 && bvh->iterations >= MENGER_PARALLEL_BUILD)
+		build_parallel(&builder, bounds, bvh->iterations, threads);
+	else
+		emit_cell(&builder, bounds, bvh->iterations);
+}
+
+// Build the whole BVH into one allocation, in a depth-first layout.
+// From MENGER_PARALLEL_BUILD iterations up the 20 top-level subtrees are
+// built in parallel; the result is the same node for node whatever the
+// thread count.
+t_flat_bvh	*build_menger_bvh_threads(int max_iterations, int threads)
+{
+	t_flat_bvh		*bvh;
+	size_t			count;
+
+	count = menger_bvh_node_count(max_iterations);
+	if (count == 0 || count > UINT32_MAX
+		|| count > (SIZE_MAX - sizeof(t_flat_bvh)) / sizeof(t_flat_bvh_node))
+		return (NULL);
+	bvh = malloc(sizeof(t_flat_bvh) + count * sizeof(t_flat_bvh_node));
+	if (!bvh)
+		return (NULL);
+	bvh->nodes = (t_flat_bvh_node *)(bvh + 1);
+	bvh->count = (uint32_t)count;
+	bvh->capacity = (uint32_t)count;
+	bvh->iterations = max_iterations;
+	emit_tree(bvh, threads);
+	return (bvh);
+}
+
+// One build thread per online core, like the renderer
+int	menger_build_threads(void)
+{
+	return (render_thread_count());
+}
+
+t_flat_bvh	*build_menger_bvh(int max_iterations)
+{
+	return (build_menger_bvh_threads(max_iterations, menger_build_threads()));
+}
+
+void	free_bvh(t_flat_bvh *bvh)
+{
+	free(bvh);
+}
+
+// Exact bounds of leaf cell number `ordinal` in depth-first order. Leaves
+// come out in sub-cube order at every level, so the ordinal written in
+// base 20 is the path from the root; the arithmetic is menger_sub_bounds'.
+static t_aabb	leaf_cell_bounds(int cells[MENGER_CHILDREN][3],
+					int iterations, size_t ordinal)
+{
+	t_aabb	bounds;
+	size_t	div;
+	double	sub_size;
+	int		cell;
+
+	bounds.min = (t_vec3){-1.0, -1.0, -1.0};
+	bounds.max = (t_vec3){1.0, 1.0, 1.0};
+	div = 1;
+	for (int i = 1; i < iterations; i++)
+		div *= MENGER_CHILDREN;
+	for (int i = 0; i < iterations; i++, div /= MENGER_CHILDREN)
+	{
+		cell = (ordinal / div) % MENGER_CHILDREN;
+		sub_size = (bounds.max.x - bounds.min.x) / 3.0;
+		bounds.min.x = bounds.min.x + cells[cell][0] * sub_size;
+		bounds.min.y = bounds.min.y + cells[cell][1] * sub_size;
+		bounds.min.z = bounds.min.z + cells[cell][2] * sub_size;
+		bounds.max.x = bounds.min.x + sub_size;
+		bounds.max.y = bounds.min.y + sub_size;
+		bounds.max.z = bounds.min.z + sub_size;
+	}
+	return (bounds);
+}
+
+// One level up, in place. Every leaf turns into the 39 nodes of its
+// subdivided cell, so node i moves to i + 38 * (leaves before i) and right
+// offsets grow 20 times. Walking backwards, no node is overwritten before
+// it is read and children are final before their parent's bounds are
+// taken. Same result as build_menger_bvh(iterations + 1). Returns the
+// (possibly moved) BVH, or NULL with the old one untouched if it can't grow.
+// The allocation left by a prune is reused as is.
+t_flat_bvh	*refine_menger_bvh(t_flat_bvh *bvh)
+{
+	t_flat_builder	builder;
+	t_flat_bvh		*grown;
+	t_flat_bvh_node	node;
+	size_t			count;
+	size_t			leaves;
+	size_t			idx;
+
+	count = menger_bvh_node_count(bvh->iterations + 1);
+	if (count == 0 || count > UINT32_MAX
+		|| count > (SIZE_MAX - sizeof(t_flat_bvh)) / sizeof(t_flat_bvh_node))
+		return (NULL);
+	grown = bvh;
+	if (bvh->capacity < count)
+	{
+		grown = realloc(bvh, sizeof(t_flat_bvh)
+				+ count * sizeof(t_flat_bvh_node));
+		if (!grown)
+			return (NULL);
+		grown->nodes = (t_flat_bvh_node *)(grown + 1);
+		grown->capacity = count;
+	}
+	init_builder(&builder, grown);
+	leaves = (grown->count + 1) / 2;
+	for (size_t i = grown->count; i-- > 0;)
+	{
+		node = grown->nodes[i];
+		if (node.is_leaf)
+		{
+			leaves--;
+			builder.next = i + (MENGER_CHILDREN * 2 - 2) * leaves;
+			emit_cell(&builder, leaf_cell_bounds(builder.cells,
+					grown->iterations, leaves), 1);
+			continue ;
+		}
+		idx = i + (MENGER_CHILDREN * 2 - 2) * leaves;
+		node.right_offset *= MENGER_CHILDREN;
+		node.iteration++;
+		grown->nodes[idx] = node;
+		set_merge_bounds(grown->nodes, idx, idx + 1, idx + node.right_offset);
+	}
+	grown->count = count;
+	grown->iterations++;
+	return (grown);
+}
+
+// One level down, reusing the allocation. Collapsing the 39 node blocks in
+// place means one scattered read per block and redoing every bound anyway,
+// which measured slower than regenerating the smaller tree into the front
+// of the block. Room for one level back up is kept, the rest is returned.
+t_flat_bvh	*prune_menger_bvh(t_flat_bvh *bvh)
+{
+	t_flat_bvh	*shrunk;
+	size_t		keep;
+
+	if (bvh->iterations <= 0)
+		return (NULL);
+	bvh->iterations--;
+	bvh->count = menger_bvh_node_count(bvh->iterations);
+	emit_tree(bvh, menger_build_threads());
+	keep = menger_bvh_node_count(bvh->iterations + 1);
+	if (bvh->capacity <= keep)
+		return (bvh);
+	shrunk = realloc(bvh, sizeof(t_flat_bvh) + keep * sizeof(t_flat_bvh_node));
+	if (!shrunk)
+		return (bvh);
+	shrunk->nodes = (t_flat_bvh_node *)(shrunk + 1);
+	shrunk->capacity = keep;
+	return (shrunk);
+}
+
+//Origin and inverse direction as floats, computed once per ray
+void	aabb_ray_prepare(t_aabb_ray *ray, t_vec3 origin, t_vec3 dir)
+{
+	const double	d[3] = {dir.x, dir.y, dir.z};
+
+	ray->origin[0] = origin.x;
+	ray->origin[1] = origin.y;
+	ray->origin[2] = origin.z;
+	ray->origin[3] = 0.0f;
+	for (int k = 0; k < 3; k++)
+	{
+		// Near-parallel axes only reject rays outside the slab
+		if (fabs(d[k]) < 1e-6)
+			ray->inv_dir[k] = copysignf(1e30f, d[k]);
+		else
+			ray->inv_dir[k] = 1.0 / d[k];
+	}
+	ray->inv_dir[3] = 0.0f;
+}
+
+static inline int	node_intersect(const t_flat_bvh_node *node,
+						const t_aabb_ray *ray, double *t_min, double *t_max)
+{
+	return (menger_slab_test(node->min, node->max, ray, t_min, t_max));
+}
+
+//Both children of an internal node, t[0..1] left and t[2..3] right.
+//Returns bit 0 for a left hit and bit 1 for a right hit.
+static inline int	children_intersect(const t_flat_bvh_node *left,
+						const t_flat_bvh_node *right, const t_aabb_ray *ray,
+						double t[4])
+{
+# if HAS_AVX2
+	return (menger_slab_test2(left->min, left->max, right->min, right->max,
+			ray, t));
+# else
+	return (node_intersect(left, ray, &t[0], &t[1])
+		| node_intersect(right, ray, &t[2], &t[3]) << 1);
+# endif
+}
+
+//Pops the next node whose box may still hold a closer hit, or returns 0
+static inline int	pop_node(const t_bvh_entry *stack, int *sp, double best,
+						uint32_t *node)
+{
+	while (*sp > 0)
+	{
+		(*sp)--;
+		if (stack[*sp].t_near + 0.0001 < best)
+		{
+			*node = stack[*sp].node;
+			return (1);
+		}
+	}
+	return (0);
+}
+
+//Child box hit by the ray: a leaf closer than the best hit becomes the
+//best hit, an inner node that may hold a closer one is returned for descent
+static inline int	visit_child(const t_flat_bvh_node *child, const double *t,
+						double *best, double *best_far)
+{
+	if (t[0] + 0.0001 >= *best)
+		return (0);
+	if (!child->is_leaf)
+		return (1);
+	*best = t[0] + 0.0001;
+	*best_far = t[1];
+	return (0);
+}
+
+// Iterative closest hit with a fixed stack. Child boxes are tested once,
+// by their parent: hit leaves are resolved right there, the near inner
+// child is descended into and the far one pushed. Pushed boxes that start
+// behind the closest hit found meanwhile are skipped when popped.
+// `visits` counts box tests when not NULL.
+static inline int	closest_hit(const t_flat_bvh *bvh, t_vec3 ray_origin,
+						t_vec3 ray_dir, double *t_min, double *t_max,
+						long *visits)
+{
+	t_bvh_entry				stack[MENGER_STACK_SIZE];
+	const t_flat_bvh_node	*nodes;
+	t_aabb_ray				ray;
+	double					t[4];
+	double					best;
+	double					best_far;
+	uint32_t				node;
+	uint32_t				right;
+	int						sp;
+	int						hits;
+	int						go_left;
+	int						go_right;
+
+	if (!bvh || bvh->count == 0)
+		return (0);
+	nodes = bvh->nodes;
+	aabb_ray_prepare(&ray, ray_origin, ray_dir);
+	if (visits)
+		(*visits)++;
+	if (!node_intersect(&nodes[0], &ray, &t[0], &t[1]))
+		return (0);
+	if (nodes[0].is_leaf)
+	{
+		*t_min = t[0] + 0.0001;
+		*t_max = t[1];
+		return (1);
+	}
+	best = INFINITY;
+	best_far = INFINITY;
+	sp = 0;
+	node = 0;
+	while (1)
+	{
+		right = node + nodes[node].right_offset;
+		hits = children_intersect(&nodes[node + 1], &nodes[right], &ray, t);
+		if (visits)
+			*visits += 2;
+		go_left = (hits & 1) && visit_child(&nodes[node + 1], &t[0], &best,
+				&best_far);
+		go_right = (hits & 2) && visit_child(&nodes[right], &t[2], &best,
+				&best_far);
+		if (go_left && go_right)
+		{
+			// Descend into the near child, the far one waits on the stack
+			if (t[2] < t[0])
+			{
+				stack[sp++] = (t_bvh_entry){node + 1, t[0]};
+				node = right;
+			}
+			else
+			{
+				stack[sp++] = (t_bvh_entry){right, t[2]};
+				node = node + 1;
+			}
+		}
+		else if (go_left)
+			node = node + 1;
+		else if (go_right)
+			node = right;
+		else if (!pop_node(stack, &sp, best, &node))
+			break ;
+	}
+	if (best == INFINITY)
+		return (0);
+	*t_min = best;
+	*t_max = best_far;
+	return (1);
+}
+
+int	ray_intersect_bvh(const t_flat_bvh *bvh, t_vec3 ray_origin,
+		t_vec3 ray_dir, double *t_min, double *t_max)
+{
+	return (closest_hit(bvh, ray_origin, ray_dir, t_min, t_max, NULL));
+}
+
+int	ray_intersect_bvh_counted(const t_flat_bvh *bvh, t_vec3 ray_origin,
+		t_vec3 ray_dir, double *t_min, double *t_max, long *visits)
+{
+	return (closest_hit(bvh, ray_origin, ray_dir, t_min, t_max, visits));
+}
+
+// Any-hit walk: same stack scheme, but the first leaf hit ends it, so no
+// distances are kept and nothing is culled by a closest t
+static inline int	any_hit(const t_flat_bvh *bvh, t_vec3 ray_origin,
+						t_vec3 ray_dir, long *visits)
+{
+	uint32_t				stack[MENGER_STACK_SIZE];
+	const t_flat_bvh_node	*nodes;
+	t_aabb_ray				ray;
+	double					t[4];
+	uint32_t				node;
+	uint32_t				right;
+	int						sp;
+	int						hits;
+
+	if (!bvh || bvh->count == 0)
+		return (0);
+	nodes = bvh->nodes;
+	aabb_ray_prepare(&ray, ray_origin, ray_dir);
+	if (visits)
+		(*visits)++;
+	if (!node_intersect(&nodes[0], &ray, &t[0], &t[1]))
+		return (0);
+	if (nodes[0].is_leaf)
+		return (1);
+	sp = 0;
+	node = 0;
+	while (1)
+	{
+		right = node + nodes[node].right_offset;
+		hits = children_intersect(&nodes[node + 1], &nodes[right], &ray, t);
+		if (visits)
+			*visits += 2;
+		if (((hits & 1) && nodes[node + 1].is_leaf)
+			|| ((hits & 2) && nodes[right].is_leaf))
+			return (1);
+		if (hits == 3)
+		{
+			// Near child first, it is the likelier blocker
+			stack[sp++] = (t[2] < t[0]) ? node + 1 : right;
+			node = (t[2] < t[0]) ? right : node + 1;
+		}
+		else if (hits)
+			node = (hits == 1) ? node + 1 : right;
+		else if (sp > 0)
+			node = stack[--sp];
+		else
+			return (0);
+	}
+}
+
+//Does the ray hit the sponge at all? Same answer as ray_intersect_bvh's
+//return value, without searching for the closest hit.
+int	ray_occluded_bvh(const t_flat_bvh *bvh, t_vec3 ray_origin, t_vec3 ray_dir)
+{
+	return (any_hit(bvh, ray_origin, ray_dir, NULL));
+}
+
+int	ray_occluded_bvh_counted(const t_flat_bvh *bvh, t_vec3 ray_origin,
+		t_vec3 ray_dir, long *visits)
+{
+	return (any_hit(bvh, ray_origin, ray_dir, visits));
+}
@@ -0,0 +1,153 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   menger_implicit.c                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include "menger_bvh.h"
+
+//Implicit Menger traversal: walks the 3x3x3 subdivision on the fly instead
+//of a prebuilt BVH, so memory is O(iterations) per ray at any depth.
+//Cells are split with the same arithmetic as the BVH builder and tested
+//with the same float slab test, so hits match the BVH path exactly.
+
+typedef struct s_implicit_ray
+{
+	t_aabb_ray	ray;
+	int			cells[MENGER_CHILDREN][3];
+	double		best_tmin;
+	double		best_tmax;
+	int			hit;
+	int			any_hit; //stop at the first cube instead of the closest
+}	t_implicit_ray;
+
+typedef struct s_cell_hit
+{
+	double	tmin;
+	double	tmax;
+	int		index;
+}	t_cell_hit;
+
+static int	cell_intersect(t_implicit_ray *ray, t_aabb bounds,
+				double *t_min, double *t_max)
+{
+	return (menger_slab_test_aabb(&bounds, &ray->ray, t_min, t_max));
+}
+
+//Sub-cubes hit by the ray that could still beat the best hit, sorted by
+//entry distance so the nearest one is descended first
+static int	sorted_sub_hits(t_implicit_ray *ray, t_aabb *sub, t_cell_hit *hits)
+{
+	t_cell_hit	cur;
+	int			count;
+	int			j;
+
+	count = 0;
+	for (int i = 0; i < MENGER_CHILDREN; i++)
+	{
+		if (!cell_intersect(ray, sub[i], &cur.tmin, &cur.tmax)
+			|| cur.tmin + 0.0001 >= ray->best_tmin)
+			continue ;
+		cur.index = i;
+		j = count++;
+		while (j > 0 && hits[j - 1].tmin > cur.tmin)
+		{
+			hits[j] = hits[j - 1];
+			j--;
+		}
+		hits[j] = cur;
+	}
+	return (count);
+}
+
+static void	visit_cell(t_implicit_ray *ray, t_aabb bounds, int level)
+{
+	t_aabb		sub[MENGER_CHILDREN];
+	t_cell_hit	hits[MENGER_CHILDREN];
+	int			count;
+
+	menger_sub_bounds(bounds, ray->cells, sub);
+	count = sorted_sub_hits(ray, sub, hits);
+	for (int i = 0; i < count; i++)
+	{
+		// Sorted by entry, nothing further can be closer than the best hit
+		if (hits[i].tmin + 0.0001 >= ray->best_tmin)
+			break ;
+		if (level - 1 > 0)
+			visit_cell(ray, sub[hits[i].index], level - 1);
+		else
+		{
+			ray->best_tmin = hits[i].tmin + 0.0001;
+			ray->best_tmax = hits[i].tmax;
+			ray->hit = 1;
+			// Nothing passes the culling tests anymore, the walk unwinds
+			if (ray->any_hit)
+				ray->best_tmin = -INFINITY;
+		}
+	}
+}
+
+//Closest hit on the sponge, same contract as ray_intersect_bvh
+int	ray_intersect_menger_implicit(int iterations, t_vec3 ray_origin,
+		t_vec3 ray_dir, double *t_min, double *t_max)
+{
+	t_implicit_ray	ray;
+	t_aabb			bounds;
+	double			root_tmin;
+	double			root_tmax;
+
+	bounds.min = (t_vec3){-1.0, -1.0, -1.0};
+	bounds.max = (t_vec3){1.0, 1.0, 1.0};
+	aabb_ray_prepare(&ray.ray, ray_origin, ray_dir);
+	if (!cell_intersect(&ray, bounds, &root_tmin, &root_tmax))
+		return (0);
+	if (iterations <= 0)
+	{
+		*t_min = root_tmin + 0.0001;
+		*t_max = root_tmax;
+		return (1);
+	}
+	menger_sub_cells(ray.cells);
+	ray.best_tmin = INFINITY;
+	ray.best_tmax = -INFINITY;
+	ray.hit = 0;
+	ray.any_hit = 0;
+	visit_cell(&ray, bounds, iterations);
+	if (!ray.hit)
+		return (0);
+	*t_min = ray.best_tmin;
+	*t_max = ray.best_tmax;
+	return (1);
+}
+
+//Any hit on the sponge, same answer as the return value above
+int	ray_occluded_menger_implicit(int iterations, t_vec3 ray_origin,
+		t_vec3 ray_dir)
+{
+	t_implicit_ray	ray;
+	t_aabb			bounds;
+	double			root_tmin;
+	double			root_tmax;
+
+	bounds.min = (t_vec3){-1.0, -1.0, -1.0};
+	bounds.max = (t_vec3){1.0, 1.0, 1.0};
+	aabb_ray_prepare(&ray.ray, ray_origin, ray_dir);
+	if (!cell_intersect(&ray, bounds, &root_tmin, &root_tmax))
+		return (0);
+	if (iterations <= 0)
+		return (1);
+	menger_sub_cells(ray.cells);
+	ray.best_tmin = INFINITY;
+	ray.best_tmax = -INFINITY;
+	ray.hit = 0;
+	ray.any_hit = 1;
+	visit_cell(&ray, bounds, iterations);
+	return (ray.hit);
+}
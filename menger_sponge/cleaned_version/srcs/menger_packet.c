@@ -0,0 +1,277 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   menger_packet.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "menger_bvh.h"
+
+//Packet traversal of the flat BVH: MENGER_PACKET_SIZE coherent rays walk
+//the tree together and each node is tested for all of them in one SIMD
+//pass. Per lane the result is the same closest hit as ray_intersect_bvh.
+
+void	ray_packet_prepare(t_ray_packet *packet, const t_vec3 *origins,
+		const t_vec3 *dirs, int active)
+{
+	t_aabb_ray	ray;
+	int			first;
+
+	first = 1;
+	packet->active = active;
+	for (int k = 0; k < 3; k++)
+		packet->mean_dir[k] = 0.0f;
+	for (int lane = 0; lane < MENGER_PACKET_SIZE; lane++)
+	{
+		// Dead lanes get zeros, their results are masked out
+		for (int k = 0; k < 3; k++)
+		{
+			packet->origin[k][lane] = 0.0f;
+			packet->inv_dir[k][lane] = 0.0f;
+		}
+		if (!(active & (1 << lane)))
+			continue ;
+		// Same inverse as the single ray path, so lane results match it
+		aabb_ray_prepare(&ray, origins[lane], dirs[lane]);
+		for (int k = 0; k < 3; k++)
+		{
+			packet->origin[k][lane] = ray.origin[k];
+			packet->inv_dir[k][lane] = ray.inv_dir[k];
+			if (first || ray.origin[k] < packet->origin_lo[k])
+				packet->origin_lo[k] = ray.origin[k];
+			if (first || ray.origin[k] > packet->origin_hi[k])
+				packet->origin_hi[k] = ray.origin[k];
+			if (first || ray.inv_dir[k] < packet->inv_lo[k])
+				packet->inv_lo[k] = ray.inv_dir[k];
+			if (first || ray.inv_dir[k] > packet->inv_hi[k])
+				packet->inv_hi[k] = ray.inv_dir[k];
+		}
+		packet->mean_dir[0] += dirs[lane].x;
+		packet->mean_dir[1] += dirs[lane].y;
+		packet->mean_dir[2] += dirs[lane].z;
+		first = 0;
+	}
+	packet->coherent = !first;
+	for (int k = 0; k < 3; k++)
+		if (!(packet->inv_lo[k] > 0.0f || packet->inv_hi[k] < 0.0f))
+			packet->coherent = 0;
+}
+
+//Slab test of one box for every lane, same operations and order as
+//menger_slab_test. Returns a bit per lane that hits the box closer than
+//its current best.
+static inline int	packet_node_test(const t_flat_bvh_node *node,
+						const t_ray_packet *packet, const float *best,
+						float *tn_out, float *tf_out)
+{
+#if HAS_SSE
+	t_lanes	o;
+	t_lanes	inv;
+	t_lanes	t1;
+	t_lanes	t2;
+	t_lanes	tn;
+	t_lanes	tf;
+
+	for (int k = 0; k < 3; k++)
+	{
+		o = LANES_LOAD(packet->origin[k]);
+		inv = LANES_LOAD(packet->inv_dir[k]);
+		t1 = LANES_MUL(LANES_SUB(LANES_SET1(node->min[k]), o), inv);
+		t2 = LANES_MUL(LANES_SUB(LANES_SET1(node->max[k]), o), inv);
+		if (k == 0)
+		{
+			tn = LANES_MIN(t1, t2);
+			tf = LANES_MAX(t1, t2);
+			continue ;
+		}
+		tn = LANES_MAX(tn, LANES_MIN(t1, t2));
+		tf = LANES_MIN(tf, LANES_MAX(t1, t2));
+	}
+	LANES_STORE(tn_out, tn);
+	LANES_STORE(tf_out, tf);
+	return (LANES_MASK(LANES_AND(LANES_AND(LANES_LE(tn, tf),
+					LANES_LE(LANES_ZERO(), tf)),
+				LANES_LT(tn, LANES_LOAD(best)))));
+#else
+	float	t1;
+	float	t2;
+	int		mask;
+
+	mask = 0;
+	for (int lane = 0; lane < MENGER_PACKET_SIZE; lane++)
+	{
+		tn_out[lane] = -INFINITY;
+		tf_out[lane] = INFINITY;
+		for (int k = 0; k < 3; k++)
+		{
+			t1 = (node->min[k] - packet->origin[k][lane])
+				* packet->inv_dir[k][lane];
+			t2 = (node->max[k] - packet->origin[k][lane])
+				* packet->inv_dir[k][lane];
+			tn_out[lane] = fmaxf(tn_out[lane], fminf(t1, t2));
+			tf_out[lane] = fminf(tf_out[lane], fmaxf(t1, t2));
+		}
+		if (tn_out[lane] <= tf_out[lane] && tf_out[lane] >= 0
+			&& tn_out[lane] < best[lane])
+			mask |= 1 << lane;
+	}
+	return (mask);
+#endif
+}
+
+static inline float	min2f(float a, float b)
+{
+	return (a < b ? a : b);
+}
+
+static inline float	max2f(float a, float b)
+{
+	return (a > b ? a : b);
+}
+
+//Smallest and largest product of two float intervals. Rounding is monotone
+//so the bounds also hold for every lane's own rounded product.
+static inline float	interval_mul_lo(float a_lo, float a_hi, float b_lo,
+						float b_hi)
+{
+	return (min2f(min2f(a_lo * b_lo, a_lo * b_hi),
+			min2f(a_hi * b_lo, a_hi * b_hi)));
+}
+
+static inline float	interval_mul_hi(float a_lo, float a_hi, float b_lo,
+						float b_hi)
+{
+	return (max2f(max2f(a_lo * b_lo, a_lo * b_hi),
+			max2f(a_hi * b_lo, a_hi * b_hi)));
+}
+
+//Interval culling: entry and exit distances bounded over the whole packet.
+//If even the earliest entry is past the latest exit no ray of the packet
+//can reach anything inside the box.
+static inline int	packet_misses_box(const t_flat_bvh_node *node,
+						const t_ray_packet *packet)
+{
+	float	near;
+	float	far;
+	float	entry;
+	float	exit;
+
+	near = -INFINITY;
+	far = INFINITY;
+	for (int k = 0; k < 3; k++)
+	{
+		entry = node->min[k];
+		exit = node->max[k];
+		if (packet->inv_lo[k] < 0.0f)
+		{
+			entry = node->max[k];
+			exit = node->min[k];
+		}
+		near = max2f(near, interval_mul_lo(entry - packet->origin_hi[k],
+					entry - packet->origin_lo[k], packet->inv_lo[k],
+					packet->inv_hi[k]));
+		far = min2f(far, interval_mul_hi(exit - packet->origin_hi[k],
+					exit - packet->origin_lo[k], packet->inv_lo[k],
+					packet->inv_hi[k]));
+	}
+	return (near > far || far < 0.0f);
+}
+
+//Leaf reached: keep the closer hit per lane, with the same offset as the
+//single ray path
+static void	packet_record_leaf(int mask, const float *tn, const float *tf,
+				float *best, double *t_min, double *t_max)
+{
+	double	candidate;
+
+	for (int lane = 0; lane < MENGER_PACKET_SIZE; lane++)
+	{
+		if (!(mask & (1 << lane)))
+			continue ;
+		candidate = tn[lane] + 0.0001;
+		if (candidate < t_min[lane])
+		{
+			t_min[lane] = candidate;
+			t_max[lane] = tf[lane];
+			best[lane] = candidate;
+		}
+	}
+}
+
+//Children go on the stack far one first, ordered along the packet's mean
+//direction since the flat nodes have no split axis
+static inline int	push_children(uint32_t *stack, int sp, uint32_t idx,
+						const t_flat_bvh_node *nodes, const float *mean_dir)
+{
+	const t_flat_bvh_node	*left = &nodes[idx + 1];
+	const t_flat_bvh_node	*right = &nodes[idx + nodes[idx].right_offset];
+	float					order;
+
+	order = 0.0f;
+	for (int k = 0; k < 3; k++)
+		order += (right->min[k] + right->max[k] - left->min[k]
+				- left->max[k]) * mean_dir[k];
+	if (order < 0.0f)
+	{
+		stack[sp++] = idx + 1;
+		stack[sp++] = idx + nodes[idx].right_offset;
+	}
+	else
+	{
+		stack[sp++] = idx + nodes[idx].right_offset;
+		stack[sp++] = idx + 1;
+	}
+	return (sp);
+}
+
+//Closest hit for every live lane. t_min/t_max are filled for lanes whose
+//bit is set in the returned mask.
+int	ray_intersect_bvh_packet(const t_flat_bvh *bvh,
+		const t_ray_packet *packet, double *t_min, double *t_max)
+{
+	uint32_t				stack[MENGER_STACK_SIZE];
+	float					best[MENGER_PACKET_SIZE];
+	float					tn[MENGER_PACKET_SIZE];
+	float					tf[MENGER_PACKET_SIZE];
+	const t_flat_bvh_node	*node;
+	uint32_t				idx;
+	int						sp;
+	int						mask;
+	int						hits;
+
+	if (!bvh || bvh->count == 0 || !packet->active)
+		return (0);
+	// Whole packet rejection at the root only: deeper down the 4/8 lane
+	// SIMD test is as cheap as the interval test and more precise
+	if (packet->coherent && packet_misses_box(&bvh->nodes[0], packet))
+		return (0);
+	for (int lane = 0; lane < MENGER_PACKET_SIZE; lane++)
+	{
+		best[lane] = INFINITY;
+		t_min[lane] = INFINITY;
+	}
+	hits = 0;
+	sp = 0;
+	stack[sp++] = 0;
+	while (sp > 0)
+	{
+		idx = stack[--sp];
+		node = &bvh->nodes[idx];
+		mask = packet_node_test(node, packet, best, tn, tf) & packet->active;
+		if (!mask)
+			continue ;
+		if (node->is_leaf)
+		{
+			packet_record_leaf(mask, tn, tf, best, t_min, t_max);
+			hits |= mask;
+			continue ;
+		}
+		sp = push_children(stack, sp, idx, bvh->nodes, packet->mean_dir);
+	}
+	return (hits);
+}
@@ -0,0 +1,305 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   menger_wide.c                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include <string.h>
+#include "menger_bvh.h"
+
+//Wide BVH: the binary flat BVH collapsed so each node holds up to
+//MENGER_WIDE_WIDTH child boxes. About half (4 wide) or a third (8 wide)
+//of the depth, and all children of a node are tested in one SIMD pass.
+
+typedef struct s_wide_builder
+{
+	const t_flat_bvh_node	*src;
+	t_wide_bvh_node			*nodes; //NULL while counting
+	uint32_t				count;
+	int						depth;
+}	t_wide_builder;
+
+static float	half_area(const t_flat_bvh_node *node)
+{
+	const float	dx = node->max[0] - node->min[0];
+	const float	dy = node->max[1] - node->min[1];
+	const float	dz = node->max[2] - node->min[2];
+
+	return (dx * dy + dy * dz + dz * dx);
+}
+
+//Children of a wide node: start from the two binary children and keep
+//opening the largest internal one until the node is full
+static int	gather_slots(const t_flat_bvh_node *src, uint32_t idx,
+				uint32_t *slots)
+{
+	int			n;
+	int			open;
+	uint32_t	split;
+
+	if (src[idx].is_leaf)
+	{
+		slots[0] = idx;
+		return (1);
+	}
+	n = 0;
+	slots[n++] = idx + 1;
+	slots[n++] = idx + src[idx].right_offset;
+	while (n < MENGER_WIDE_WIDTH)
+	{
+		open = -1;
+		for (int i = 0; i < n; i++)
+			if (!src[slots[i]].is_leaf && (open < 0
+					|| half_area(&src[slots[i]]) > half_area(&src[slots[open]])))
+				open = i;
+		if (open < 0)
+			break ;
+		split = slots[open];
+		slots[open] = split + 1;
+		slots[n++] = split + src[split].right_offset;
+	}
+	return (n);
+}
+
+//Depth-first collapse, same walk for the counting and the filling pass
+static uint32_t	collapse(t_wide_builder *b, uint32_t idx, int depth)
+{
+	uint32_t		slots[MENGER_WIDE_WIDTH];
+	const uint32_t	self = b->count++;
+	const int		n = gather_slots(b->src, idx, slots);
+	t_wide_bvh_node	*node;
+	uint32_t		child;
+
+	if (depth > b->depth)
+		b->depth = depth;
+	node = NULL;
+	if (b->nodes)
+	{
+		node = &b->nodes[self];
+		memset(node, 0, sizeof(*node));
+		node->count = n;
+		for (int i = 0; i < n; i++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				node->min[k][i] = b->src[slots[i]].min[k];
+				node->max[k][i] = b->src[slots[i]].max[k];
+			}
+		}
+	}
+	for (int i = 0; i < n; i++)
+	{
+		child = MENGER_WIDE_LEAF;
+		if (!b->src[slots[i]].is_leaf)
+			child = collapse(b, slots[i], depth + 1);
+		if (node)
+			node->child[i] = child;
+	}
+	return (self);
+}
+
+//Build from an existing flat BVH, which the caller still owns. Returns
+//NULL if allocation fails or the tree is too deep for the traversal stack.
+t_wide_bvh	*build_menger_wide_bvh(const t_flat_bvh *bvh)
+{
+	t_wide_builder	b;
+	t_wide_bvh		*wide;
+
+	if (!bvh || bvh->count == 0)
+		return (NULL);
+	b = (t_wide_builder){bvh->nodes, NULL, 0, 0};
+	collapse(&b, 0, 1);
+	if ((size_t)b.depth * (MENGER_WIDE_WIDTH - 1) + 1 > MENGER_WIDE_STACK_SIZE)
+		return (NULL);
+	wide = malloc(sizeof(t_wide_bvh) + sizeof(t_wide_bvh_node) * b.count);
+	if (!wide)
+		return (NULL);
+	wide->nodes = (t_wide_bvh_node *)(wide + 1);
+	wide->count = b.count;
+	wide->iterations = bvh->iterations;
+	wide->depth = b.depth;
+	b.nodes = wide->nodes;
+	b.count = 0;
+	collapse(&b, 0, 1);
+	return (wide);
+}
+
+void	free_wide_bvh(t_wide_bvh *wide)
+{
+	free(wide);
+}
+
+//All child boxes of a node against one ray. Same per-axis operations as
+//menger_slab_test, so leaf distances match the binary BVH exactly. Returns
+//a bit per used slot hit closer than `best`.
+static inline int	wide_node_test(const t_wide_bvh_node *node,
+						const t_aabb_ray *ray, float best, float *tn_out,
+						float *tf_out)
+{
+#if HAS_SSE
+	t_lanes	t1;
+	t_lanes	t2;
+	t_lanes	tn;
+	t_lanes	tf;
+
+	for (int k = 0; k < 3; k++)
+	{
+		t1 = LANES_MUL(LANES_SUB(LANES_LOAD(node->min[k]),
+					LANES_SET1(ray->origin[k])), LANES_SET1(ray->inv_dir[k]));
+		t2 = LANES_MUL(LANES_SUB(LANES_LOAD(node->max[k]),
+					LANES_SET1(ray->origin[k])), LANES_SET1(ray->inv_dir[k]));
+		if (k == 0)
+		{
+			tn = LANES_MIN(t1, t2);
+			tf = LANES_MAX(t1, t2);
+			continue ;
+		}
+		tn = LANES_MAX(tn, LANES_MIN(t1, t2));
+		tf = LANES_MIN(tf, LANES_MAX(t1, t2));
+	}
+	LANES_STORE(tn_out, tn);
+	LANES_STORE(tf_out, tf);
+	return (LANES_MASK(LANES_AND(LANES_AND(LANES_LE(tn, tf),
+					LANES_LE(LANES_ZERO(), tf)),
+				LANES_LT(tn, LANES_SET1(best)))) & ((1 << node->count) - 1));
+#else
+	float	t1;
+	float	t2;
+	int		mask;
+
+	mask = 0;
+	for (uint32_t i = 0; i < node->count; i++)
+	{
+		tn_out[i] = -INFINITY;
+		tf_out[i] = INFINITY;
+		for (int k = 0; k < 3; k++)
+		{
+			t1 = (node->min[k][i] - ray->origin[k]) * ray->inv_dir[k];
+			t2 = (node->max[k][i] - ray->origin[k]) * ray->inv_dir[k];
+			tn_out[i] = fmaxf(tn_out[i], fminf(t1, t2));
+			tf_out[i] = fminf(tf_out[i], fmaxf(t1, t2));
+		}
+		if (tn_out[i] <= tf_out[i] && tf_out[i] >= 0 && tn_out[i] < best)
+			mask |= 1 << i;
+	}
+	return (mask);
+#endif
+}
+
+//Hit children go on the stack farthest first so the nearest is popped next
+static int	push_sorted(t_bvh_entry *stack, int sp,
+				const t_wide_bvh_node *node, int mask, const float *tn)
+{
+	t_bvh_entry	hit[MENGER_WIDE_WIDTH];
+	t_bvh_entry	key;
+	int			n;
+	int			j;
+
+	n = 0;
+	for (int i = 0; i < MENGER_WIDE_WIDTH; i++)
+	{
+		if (!(mask & (1 << i)))
+			continue ;
+		key = (t_bvh_entry){node->child[i], tn[i]};
+		j = n++;
+		while (j > 0 && hit[j - 1].t_near < key.t_near)
+		{
+			hit[j] = hit[j - 1];
+			j--;
+		}
+		hit[j] = key;
+	}
+	for (int i = 0; i < n; i++)
+		stack[sp++] = hit[i];
+	return (sp);
+}
+
+//Closest hit, same result as ray_intersect_bvh. Sponge cubes are stored
+//as leaf slots, so they are resolved in their parent without a push.
+int	ray_intersect_wide_bvh(const t_wide_bvh *wide, t_vec3 ray_origin,
+		t_vec3 ray_dir, double *t_min, double *t_max)
+{
+	t_bvh_entry				stack[MENGER_WIDE_STACK_SIZE];
+	const t_wide_bvh_node	*node;
+	t_aabb_ray				ray;
+	float					tn[MENGER_WIDE_WIDTH];
+	float					tf[MENGER_WIDE_WIDTH];
+	double					best;
+	int						sp;
+	int						mask;
+	int						inner;
+
+	if (!wide || wide->count == 0)
+		return (0);
+	aabb_ray_prepare(&ray, ray_origin, ray_dir);
+	best = INFINITY;
+	sp = 0;
+	stack[sp++] = (t_bvh_entry){0, -INFINITY};
+	while (sp > 0)
+	{
+		sp--;
+		// A closer cube was found since this node was pushed
+		if (stack[sp].t_near + 0.0001 >= best)
+			continue ;
+		node = &wide->nodes[stack[sp].node];
+		mask = wide_node_test(node, &ray, best, tn, tf);
+		inner = 0;
+		for (uint32_t i = 0; i < node->count; i++)
+		{
+			if (!(mask & (1 << i)))
+				continue ;
+			if (node->child[i] != MENGER_WIDE_LEAF)
+				inner |= 1 << i;
+			else if (tn[i] + 0.0001 < best)
+			{
+				best = tn[i] + 0.0001;
+				*t_max = tf[i];
+			}
+		}
+		sp = push_sorted(stack, sp, node, inner, tn);
+	}
+	if (best == INFINITY)
+		return (0);
+	*t_min = best;
+	return (1);
+}
+
+//Any hit: returns at the first sponge cube slot hit, children are pushed
+//unsorted since no closest distance is kept
+int	ray_occluded_wide_bvh(const t_wide_bvh *wide, t_vec3 ray_origin,
+		t_vec3 ray_dir)
+{
+	uint32_t				stack[MENGER_WIDE_STACK_SIZE];
+	const t_wide_bvh_node	*node;
+	t_aabb_ray				ray;
+	float					tn[MENGER_WIDE_WIDTH];
+	float					tf[MENGER_WIDE_WIDTH];
+	int						sp;
+	int						mask;
+
+	if (!wide || wide->count == 0)
+		return (0);
+	aabb_ray_prepare(&ray, ray_origin, ray_dir);
+	sp = 0;
+	stack[sp++] = 0;
+	while (sp > 0)
+	{
+		node = &wide->nodes[stack[--sp]];
+		mask = wide_node_test(node, &ray, INFINITY, tn, tf);
+		for (uint32_t i = 0; i < node->count; i++)
+		{
+			if (!(mask & (1 << i)))
+				continue ;
+			if (node->child[i] == MENGER_WIDE_LEAF)
+				return (1);
+			stack[sp++] = node->child[i];
+		}
+	}
+	return (0);
+}
@@ -12,21 +12,18 @@
 
 #include "platform.h"
 
+//Objects and their data live in the scene arena, freed with it in cleanup_scene
 //Note: Due to args limitation (norminette), we need to modify the color later, after cylinder creation
-t_object	*create_cylinder(t_vec3 center, t_vec3 axis, double diameter, double height)
+t_object	*create_cylinder(t_arena *arena, t_vec3 center, t_vec3 axis,
+				double diameter, double height)
 {
 	t_object	*object;
 	t_cylinder	*cylinder;
 
-	object = malloc(sizeof(t_object));
-	if (!object)
+	object = arena_alloc(arena, sizeof(t_object));
+	cylinder = arena_alloc(arena, sizeof(t_cylinder));
+	if (!object || !cylinder)
 		return (NULL);
-	cylinder = malloc(sizeof(t_cylinder));
-	if (!cylinder)
-	{
-		free(object);
-		return (NULL);
-	}
 	cylinder->center = center;
 	cylinder->axis = vec3_normalize(axis);
 	cylinder->diameter = diameter;
@@ -39,20 +36,16 @@ t_object	*create_cylinder(t_vec3 center, t_vec3 axis, double diameter, double he
 	return (object);
 }
 
-t_object	*create_plane(t_vec3 point, t_vec3 normal, t_color color)
+t_object	*create_plane(t_arena *arena, t_vec3 point, t_vec3 normal,
+				t_color color)
 {
 	t_object	*object;
 	t_plane		*plane;
 
-	object = malloc(sizeof(t_object));
-	if (!object)
-		return (NULL);
-	plane = malloc(sizeof(t_plane));
-	if (!plane)
-	{
-		free(object);
+	object = arena_alloc(arena, sizeof(t_object));
+	plane = arena_alloc(arena, sizeof(t_plane));
+	if (!object || !plane)
 		return (NULL);
-	}
 	plane->normal = vec3_normalize(normal);
 	plane->point = point;
 	object->data = plane;
@@ -62,20 +55,16 @@ t_object	*create_plane(t_vec3 point, t_vec3 normal, t_color color)
 	return (object);
 }
 
-t_object	*create_sphere(t_vec3 center, double diameter, t_color color)
+t_object	*create_sphere(t_arena *arena, t_vec3 center, double diameter,
+				t_color color)
 {
 	t_object	*object;
 	t_sphere	*sphere;
 
-	object = malloc(sizeof(t_object));
-	if (!object)
-		return (NULL);
-	sphere = malloc(sizeof(t_sphere));
-	if (!sphere)
-	{
-		free(object);
+	object = arena_alloc(arena, sizeof(t_object));
+	sphere = arena_alloc(arena, sizeof(t_sphere));
+	if (!object || !sphere)
 		return (NULL);
-	}
 	sphere->center = center;
 	sphere->diameter = diameter;
 	sphere->radius = diameter / 2.0;
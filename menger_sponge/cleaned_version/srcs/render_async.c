@@ -0,0 +1,293 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   render_async.c                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include <string.h>
+
+//Hand the pass just finished in back to the event thread through the
+//preview image; the frame thread keeps refining back
+static void	post_preview(t_async_render *a, unsigned int gen)
+{
+	pthread_mutex_lock(&a->lock);
+	if (atomic_load(&a->requested) == gen)
+	{
+		memcpy(a->preview.pixels_ptr, a->back.pixels_ptr,
+			(size_t)HEIGHT * a->back.line_len);
+		a->preview_ready = gen;
+	}
+	pthread_mutex_unlock(&a->lock);
+}
+
+//Pass function of a frame of `kind`, and the spacing its passes start and
+//end on: the object scene ends on every pixel like render_complex_scene,
+//the Menger sponge on the resolution factor
+static t_pass_fn	frame_pass(t_scene *frame, t_frame_kind kind,
+		int *first, int *last)
+{
+	if (kind == FRAME_SCENE)
+	{
+		*first = PREVIEW_STEP;
+		*last = 1;
+		return (render_scene_pass);
+	}
+	*first = menger_preview_step(frame);
+	*last = frame->resolution_factor;
+	return (render_menger_pass);
+}
+
+//Coarse-to-fine passes of one generation into back, each but the last
+//posted as a preview. Stops early once a newer view is requested. A
+//moving frame is a single pass, its cost is handed back for the budget.
+static void	render_frame_passes(t_scene *scene, t_async_render *a,
+		unsigned int gen, t_frame_kind kind)
+{
+	t_tile_job	job;
+	t_pass_fn	render;
+	int			step;
+	int			first;
+	int			last;
+	int			pass;
+
+	render = frame_pass(a->frame, kind, &first, &last);
+	step = adaptive_step(a->frame);
+	if (step)
+	{
+		job.tile_w = 0;
+		job.tile_h = 0;
+		job.threads = 0;
+		job.pool = &scene->pool;
+		job.cancel = &a->requested;
+		job.generation = gen;
+		render(a->frame, &job, step, 0);
+		pthread_mutex_lock(&a->lock);
+		a->moved_step = step;
+		a->moved_ms = adaptive_frame_ms(&job);
+		pthread_mutex_unlock(&a->lock);
+		return ;
+	}
+	step = first;
+	pass = 0;
+	while (step >= last && atomic_load(&a->requested) == gen)
+	{
+		job.tile_w = 0;
+		job.tile_h = 0;
+		job.threads = 0;
+		job.pool = &scene->pool;
+		job.cancel = &a->requested;
+		job.generation = gen;
+		render(a->frame, &job, step, pass++ > 0);
+		step /= 2;
+		if (step >= last)
+			post_preview(a, gen);
+	}
+}
+
+//Frame thread: sleeps until a generation newer than the last one taken is
+//requested, renders that view into the back image, and marks it ready if
+//nothing newer came in meanwhile
+static void	*frame_thread(void *arg)
+{
+	t_scene			*scene;
+	t_async_render	*a;
+	t_frame_kind	kind;
+	unsigned int	gen;
+
+	scene = (t_scene *)arg;
+	a = &scene->async;
+	pthread_mutex_lock(&a->lock);
+	while (!a->stop)
+	{
+		gen = atomic_load(&a->requested);
+		if (gen == a->taken)
+		{
+			pthread_cond_wait(&a->wake, &a->lock);
+			continue ;
+		}
+		a->taken = gen;
+		*a->frame = *a->pending;
+		kind = a->pending_kind;
+		a->frame->img = a->back;
+		a->busy = 1;
+		pthread_mutex_unlock(&a->lock);
+		render_frame_passes(scene, a, gen, kind);
+		pthread_mutex_lock(&a->lock);
+		a->busy = 0;
+		if (atomic_load(&a->requested) == gen)
+			a->ready = gen;
+		pthread_cond_broadcast(&a->idle);
+	}
+	pthread_mutex_unlock(&a->lock);
+	return (NULL);
+}
+
+//Back and preview images and the frame thread. If any can't be had, `running` stays 0
+//and render_menger_sponge and render_complex_scene keep rendering on the
+//event thread.
+void	render_async_start(t_scene *scene)
+{
+	t_async_render	*a;
+
+	a = &scene->async;
+	a->running = 0;
+	a->stop = 0;
+	a->busy = 0;
+	a->taken = 0;
+	a->ready = 0;
+	a->preview_ready = 0;
+	a->moved_step = 0;
+	atomic_init(&a->requested, 0);
+	a->pending = malloc(2 * sizeof(t_scene));
+	a->back.img_ptr = mlx_new_image(scene->mlx_connection, WIDTH, HEIGHT);
+	a->preview.img_ptr = mlx_new_image(scene->mlx_connection, WIDTH, HEIGHT);
+	if (!a->pending || !a->back.img_ptr || !a->preview.img_ptr)
+	{
+		render_async_stop(scene);
+		return ;
+	}
+	a->frame = a->pending + 1;
+	a->back.pixels_ptr = mlx_get_data_addr(a->back.img_ptr, &a->back.bpp,
+			&a->back.line_len, &a->back.endian);
+	a->preview.pixels_ptr = mlx_get_data_addr(a->preview.img_ptr,
+			&a->preview.bpp, &a->preview.line_len, &a->preview.endian);
+	pthread_mutex_init(&a->lock, NULL);
+	pthread_cond_init(&a->wake, NULL);
+	pthread_cond_init(&a->idle, NULL);
+	if (pthread_create(&a->thread, NULL, frame_thread, scene) != 0)
+	{
+		pthread_mutex_destroy(&a->lock);
+		pthread_cond_destroy(&a->wake);
+		pthread_cond_destroy(&a->idle);
+		render_async_stop(scene);
+		return ;
+	}
+	a->running = 1;
+}
+
+void	render_async_stop(t_scene *scene)
+{
+	t_async_render	*a;
+
+	a = &scene->async;
+	if (a->running)
+	{
+		render_async_wait(scene);
+		pthread_mutex_lock(&a->lock);
+		a->stop = 1;
+		pthread_cond_signal(&a->wake);
+		pthread_mutex_unlock(&a->lock);
+		pthread_join(a->thread, NULL);
+		pthread_mutex_destroy(&a->lock);
+		pthread_cond_destroy(&a->wake);
+		pthread_cond_destroy(&a->idle);
+		a->running = 0;
+	}
+	if (a->back.img_ptr)
+		mlx_destroy_image(scene->mlx_connection, a->back.img_ptr);
+	a->back.img_ptr = NULL;
+	if (a->preview.img_ptr)
+		mlx_destroy_image(scene->mlx_connection, a->preview.img_ptr);
+	a->preview.img_ptr = NULL;
+	free(a->pending);
+	a->pending = NULL;
+}
+
+//Snapshot the scene as the newest view, drawn by the renderer `kind`.
+//Returns at once; whatever frame is in flight gives up at its next tile.
+void	render_async_request(t_scene *scene, t_frame_kind kind)
+{
+	t_async_render	*a;
+
+	a = &scene->async;
+	pthread_mutex_lock(&a->lock);
+	*a->pending = *scene;
+	a->pending_kind = kind;
+	atomic_fetch_add(&a->requested, 1);
+	pthread_cond_signal(&a->wake);
+	pthread_mutex_unlock(&a->lock);
+	if (kind == FRAME_MENGER)
+		display_progress(scene, "Rendering Menger sponge...");
+	else
+		display_progress(scene, "Rendering scene...");
+}
+
+//Cancel the frame in flight without asking for a new one, and wait until
+//the frame thread has let go of the scene (before the BVH is replaced)
+void	render_async_wait(t_scene *scene)
+{
+	t_async_render	*a;
+
+	a = &scene->async;
+	if (!a->running)
+		return ;
+	pthread_mutex_lock(&a->lock);
+	a->taken = atomic_fetch_add(&a->requested, 1) + 1;
+	a->ready = 0;
+	a->preview_ready = 0;
+	while (a->busy)
+		pthread_cond_wait(&a->idle, &a->lock);
+	pthread_mutex_unlock(&a->lock);
+}
+
+//mlx loop hook: show the newest frame by swapping it with the displayed
+//image, the finished one from back or else the latest pass from preview.
+//Sleeps a little when there is nothing to show so the event thread
+//doesn't spin. Without the frame thread it draws the next pass of the
+//object scene instead.
+int	render_async_present(t_scene *scene)
+{
+	t_async_render	*a;
+	t_img			shown;
+	int				swap;
+
+	a = &scene->async;
+	if (!a->running)
+	{
+		render_scene_refine(scene);
+		return (0);
+	}
+	pthread_mutex_lock(&a->lock);
+	if (a->moved_step)
+		adaptive_record(&scene->adaptive, a->moved_step, a->moved_ms);
+	a->moved_step = 0;
+	swap = 0;
+	if (a->ready && !a->busy && a->ready == atomic_load(&a->requested))
+		swap = 2;
+	else if (a->preview_ready
+		&& a->preview_ready == atomic_load(&a->requested))
+		swap = 1;
+	if (swap)
+	{
+		shown = scene->img;
+		if (swap == 2)
+		{
+			scene->img = a->back;
+			a->back = shown;
+		}
+		else
+		{
+			scene->img = a->preview;
+			a->preview = shown;
+		}
+		a->ready = 0;
+		a->preview_ready = 0;
+	}
+	pthread_mutex_unlock(&a->lock);
+	if (!swap)
+	{
+		usleep(1000);
+		return (0);
+	}
+	draw_image_to_window(scene);
+	if (swap == 2)
+		display_status(scene);
+	return (0);
+}
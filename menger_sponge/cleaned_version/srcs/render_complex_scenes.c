@@ -12,6 +12,28 @@
 
 #include "platform.h"
 
+//render state of one pass, shared by all tiles
+typedef struct s_scene_pass
+{
+	t_scene		*scene;
+	t_camera	camera; //copy with the basis set up for this pass
+	int			step; //sample spacing, each sample fills step x step
+	int			reuse; //samples on the step * 2 grid are already drawn
+}	t_scene_pass;
+
+//Ray against one object of any type, t of the nearest valid hit
+int	intersect_object(t_object *object, t_ray ray, double *t)
+{
+	if (object->type == SPHERE)
+		return (ray_sphere_intersect(ray, *(t_sphere *)object->data, t));
+	if (object->type == CYLINDER)
+		return (ray_cylinder_intersect(ray, *(t_cylinder *)object->data, t));
+	if (object->type == PLANE)
+		return (ray_plane_intersect(ray, *(t_plane *)object->data, t));
+	return (0);
+}
+
+//Through the scene BVH once it is built, else along the object list
 int	find_closest_intersection(t_scene *scene, t_ray ray, double *t, t_object **hit_object)
 {
 	t_object	*current;
@@ -19,41 +41,19 @@ int	find_closest_intersection(t_scene *scene, t_ray ray, double *t, t_object **h
 	double		t_temp;
 	int			hit_something;
 
+	if (scene->bvh.built)
+		return (scene_bvh_closest(&scene->bvh, ray, t, hit_object));
 	current = scene->objects;
 	t_closest = INFINITY;
 	hit_something = 0;
 	*hit_object = NULL;
 	while (current)
 	{
-		if (current->type == SPHERE)
+		if (intersect_object(current, ray, &t_temp) && t_temp < t_closest)
 		{
-			t_sphere *sphere = (t_sphere *)(current->data);
-			if (ray_sphere_intersect(ray, *sphere, &t_temp) && t_temp < t_closest)
-			{
-				t_closest = t_temp;
-				hit_something = 1;
-				*hit_object = current;
-			}
-		}
-		else if (current->type == CYLINDER)
-		{
-			t_cylinder *cylinder = (t_cylinder *)(current->data);
-			if (ray_cylinder_intersect(ray, *cylinder, &t_temp) && t_temp < t_closest)
-			{
-				t_closest = t_temp;
-				hit_something = 1;
-				*hit_object = current;
-			}
-		}
-		else if (current->type == PLANE)
-		{
-			t_plane	*plane = (t_plane *)(current->data);
-			if (ray_plane_intersect(ray, *plane, &t_temp) && t_temp < t_closest)
-			{
-				t_closest = t_temp;
-				hit_something = 1;
-				*hit_object = current;
-			}
+			t_closest = t_temp;
+			hit_something = 1;
+			*hit_object = current;
 		}
 		current = current->next;
 	}
@@ -70,7 +70,7 @@ void	set_up_scene_cylinder(t_scene *scene)
 	double sphere_red_diameter = 3.0;
 	t_color red_color = create_color(255, 0, 0);
 
-	t_object *sphere_red = create_sphere(sphere_red_center, sphere_red_diameter, red_color);
+	t_object *sphere_red = create_sphere(&scene->arena, sphere_red_center, sphere_red_diameter, red_color);
 	add_object(scene, sphere_red);
 
 	//Cylinder - blue
@@ -80,7 +80,7 @@ void	set_up_scene_cylinder(t_scene *scene)
 	double cylinder_height = 3.0;
 	t_color	blue_color = create_color(0, 0, 255);
 
-	t_object *cylinder_blue = create_cylinder(cylinder_center, cylinder_axis, cylinder_diameter, cylinder_height);
+	t_object *cylinder_blue = create_cylinder(&scene->arena, cylinder_center, cylinder_axis, cylinder_diameter, cylinder_height);
 	cylinder_blue->material.color = blue_color;
 	add_object(scene, cylinder_blue);
 
@@ -93,7 +93,7 @@ void	set_up_scene_cylinder(t_scene *scene)
 
 	t_vec3	light_pos = vec3_create(10.0, 10.0, -10.0);
 	t_color	light_color = create_color(255, 255, 255);
-	t_light	*light = create_light(light_pos, 0.8, light_color);
+	t_light	*light = create_light(&scene->arena, light_pos, 0.8, light_color);
 	add_light(scene, light);
 
 	sphere_red->material.specular = 0.5;   // High specular reflection
@@ -111,7 +111,7 @@ void	set_up_scene_plane(t_scene *scene)
 	double sphere_diameter = 3.0;
 	t_color red_color = create_color(255, 0, 0);
 
-	t_object *sphere_red = create_sphere(sphere_center, sphere_diameter, red_color);
+	t_object *sphere_red = create_sphere(&scene->arena, sphere_center, sphere_diameter, red_color);
 	add_object(scene, sphere_red);
 
 	//Sphere - orange
@@ -119,7 +119,7 @@ void	set_up_scene_plane(t_scene *scene)
 	sphere_diameter = 2.0;
 	t_color orange_color = create_color(255, 165, 0);
 
-	t_object *sphere_orange = create_sphere(sphere_center, sphere_diameter, orange_color);
+	t_object *sphere_orange = create_sphere(&scene->arena, sphere_center, sphere_diameter, orange_color);
 	add_object(scene, sphere_orange);
 
 	//Sphere - purple
@@ -127,7 +127,7 @@ void	set_up_scene_plane(t_scene *scene)
 	sphere_diameter = 0.3;
 	t_color purple_color = create_color(93, 63, 211);
 
-	t_object *sphere_purple = create_sphere(sphere_center, sphere_diameter, purple_color);
+	t_object *sphere_purple = create_sphere(&scene->arena, sphere_center, sphere_diameter, purple_color);
 	add_object(scene, sphere_purple);
 
 	//Cylinder - blue
@@ -137,7 +137,7 @@ void	set_up_scene_plane(t_scene *scene)
 	double cylinder_height = 2.0;
 	t_color	blue_color = create_color(0, 0, 255);
 
-	t_object *cylinder_blue = create_cylinder(cylinder_center, cylinder_axis, cylinder_diameter, cylinder_height);
+	t_object *cylinder_blue = create_cylinder(&scene->arena, cylinder_center, cylinder_axis, cylinder_diameter, cylinder_height);
 	cylinder_blue->material.color = blue_color;
 	add_object(scene, cylinder_blue);
 
@@ -148,7 +148,7 @@ void	set_up_scene_plane(t_scene *scene)
 	cylinder_height = 3.0;
 	t_color	pink_color = create_color(255, 192, 203);
 
-	t_object *cylinder_pink = create_cylinder(cylinder_center, cylinder_axis, cylinder_diameter, cylinder_height);
+	t_object *cylinder_pink = create_cylinder(&scene->arena, cylinder_center, cylinder_axis, cylinder_diameter, cylinder_height);
 	cylinder_pink->material.color = pink_color;
 	add_object(scene, cylinder_pink);
 
@@ -157,7 +157,7 @@ void	set_up_scene_plane(t_scene *scene)
 	t_vec3	plane_normal = vec3_create(0.0, 1.0, 0.0);
 	t_color	green_color = create_color(0, 255, 0);
 
-	t_object *floor_plane = create_plane(plane_point, plane_normal, green_color);
+	t_object *floor_plane = create_plane(&scene->arena, plane_point, plane_normal, green_color);
 	add_object(scene, floor_plane);
 
 	scene->camera.position = vec3_create(0.0, 0.0, -3.0);
@@ -169,7 +169,7 @@ void	set_up_scene_plane(t_scene *scene)
 
 	t_vec3	light_pos = vec3_create(-10.0, 10.0, -10.0);
 	t_color	light_color = create_color(255, 255, 255);
-	t_light	*light = create_light(light_pos, 0.8, light_color);
+	t_light	*light = create_light(&scene->arena, light_pos, 0.8, light_color);
 	add_light(scene, light);
 
 	sphere_red->material.specular = 0.5;   // High specular reflection
@@ -190,7 +190,7 @@ void	set_up_scene_two_sphere(t_scene *scene)
 	double sphere_red_diameter = 4.0;
 	t_color red_color = create_color(255, 0, 0);
 
-	t_object *sphere_red = create_sphere(sphere_red_center, sphere_red_diameter, red_color);
+	t_object *sphere_red = create_sphere(&scene->arena, sphere_red_center, sphere_red_diameter, red_color);
 	add_object(scene, sphere_red);
 
 	//Second sphere - blue
@@ -198,7 +198,7 @@ void	set_up_scene_two_sphere(t_scene *scene)
 	double sphere_blue_diameter = 2.0;
 	t_color blue_color = create_color(0, 0, 255);
 
-	t_object *sphere_blue = create_sphere(sphere_blue_center, sphere_blue_diameter, blue_color);
+	t_object *sphere_blue = create_sphere(&scene->arena, sphere_blue_center, sphere_blue_diameter, blue_color);
 	add_object(scene, sphere_blue);
 
 	scene->camera.position = vec3_create(0.0, 0.0, -5.0);
@@ -210,7 +210,7 @@ void	set_up_scene_two_sphere(t_scene *scene)
 
 	t_vec3	light_pos = vec3_create(10.0, 10.0, -10.0);
 	t_color	light_color = create_color(255, 255, 255);
-	t_light	*light = create_light(light_pos, 0.8, light_color);
+	t_light	*light = create_light(&scene->arena, light_pos, 0.8, light_color);
 	add_light(scene, light);
 
 	sphere_red->material.specular = 0.5;   // High specular reflection
@@ -220,9 +220,68 @@ void	set_up_scene_two_sphere(t_scene *scene)
 	sphere_blue->material.shininess = 64.0; //More shiny
 }
 
-void	render_complex_scene(t_scene *scene)
+//next value of a small LCG in [0, 1), so every run builds the same field
+static double	field_random(unsigned int *state)
+{
+	*state = *state * 1664525u + 1013904223u;
+	return ((*state >> 8) / 16777216.0);
+}
+
+//set up a field of `count` small spheres on a floor plane, for the scene
+//BVH ("./minirt spheres" and bench spheres). The field grows with the
+//count so the density stays the same.
+void	set_up_scene_spheres(t_scene *scene, int count)
+{
+	unsigned int	seed;
+	double			side;
+	double			radius;
+	t_object		*head;
+	t_object		*tail;
+	t_object		*sphere;
+
+	seed = 42;
+	side = sqrt((double)count) * 0.8;
+	head = NULL;
+	tail = NULL;
+	for (int i = 0; i < count; i++)
+	{
+		radius = 0.15 + 0.15 * field_random(&seed);
+		t_vec3 center = vec3_create((field_random(&seed) - 0.5) * side,
+				-1.0 + radius, field_random(&seed) * side);
+		t_color color = create_color(55 + (int)(200 * field_random(&seed)),
+				55 + (int)(200 * field_random(&seed)),
+				55 + (int)(200 * field_random(&seed)));
+		sphere = create_sphere(&scene->arena, center, radius * 2.0, color);
+		if (!sphere)
+			break ;
+		sphere->material.specular = 0.5;
+		sphere->material.shininess = 32.0;
+		//linked here, add_object would walk the whole list every time
+		if (tail)
+			tail->next = sphere;
+		else
+			head = sphere;
+		tail = sphere;
+	}
+	add_object(scene, head);
+	add_object(scene, create_plane(&scene->arena, vec3_create(0.0, -1.0, 0.0),
+			vec3_create(0.0, 1.0, 0.0), create_color(120, 120, 120)));
+
+	scene->camera.position = vec3_create(0.0, 1.0, -6.0);
+	scene->camera.rotation = vec3_create(0.0, 0.0, 0.0);
+	scene->camera.fov = 60.0;
+
+	scene->ambient.ratio = 0.2;
+	scene->ambient.color = create_color(255, 255, 255);
+
+	t_light	*light = create_light(&scene->arena, vec3_create(10.0, 20.0, -10.0),
+			0.8, create_color(255, 255, 255));
+	add_light(scene, light);
+}
+
+//trace and shade one primary ray
+static int	trace_scene_pixel(t_scene *scene, t_ray ray)
 {
-	t_ray		ray;
 	int			color;
 	double		t;
 	t_vec3		hit_point;
@@ -231,98 +290,194 @@ void	render_complex_scene(t_scene *scene)
 	t_vec3		light_dir;
 	t_object	*hit_object;
 
-	if (!scene->objects)
-		set_up_scene_plane(scene);
+	//set brackground color
+	color = (217 << 16 | 185 << 8 | 155); //beige
 
-	double fov_scale = tan(scene->camera.fov * M_PI / 360.0);
-	for (int y = 0; y < scene->height; y++)
+	if (find_closest_intersection(scene, ray, &t, &hit_object))
 	{
-		for (int x = 0; x < scene->width; x++)
+		//calculate where the ray hit the sphere
+		hit_point = vec3_add(ray.origin, vec3_scale(ray.direction, t));
+
+		//calculate the normal at the hit point
+		if (hit_object->type == SPHERE)
+		{
+			t_sphere *sphere = (t_sphere *)(hit_object->data);
+			normal = sphere_normal_at_point(hit_point, *sphere);
+		}
+		else if (hit_object->type == CYLINDER)
+		{
+			t_cylinder *cylinder = (t_cylinder *)(hit_object->data);
+			normal = cylinder_normal_at_point(hit_point, *cylinder);
+		}
+		else if (hit_object->type == PLANE)
 		{
-			double u = (2.0 * x / (double)scene->width - 1.0) * fov_scale;
-			double v = (1.0 - 2.0 * y / (double)scene->height) * fov_scale;
-
-			u *= (double)scene->width / scene->height;
-
-			t_vec3 ray_dir_camera = vec3_normalize(vec3_create(u, v, 1.0));
-			ray.direction = rotate_point(ray_dir_camera, scene->camera.rotation);
-			ray.direction = vec3_normalize(ray.direction);
-
-			ray.origin = scene->camera.position;
-
-			//set brackground color
-			color = (217 << 16 | 185 << 8 | 155); //beige
-
-			if (find_closest_intersection(scene, ray, &t, &hit_object))
-			{
-				//calculate where the ray hit the sphere
-				hit_point = vec3_add(ray.origin, vec3_scale(ray.direction, t));
-
-				//calculate the normal at the hit point
-				if (hit_object->type == SPHERE)
-				{
-					t_sphere *sphere = (t_sphere *)(hit_object->data);
-					normal = sphere_normal_at_point(hit_point, *sphere);
-				}
-				else if (hit_object->type == CYLINDER)
-				{
-					t_cylinder *cylinder = (t_cylinder *)(hit_object->data);
-					normal = cylinder_normal_at_point(hit_point, *cylinder);
-				}
-				else if (hit_object->type == PLANE)
-				{
-					t_plane *plane = (t_plane *)(hit_object->data);
-					normal = plane->normal;
-					//double sided plane
-					if (vec3_dot(ray.direction, normal) > 0)
-						normal = vec3_negate(normal);
-				}
-
-				// Calculate vector from hit point to light source
-				t_vec3 to_light = vec3_subtract(scene->lights->position, hit_point);
-				double light_distance = vec3_length(to_light);
-
-				//Normalize to get light direction
-				light_dir = vec3_normalize(to_light);
-
-				// Calculate diffuse lighting - dot product of normal and light direction
-				double diffuse = fmax(0.0, vec3_dot(normal, light_dir));
-
-				//Adding specular reflection:
-				//1. Calculate the view direction (from hit point to camera)
-				//Used to determine if the viewers sees the specular highlight
-				t_vec3 view_dir = vec3_normalize(vec3_subtract(scene->camera.position, hit_point));
-
-				//2. Calculate reflection direction with reflection law calculation: R = L - 2(N.L)N
-				t_vec3 reflect_dir = vec3_subtract(vec3_scale(normal, 2.0 * vec3_dot(light_dir, normal)), light_dir);
-				reflect_dir = vec3_normalize(reflect_dir);
-
-				//3. Calculate specular component
-				double specular = pow(fmax(0.0, vec3_dot(view_dir, reflect_dir)), hit_object->material.shininess);
-				double specular_intensity = hit_object->material.specular * specular;
-
-				//Check if the hit point is in shadow
-				int in_shadow = is_in_shadow(scene, hit_point, light_dir, light_distance);
-
-				// Combine all lighting components
-				if (in_shadow)
-					light_intensity = scene->ambient.ratio;
-				else
-				{
-					light_intensity = scene->ambient.ratio +
+			t_plane *plane = (t_plane *)(hit_object->data);
+			normal = plane->normal;
+			//double sided plane
+			if (vec3_dot(ray.direction, normal) > 0)
+				normal = vec3_negate(normal);
+		}
+
+		// Calculate vector from hit point to light source
+		t_vec3 to_light = vec3_subtract(scene->lights->position, hit_point);
+		double light_distance = vec3_length(to_light);
+
+		//Normalize to get light direction
+		light_dir = vec3_normalize(to_light);
+
+		// Calculate diffuse lighting - dot product of normal and light direction
+		double diffuse = fmax(0.0, vec3_dot(normal, light_dir));
+
+		//Adding specular reflection:
+		//1. Calculate the view direction (from hit point to camera)
+		//Used to determine if the viewers sees the specular highlight
+		t_vec3 view_dir = vec3_normalize(vec3_subtract(scene->camera.position, hit_point));
+
+		//2. Calculate reflection direction with reflection law calculation: R = L - 2(N.L)N
+		t_vec3 reflect_dir = vec3_subtract(vec3_scale(normal, 2.0 * vec3_dot(light_dir, normal)), light_dir);
+		reflect_dir = vec3_normalize(reflect_dir);
+
+		//3. Calculate specular component
+		double specular = pow(fmax(0.0, vec3_dot(view_dir, reflect_dir)), hit_object->material.shininess);
+		double specular_intensity = hit_object->material.specular * specular;
+
+		//Check if the hit point is in shadow
+		int in_shadow = is_in_shadow(scene, hit_point, light_dir, light_distance);
+
+		// Combine all lighting components
+		if (in_shadow)
+			light_intensity = scene->ambient.ratio;
+		else
+		{
+			light_intensity = scene->ambient.ratio +
 				(scene->lights->intensity * diffuse) +
 				(scene->lights->intensity * specular_intensity);
-				}
+		}
+
+		//Get color from material and apply lighting
+		color = get_object_color(hit_object, light_intensity);
+	}
+	return (color);
+}
+
+//fill the step x step block of one sample, clipped to the image
+static void	fill_scene_block(t_scene *scene, int x, int y, int step, int color)
+{
+	for (int fy = y; fy < y + step && fy < scene->height; fy++)
+	{
+		for (int fx = x; fx < x + step && fx < scene->width; fx++)
+			pixel_put(fx, fy, &scene->img, color);
+	}
+}
 
-				//Get color from material and apply lighting
-				color = get_object_color(hit_object, light_intensity);
-			}
-			pixel_put(x, y, &scene->img, color);
+//tile callback for the scheduler, tiles are aligned to the sample grid.
+//Only reads the scene, so any number of tiles can run at once.
+static void	render_scene_tile(void *ctx, int x0, int y0, int x1, int y1)
+{
+	t_scene_pass	*pass;
+	t_ray			ray;
+	t_vec3			row;
+	int				color;
+
+	pass = (t_scene_pass *)ctx;
+	ray.origin = pass->camera.position;
+	for (int y = y0; y < y1; y += pass->step)
+	{
+		row = camera_row(&pass->camera, y);
+		for (int x = x0; x < x1; x += pass->step)
+		{
+			if (pass->reuse && x % (pass->step * 2) == 0
+				&& y % (pass->step * 2) == 0)
+				continue ;
+			ray.direction = camera_ray_dir(&pass->camera, row, x);
+			color = trace_scene_pixel(pass->scene, ray);
+			fill_scene_block(pass->scene, x, y, pass->step, color);
 		}
 	}
+}
 
-	//display the image
+//one coarse-to-fine pass over the object list into scene->img, same
+//contract as render_menger_pass: job fields left at 0 take the defaults
+void	render_scene_pass(t_scene *scene, t_tile_job *job, int step, int reuse)
+{
+	t_scene_pass	pass;
+	t_tile_job		defaults;
+
+	pass.scene = scene;
+	pass.camera = scene->camera;
+	camera_setup(&pass.camera, scene->width, scene->height);
+	pass.step = step;
+	pass.reuse = reuse;
+	tile_job_init(&defaults, render_scene_tile, &pass, step, step);
+	job->render = defaults.render;
+	job->ctx = &pass;
+	if (job->tile_w <= 0)
+		job->tile_w = defaults.tile_w;
+	if (job->tile_h <= 0)
+		job->tile_h = defaults.tile_h;
+	if (job->threads <= 0)
+		job->threads = defaults.threads;
+	run_tile_job(job);
+}
+
+//next pass of the event-thread fallback, one per loop hook call so new
+//input gets handled between them and restarts from the coarse pass
+void	render_scene_refine(t_scene *scene)
+{
+	t_tile_job	job;
+
+	if (!scene->refine)
+		return ;
+	job.tile_w = 0;
+	job.tile_h = 0;
+	job.threads = 0;
+	job.pool = &scene->pool;
+	job.cancel = NULL;
+	render_scene_pass(scene, &job, scene->refine,
+		scene->refine < PREVIEW_STEP);
+#ifdef DEBUG
+	print_tile_stats(&job, "scene");
+#endif
+	//display each pass as it completes
 	draw_image_to_window(scene);
+	scene->refine /= 2;
+	if (!scene->refine)
+		display_status(scene);
+}
+
+//coarse-to-fine: the first pass samples every PREVIEW_STEP pixels, each
+//next one halves the spacing and only traces the samples the one before
+//didn't have, so the last pass leaves every pixel traced exactly once.
+//The scene must be set up beforehand (start_raytracer does it). With the
+//frame thread up the passes run there; without it only the first pass is
+//drawn here, the loop hook draws the rest through render_scene_refine.
+void	render_complex_scene(t_scene *scene)
+{
+	t_tile_job	job;
+	int			step;
 
-	display_status(scene);
+	//with the frame thread up, just ask for the new view; the loop hook
+	//shows the passes as they come
+	if (scene->async.running)
+	{
+		render_async_request(scene, FRAME_SCENE);
+		return ;
+	}
+	//while the view moves, one pass sized to the frame budget
+	step = adaptive_step(scene);
+	if (step)
+	{
+		scene->refine = 0;
+		job.tile_w = 0;
+		job.tile_h = 0;
+		job.threads = 0;
+		job.pool = &scene->pool;
+		job.cancel = NULL;
+		render_scene_pass(scene, &job, step, 0);
+		adaptive_record(&scene->adaptive, step, adaptive_frame_ms(&job));
+		draw_image_to_window(scene);
+		return ;
+	}
+	scene->refine = PREVIEW_STEP;
+	render_scene_refine(scene);
 }
@@ -0,0 +1,631 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   scene_bvh.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include <string.h>
+
+//Build state: bounds and centroids of the bounded objects, reordered in
+//place together with bvh->objects as the nodes split them
+typedef struct s_scene_builder
+{
+	t_scene_bvh	*bvh;
+	t_aabb		*bounds;
+	t_vec3		*centroids;
+}	t_scene_builder;
+
+//Traversal stack entry: a node and the ray's entry distance into its box
+typedef struct s_scene_bvh_entry
+{
+	int		node;
+	float	t_near;
+}	t_scene_bvh_entry;
+
+//Ray for the float box tests
+typedef struct s_box_ray
+{
+	float	origin[3];
+	float	inv_dir[3];
+}	t_box_ray;
+
+typedef struct s_sah_bin
+{
+	t_aabb	bounds;
+	int		count;
+}	t_sah_bin;
+
+static t_aabb	aabb_empty(void)
+{
+	t_aabb	box;
+
+	box.min = vec3_create(INFINITY, INFINITY, INFINITY);
+	box.max = vec3_create(-INFINITY, -INFINITY, -INFINITY);
+	return (box);
+}
+
+static inline double	min_d(double a, double b)
+{
+	if (b < a)
+		return (b);
+	return (a);
+}
+
+static inline double	max_d(double a, double b)
+{
+	if (b > a)
+		return (b);
+	return (a);
+}
+
+//plain compares rather than fmin/fmax, the build calls this a lot
+static inline t_aabb	aabb_union(t_aabb a, t_aabb b)
+{
+	a.min.x = min_d(a.min.x, b.min.x);
+	a.min.y = min_d(a.min.y, b.min.y);
+	a.min.z = min_d(a.min.z, b.min.z);
+	a.max.x = max_d(a.max.x, b.max.x);
+	a.max.y = max_d(a.max.y, b.max.y);
+	a.max.z = max_d(a.max.z, b.max.z);
+	return (a);
+}
+
+static double	aabb_area(t_aabb box)
+{
+	t_vec3	d;
+
+	if (box.max.x < box.min.x)
+		return (0.0);
+	d = vec3_subtract(box.max, box.min);
+	return (2.0 * (d.x * d.y + d.y * d.z + d.z * d.x));
+}
+
+static inline double	axis_of(t_vec3 v, int axis)
+{
+	if (axis == 0)
+		return (v.x);
+	if (axis == 1)
+		return (v.y);
+	return (v.z);
+}
+
+//Box of a sphere or cylinder. The cylinder box is the one of its two cap
+//discs: along each axis a disc of radius r with normal n reaches
+//r * sqrt(1 - n_i^2) from its center.
+static int	object_bounds(t_object *object, t_aabb *box)
+{
+	t_sphere	*s;
+	t_cylinder	*c;
+	t_vec3		half;
+	t_vec3		e;
+
+	if (object->type == SPHERE)
+	{
+		s = (t_sphere *)object->data;
+		e = vec3_create(s->radius, s->radius, s->radius);
+		box->min = vec3_subtract(s->center, e);
+		box->max = vec3_add(s->center, e);
+		return (1);
+	}
+	if (object->type != CYLINDER)
+		return (0);
+	c = (t_cylinder *)object->data;
+	half = vec3_scale(c->axis, c->height / 2.0);
+	e = vec3_create(c->radius * sqrt(fmax(0.0, 1.0 - c->axis.x * c->axis.x)),
+			c->radius * sqrt(fmax(0.0, 1.0 - c->axis.y * c->axis.y)),
+			c->radius * sqrt(fmax(0.0, 1.0 - c->axis.z * c->axis.z)));
+	e = vec3_add(e, vec3_create(fabs(half.x), fabs(half.y), fabs(half.z)));
+	//the cap test accepts hits up to 1% past the radius
+	e = vec3_add(e, vec3_scale(vec3_create(1.0, 1.0, 1.0), c->radius * 0.01));
+	box->min = vec3_subtract(c->center, e);
+	box->max = vec3_add(c->center, e);
+	return (1);
+}
+
+//Best binned SAH split of the node's objects over their centroid box.
+//Returns the cost relative to testing them all (INFINITY when every
+//centroid is the same), and the axis and bin boundary in split.
+static double	find_split(t_scene_builder *b, t_scene_bvh_node *node,
+					double area, t_aabb centers, int split[2])
+{
+	t_sah_bin	bins[SCENE_BVH_BINS];
+	t_aabb		left[SCENE_BVH_BINS];
+	double		best;
+	double		lo, scale, cost;
+	t_aabb		box;
+	int			n, k, l_count;
+	int			first = node->first, count = node->count;
+
+	best = INFINITY;
+	area *= count;
+	for (int a = 0; a < 3; a++)
+	{
+		lo = axis_of(centers.min, a);
+		scale = axis_of(centers.max, a) - lo;
+		if (scale <= 0.0)
+			continue ;
+		scale = SCENE_BVH_BINS / scale;
+		for (k = 0; k < SCENE_BVH_BINS; k++)
+		{
+			bins[k].bounds = aabb_empty();
+			bins[k].count = 0;
+		}
+		for (int i = first; i < first + count; i++)
+		{
+			k = (int)((axis_of(b->centroids[i], a) - lo) * scale);
+			if (k >= SCENE_BVH_BINS)
+				k = SCENE_BVH_BINS - 1;
+			bins[k].bounds = aabb_union(bins[k].bounds, b->bounds[i]);
+			bins[k].count++;
+		}
+		box = aabb_empty();
+		for (k = 0; k < SCENE_BVH_BINS; k++)
+		{
+			box = aabb_union(box, bins[k].bounds);
+			left[k] = box;
+		}
+		box = aabb_empty();
+		n = 0;
+		for (k = SCENE_BVH_BINS - 1; k > 0; k--)
+		{
+			box = aabb_union(box, bins[k].bounds);
+			n += bins[k].count;
+			l_count = count - n;
+			if (!n || !l_count)
+				continue ;
+			cost = (aabb_area(left[k - 1]) * l_count + aabb_area(box) * n)
+				/ area;
+			if (cost < best)
+			{
+				best = cost;
+				split[0] = a;
+				split[1] = k;
+			}
+		}
+	}
+	return (best);
+}
+
+static void	swap_items(t_scene_builder *b, int i, int j)
+{
+	t_object	*object;
+	t_aabb		box;
+	t_vec3		center;
+
+	object = b->bvh->objects[i];
+	b->bvh->objects[i] = b->bvh->objects[j];
+	b->bvh->objects[j] = object;
+	box = b->bounds[i];
+	b->bounds[i] = b->bounds[j];
+	b->bounds[j] = box;
+	center = b->centroids[i];
+	b->centroids[i] = b->centroids[j];
+	b->centroids[j] = center;
+}
+
+//Move the items whose centroid falls below bin `split` to the front.
+//Returns the number of items that went left.
+static int	partition(t_scene_builder *b, t_scene_bvh_node *node,
+				t_aabb centers, int split[2])
+{
+	double	lo, scale;
+	int		mid, k;
+	int		first = node->first, count = node->count, axis = split[0];
+
+	lo = axis_of(centers.min, axis);
+	scale = SCENE_BVH_BINS / (axis_of(centers.max, axis) - lo);
+	mid = first;
+	for (int i = first; i < first + count; i++)
+	{
+		k = (int)((axis_of(b->centroids[i], axis) - lo) * scale);
+		if (k >= SCENE_BVH_BINS)
+			k = SCENE_BVH_BINS - 1;
+		if (k < split[1])
+			swap_items(b, i, mid++);
+	}
+	return (mid - first);
+}
+
+//Node boxes are kept in float, half the size. Padded and rounded outward
+//so a float slab test never misses a box the ray touches.
+static void	store_bounds(t_scene_bvh_node *node, t_aabb box)
+{
+	node->min[0] = nextafterf((float)(box.min.x - SCENE_BVH_PAD), -INFINITY);
+	node->min[1] = nextafterf((float)(box.min.y - SCENE_BVH_PAD), -INFINITY);
+	node->min[2] = nextafterf((float)(box.min.z - SCENE_BVH_PAD), -INFINITY);
+	node->max[0] = nextafterf((float)(box.max.x + SCENE_BVH_PAD), INFINITY);
+	node->max[1] = nextafterf((float)(box.max.y + SCENE_BVH_PAD), INFINITY);
+	node->max[2] = nextafterf((float)(box.max.z + SCENE_BVH_PAD), INFINITY);
+}
+
+//Spheres to the front of the leaf so the kernel takes them 4 at a time
+static int	make_leaf(t_scene_builder *b, t_scene_bvh_node *node, int index)
+{
+	int	end;
+
+	node->spheres = 0;
+	end = node->first + node->count;
+	for (int i = node->first; i < end; i++)
+		if (b->bvh->objects[i]->type == SPHERE)
+			swap_items(b, i, node->first + node->spheres++);
+	return (index);
+}
+
+//Depth-first like the flat Menger BVH: the left child of a node is the
+//next node, the right child is stored as an index. A node stays a leaf
+//when it is small and the SAH says splitting doesn't pay; objects with
+//the same centroid are split in halves. Past SCENE_BVH_MAX_DEPTH the
+//rest goes in one leaf so the traversal stack can't overflow.
+static int	build_node(t_scene_builder *b, int first, int count, int depth)
+{
+	t_scene_bvh_node	*node;
+	t_aabb				box, centers;
+	double				cost;
+	int					index, left_count;
+	int					split[2];
+
+	index = b->bvh->node_count++;
+	node = &b->bvh->nodes[index];
+	box = aabb_empty();
+	centers = aabb_empty();
+	for (int i = first; i < first + count; i++)
+	{
+		box = aabb_union(box, b->bounds[i]);
+		centers = aabb_union(centers,
+				(t_aabb){b->centroids[i], b->centroids[i]});
+	}
+	store_bounds(node, box);
+	node->first = first;
+	node->count = count;
+	node->right = 0;
+	node->spheres = 0;
+	if (count == 1 || depth >= SCENE_BVH_MAX_DEPTH)
+		return (make_leaf(b, node, index));
+	cost = find_split(b, node, aabb_area(box), centers, split);
+	if (count <= SCENE_BVH_MAX_LEAF
+		&& SCENE_BVH_TRAVERSAL_COST + cost * count >= count)
+		return (make_leaf(b, node, index));
+	left_count = count / 2;
+	if (cost < INFINITY)
+		left_count = partition(b, node, centers, split);
+	node->count = 0;
+	build_node(b, first, left_count, depth + 1);
+	b->bvh->nodes[index].right = build_node(b, first + left_count,
+			count - left_count, depth + 1);
+	return (index);
+}
+
+//Split the object list into bounded objects and the rest, planes first,
+//fill the build arrays and sort the bounded ones into a tree
+static int	fill_and_build(t_scene_bvh *bvh, t_object *objects,
+				t_scene_builder *b)
+{
+	t_aabb	box;
+	int		n;
+
+	n = 0;
+	bvh->plane_count = 0;
+	for (t_object *cur = objects; cur; cur = cur->next)
+	{
+		if (object_bounds(cur, &box))
+		{
+			bvh->objects[n] = cur;
+			b->bounds[n] = box;
+			b->centroids[n++] = vec3_scale(vec3_add(box.min, box.max), 0.5);
+		}
+		else if (cur->type == PLANE)
+			bvh->planes[bvh->plane_count++] = cur;
+	}
+	for (t_object *cur = objects; cur; cur = cur->next)
+		if (cur->type != PLANE && !object_bounds(cur, &box))
+			bvh->planes[bvh->plane_count++] = cur;
+	bvh->object_count = n;
+	bvh->node_count = 0;
+	if (n > 0)
+		build_node(b, 0, n, 0);
+	return (scene_soa_build(bvh));
+}
+
+//Build the BVH over the scene objects. Call again whenever the object
+//list changes. Returns 0 when out of memory; find_closest_intersection
+//then keeps walking the list.
+int	scene_bvh_build(t_scene_bvh *bvh, t_object *objects)
+{
+	t_scene_builder	b;
+	int				total;
+
+	scene_bvh_free(bvh);
+	total = 0;
+	for (t_object *cur = objects; cur; cur = cur->next)
+		total++;
+	bvh->objects = malloc(sizeof(t_object *) * (total + 1));
+	bvh->planes = malloc(sizeof(t_object *) * (total + 1));
+	bvh->nodes = malloc(sizeof(t_scene_bvh_node) * (2 * total + 1));
+	b.bvh = bvh;
+	b.bounds = malloc(sizeof(t_aabb) * (total + 1));
+	b.centroids = malloc(sizeof(t_vec3) * (total + 1));
+	if (bvh->objects && bvh->planes && bvh->nodes && b.bounds && b.centroids)
+		bvh->built = fill_and_build(bvh, objects, &b);
+	free(b.bounds);
+	free(b.centroids);
+	if (!bvh->built)
+		scene_bvh_free(bvh);
+	return (bvh->built);
+}
+
+void	scene_bvh_free(t_scene_bvh *bvh)
+{
+	scene_soa_free(&bvh->soa);
+	free(bvh->nodes);
+	free(bvh->objects);
+	free(bvh->planes);
+	memset(bvh, 0, sizeof(t_scene_bvh));
+}
+
+//Slab test against a node box in float, entry distance in t_near. Misses
+//boxes that start beyond `limit`.
+static int	hit_box(const t_scene_bvh_node *node, const t_box_ray *ray,
+				float limit, float *t_near)
+{
+	float	t0, t1, t_min, t_max;
+
+	t0 = (node->min[0] - ray->origin[0]) * ray->inv_dir[0];
+	t1 = (node->max[0] - ray->origin[0]) * ray->inv_dir[0];
+	t_min = fminf(t0, t1);
+	t_max = fmaxf(t0, t1);
+	for (int k = 1; k < 3; k++)
+	{
+		t0 = (node->min[k] - ray->origin[k]) * ray->inv_dir[k];
+		t1 = (node->max[k] - ray->origin[k]) * ray->inv_dir[k];
+		t_min = fmaxf(t_min, fminf(t0, t1));
+		t_max = fminf(t_max, fmaxf(t0, t1));
+	}
+	*t_near = t_min;
+	return (t_max >= fmaxf(t_min, 0.0f) && t_min < limit);
+}
+
+static void	box_ray_prepare(t_box_ray *box_ray, t_ray ray)
+{
+	box_ray->origin[0] = ray.origin.x;
+	box_ray->origin[1] = ray.origin.y;
+	box_ray->origin[2] = ray.origin.z;
+	box_ray->inv_dir[0] = 1.0f / (float)ray.direction.x;
+	box_ray->inv_dir[1] = 1.0f / (float)ray.direction.y;
+	box_ray->inv_dir[2] = 1.0f / (float)ray.direction.z;
+}
+
+//Distance limit for the float box test, never below the double one
+static float	float_limit(double t)
+{
+	float	f;
+
+	f = (float)t;
+	if (f < t)
+		f = nextafterf(f, INFINITY);
+	return (f);
+}
+
+//Kernels for the precision mode of the tree
+static void	spheres4(const t_scene_bvh *bvh, int i, t_ray ray, double t[4])
+{
+	if (bvh->single)
+		sphere_hits4f(&bvh->soa, i, ray, t);
+	else
+		sphere_hits4(&bvh->soa, i, ray, t);
+}
+
+static void	planes4(const t_scene_bvh *bvh, int i, t_ray ray, double t[4])
+{
+	if (bvh->single)
+		plane_hits4f(&bvh->soa, i, ray, t);
+	else
+		plane_hits4(&bvh->soa, i, ray, t);
+}
+
+//Keep the nearest of `n` kernel lanes if it beats the hit so far, in
+//lane order like the scalar loop
+static void	take_lanes(const double t[4], int n, t_object **objects,
+				t_hit_record *hit)
+{
+	for (int k = 0; k < n; k++)
+	{
+		if (t[k] < hit->t)
+		{
+			hit->t = t[k];
+			hit->object = objects[k];
+		}
+	}
+}
+
+static int	lanes_before(const double t[4], int n, double max_t)
+{
+	for (int k = 0; k < n; k++)
+		if (t[k] < max_t)
+			return (1);
+	return (0);
+}
+
+static int	lane_count(int i, int end)
+{
+	if (end - i < SCENE_SOA_LANES)
+		return (end - i);
+	return (SCENE_SOA_LANES);
+}
+
+//Closest hit among the leaf objects of one node: the spheres through the
+//SIMD kernel, the rest one by one
+static void	hit_leaf(const t_scene_bvh *bvh, const t_scene_bvh_node *node,
+				t_ray ray, t_hit_record *hit)
+{
+	double	t[SCENE_SOA_LANES];
+	int		end;
+
+	end = node->first + node->spheres;
+	for (int i = node->first; i < end; i += SCENE_SOA_LANES)
+	{
+		spheres4(bvh, i, ray, t);
+		take_lanes(t, lane_count(i, end), bvh->objects + i, hit);
+	}
+	for (int i = end; i < node->first + node->count; i++)
+	{
+		if (intersect_object(bvh->objects[i], ray, t) && t[0] < hit->t)
+		{
+			hit->t = t[0];
+			hit->object = bvh->objects[i];
+		}
+	}
+}
+
+//Closest hit among the planes (and anything else without bounds)
+static void	hit_planes(const t_scene_bvh *bvh, t_ray ray, t_hit_record *hit)
+{
+	double	t[SCENE_SOA_LANES];
+
+	for (int i = 0; i < bvh->soa.plane_count; i += SCENE_SOA_LANES)
+	{
+		planes4(bvh, i, ray, t);
+		take_lanes(t, lane_count(i, bvh->soa.plane_count),
+			bvh->planes + i, hit);
+	}
+	for (int i = bvh->soa.plane_count; i < bvh->plane_count; i++)
+	{
+		if (intersect_object(bvh->planes[i], ray, t) && t[0] < hit->t)
+		{
+			hit->t = t[0];
+			hit->object = bvh->planes[i];
+		}
+	}
+}
+
+//Whether any plane or leaf object blocks the ray before max_t
+static int	planes_occlude(const t_scene_bvh *bvh, t_ray ray, double max_t)
+{
+	double	t[SCENE_SOA_LANES];
+
+	for (int i = 0; i < bvh->soa.plane_count; i += SCENE_SOA_LANES)
+	{
+		planes4(bvh, i, ray, t);
+		if (lanes_before(t, lane_count(i, bvh->soa.plane_count), max_t))
+			return (1);
+	}
+	for (int i = bvh->soa.plane_count; i < bvh->plane_count; i++)
+		if (intersect_object(bvh->planes[i], ray, t) && t[0] < max_t)
+			return (1);
+	return (0);
+}
+
+static int	leaf_occludes(const t_scene_bvh *bvh,
+				const t_scene_bvh_node *node, t_ray ray, double max_t)
+{
+	double	t[SCENE_SOA_LANES];
+	int		end;
+
+	end = node->first + node->spheres;
+	for (int i = node->first; i < end; i += SCENE_SOA_LANES)
+	{
+		spheres4(bvh, i, ray, t);
+		if (lanes_before(t, lane_count(i, end), max_t))
+			return (1);
+	}
+	for (int i = end; i < node->first + node->count; i++)
+		if (intersect_object(bvh->objects[i], ray, t) && t[0] < max_t)
+			return (1);
+	return (0);
+}
+
+//Closest hit, as the object list walk finds it: planes first, then the
+//tree nearest child first, skipping boxes that start past the best hit
+int	scene_bvh_closest(const t_scene_bvh *bvh, t_ray ray, double *t,
+		t_object **hit_object)
+{
+	t_scene_bvh_entry	stack[SCENE_BVH_MAX_DEPTH + 1];
+	t_hit_record		hit;
+	t_box_ray			box_ray;
+	float				t_l, t_r;
+	int					sp, l, r;
+
+	hit.t = INFINITY;
+	hit.object = NULL;
+	hit_planes(bvh, ray, &hit);
+	box_ray_prepare(&box_ray, ray);
+	sp = 0;
+	if (bvh->node_count && hit_box(&bvh->nodes[0], &box_ray,
+			float_limit(hit.t), &t_l))
+		stack[sp++] = (t_scene_bvh_entry){0, t_l};
+	while (sp > 0)
+	{
+		sp--;
+		if (stack[sp].t_near >= float_limit(hit.t))
+			continue ;
+		l = stack[sp].node;
+		if (bvh->nodes[l].count)
+		{
+			hit_leaf(bvh, &bvh->nodes[l], ray, &hit);
+			continue ;
+		}
+		r = bvh->nodes[l].right;
+		l++;
+		if (!hit_box(&bvh->nodes[l], &box_ray, float_limit(hit.t), &t_l))
+			t_l = INFINITY;
+		if (!hit_box(&bvh->nodes[r], &box_ray, float_limit(hit.t), &t_r))
+			t_r = INFINITY;
+		if (t_l > t_r)
+		{
+			if (t_l < INFINITY)
+				stack[sp++] = (t_scene_bvh_entry){l, t_l};
+			stack[sp++] = (t_scene_bvh_entry){r, t_r};
+		}
+		else
+		{
+			if (t_r < INFINITY)
+				stack[sp++] = (t_scene_bvh_entry){r, t_r};
+			if (t_l < INFINITY)
+				stack[sp++] = (t_scene_bvh_entry){l, t_l};
+		}
+	}
+	*hit_object = hit.object;
+	if (hit.object)
+		*t = hit.t;
+	return (hit.object != NULL);
+}
+
+//Any hit closer than max_t, for shadow rays: no ordering, stops at the
+//first blocker
+int	scene_bvh_occluded(const t_scene_bvh *bvh, t_ray ray, double max_t)
+{
+	int						stack[SCENE_BVH_MAX_DEPTH + 1];
+	const t_scene_bvh_node	*node;
+	t_box_ray				box_ray;
+	float					t;
+	int						sp;
+
+	if (planes_occlude(bvh, ray, max_t))
+		return (1);
+	if (!bvh->node_count)
+		return (0);
+	box_ray_prepare(&box_ray, ray);
+	stack[0] = 0;
+	sp = 1;
+	while (sp > 0)
+	{
+		node = &bvh->nodes[stack[--sp]];
+		if (!hit_box(node, &box_ray, float_limit(max_t), &t))
+			continue ;
+		if (!node->count)
+		{
+			stack[sp++] = node->right;
+			stack[sp++] = (int)(node - bvh->nodes) + 1;
+			continue ;
+		}
+		if (leaf_occludes(bvh, node, ray, max_t))
+			return (1);
+	}
+	return (0);
+}
@@ -0,0 +1,388 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   scene_simd.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: abillote <abillote@student.42berlin.de>    +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/18 10:00:00 by abillote          #+#    #+#             */
+/*   Updated: 2026/10/18 10:00:00 by abillote         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "platform.h"
+#include <string.h>
+
+//Structure of arrays for the SIMD kernels: spheres by object index (the
+//cylinder slots are unused), planes by index in the plane list. Padded by
+//SCENE_SOA_LANES so a kernel may always load a full register.
+int	scene_soa_build(t_scene_bvh *bvh)
+{
+	t_scene_soa	*soa;
+	size_t		spheres, planes;
+	t_sphere	*s;
+	t_plane		*p;
+
+	soa = &bvh->soa;
+	spheres = bvh->object_count + SCENE_SOA_LANES;
+	planes = bvh->plane_count + SCENE_SOA_LANES;
+	soa->data = calloc(4 * spheres + 6 * planes, sizeof(double));
+	if (!soa->data)
+		return (0);
+	for (int k = 0; k < 4; k++)
+		soa->sphere[k] = soa->data + k * spheres;
+	for (int k = 0; k < 6; k++)
+		soa->plane[k] = soa->data + 4 * spheres + k * planes;
+	for (int i = 0; i < bvh->object_count; i++)
+	{
+		if (bvh->objects[i]->type != SPHERE)
+			continue ;
+		s = (t_sphere *)bvh->objects[i]->data;
+		soa->sphere[0][i] = s->center.x;
+		soa->sphere[1][i] = s->center.y;
+		soa->sphere[2][i] = s->center.z;
+		soa->sphere[3][i] = s->radius;
+	}
+	soa->data_f = calloc(4 * spheres + 6 * planes, sizeof(float));
+	if (!soa->data_f)
+		return (0);
+	for (int k = 0; k < 4; k++)
+		soa->sphere_f[k] = soa->data_f + k * spheres;
+	for (int k = 0; k < 6; k++)
+		soa->plane_f[k] = soa->data_f + 4 * spheres + k * planes;
+	soa->plane_count = 0;
+	while (soa->plane_count < bvh->plane_count
+		&& bvh->planes[soa->plane_count]->type == PLANE)
+	{
+		p = (t_plane *)bvh->planes[soa->plane_count]->data;
+		soa->plane[0][soa->plane_count] = p->point.x;
+		soa->plane[1][soa->plane_count] = p->point.y;
+		soa->plane[2][soa->plane_count] = p->point.z;
+		soa->plane[3][soa->plane_count] = p->normal.x;
+		soa->plane[4][soa->plane_count] = p->normal.y;
+		soa->plane[5][soa->plane_count++] = p->normal.z;
+	}
+	for (size_t i = 0; i < 4 * spheres + 6 * planes; i++)
+		soa->data_f[i] = (float)soa->data[i];
+	return (1);
+}
+
+void	scene_soa_free(t_scene_soa *soa)
+{
+	free(soa->data);
+	free(soa->data_f);
+	memset(soa, 0, sizeof(t_scene_soa));
+}
+
+//Doubles per register: AVX2 takes the four lanes in one go, SSE2 (the
+//x86_64 baseline) in two halves
+#if HAS_AVX2
+typedef __m256d	t_dvec;
+# define DVEC_LANES 4
+# define D_SET1 _mm256_set1_pd
+# define D_LOAD _mm256_loadu_pd
+# define D_STORE _mm256_storeu_pd
+# define D_ADD _mm256_add_pd
+# define D_SUB _mm256_sub_pd
+# define D_MUL _mm256_mul_pd
+# define D_DIV _mm256_div_pd
+# define D_SQRT _mm256_sqrt_pd
+# define D_MAX _mm256_max_pd
+# define D_AND _mm256_and_pd
+# define D_OR _mm256_or_pd
+# define D_ANDNOT _mm256_andnot_pd
+# define D_XOR _mm256_xor_pd
+# define D_GT(a, b) _mm256_cmp_pd(a, b, _CMP_GT_OQ)
+# define D_LT(a, b) _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+# define D_NGE(a, b) _mm256_cmp_pd(a, b, _CMP_NGE_UQ)
+#elif HAS_SSE
+typedef __m128d	t_dvec;
+# define DVEC_LANES 2
+# define D_SET1 _mm_set1_pd
+# define D_LOAD _mm_loadu_pd
+# define D_STORE _mm_storeu_pd
+# define D_ADD _mm_add_pd
+# define D_SUB _mm_sub_pd
+# define D_MUL _mm_mul_pd
+# define D_DIV _mm_div_pd
+# define D_SQRT _mm_sqrt_pd
+# define D_MAX _mm_max_pd
+# define D_AND _mm_and_pd
+# define D_OR _mm_or_pd
+# define D_ANDNOT _mm_andnot_pd
+# define D_XOR _mm_xor_pd
+# define D_GT _mm_cmpgt_pd
+# define D_LT _mm_cmplt_pd
+# define D_NGE _mm_cmpnge_pd
+#endif
+
+#if HAS_AVX2 || HAS_SSE
+
+//b where mask is set, else a
+static inline t_dvec	d_select(t_dvec a, t_dvec b, t_dvec mask)
+{
+	return (D_OR(D_AND(mask, b), D_ANDNOT(mask, a)));
+}
+
+//Dot product of per-lane vectors with one broadcast vector, summed in
+//the same order as vec3_dot
+static inline t_dvec	d_dot(t_dvec x, t_dvec y, t_dvec z, t_vec3 v)
+{
+	return (D_ADD(D_ADD(D_MUL(x, D_SET1(v.x)), D_MUL(y, D_SET1(v.y))),
+			D_MUL(z, D_SET1(v.z))));
+}
+
+static void	sphere_lanes(const t_scene_soa *soa, int i, t_ray ray, double *t)
+{
+	const t_dvec	eps = D_SET1(0.001);
+	const t_dvec	inf = D_SET1(INFINITY);
+	t_dvec			ocx, ocy, ocz, b, c, disc, sq, t1, t2, r;
+	double			a;
+
+	a = vec3_dot(ray.direction, ray.direction);
+	ocx = D_SUB(D_SET1(ray.origin.x), D_LOAD(soa->sphere[0] + i));
+	ocy = D_SUB(D_SET1(ray.origin.y), D_LOAD(soa->sphere[1] + i));
+	ocz = D_SUB(D_SET1(ray.origin.z), D_LOAD(soa->sphere[2] + i));
+	r = D_LOAD(soa->sphere[3] + i);
+	b = D_MUL(D_SET1(2.0), d_dot(ocx, ocy, ocz, ray.direction));
+	c = D_ADD(D_ADD(D_MUL(ocx, ocx), D_MUL(ocy, ocy)), D_MUL(ocz, ocz));
+	c = D_SUB(c, D_MUL(r, r));
+	disc = D_SUB(D_MUL(b, b), D_MUL(D_SET1(4 * a), c));
+	sq = D_SQRT(D_MAX(disc, D_SET1(0.0)));
+	b = D_XOR(b, D_SET1(-0.0));
+	t1 = D_DIV(D_SUB(b, sq), D_SET1(2.0 * a));
+	t2 = D_DIV(D_ADD(b, sq), D_SET1(2.0 * a));
+	//t1 if t1 > 0.001 && (t1 < t2 || t2 < 0.001), else t2 if t2 > 0.001
+	t2 = d_select(inf, t2, D_GT(t2, eps));
+	t1 = d_select(t2, t1, D_AND(D_GT(t1, eps),
+				D_OR(D_LT(t1, t2), D_LT(t2, eps))));
+	D_STORE(t, d_select(t1, inf, D_LT(disc, D_SET1(0.0))));
+}
+
+static void	plane_lanes(const t_scene_soa *soa, int i, t_ray ray, double *t)
+{
+	const t_dvec	sign = D_SET1(-0.0);
+	const t_dvec	inf = D_SET1(INFINITY);
+	t_dvec			nx, ny, nz, denom, dist, tp, parallel;
+
+	nx = D_LOAD(soa->plane[3] + i);
+	ny = D_LOAD(soa->plane[4] + i);
+	nz = D_LOAD(soa->plane[5] + i);
+	denom = d_dot(nx, ny, nz, ray.direction);
+	dist = D_ADD(D_ADD(
+				D_MUL(D_SUB(D_LOAD(soa->plane[0] + i), D_SET1(ray.origin.x)), nx),
+				D_MUL(D_SUB(D_LOAD(soa->plane[1] + i), D_SET1(ray.origin.y)), ny)),
+			D_MUL(D_SUB(D_LOAD(soa->plane[2] + i), D_SET1(ray.origin.z)), nz));
+	parallel = D_LT(D_ANDNOT(sign, denom), D_SET1(0.0001));
+	tp = D_DIV(dist, denom);
+	tp = d_select(D_SUB(tp, D_SET1(0.0001)), inf,
+			D_NGE(tp, D_SET1(0.00001)));
+	tp = d_select(tp, d_select(inf, D_SET1(0.001),
+				D_LT(D_ANDNOT(sign, dist), D_SET1(0.001))), parallel);
+	D_STORE(t, tp);
+}
+
+//Spheres i .. i + 3 against one ray, the arithmetic of
+//ray_sphere_intersect lane by lane, without FMA: bit for bit the scalar
+//result unless the compiler fused FMAs into that (SIMD=avx2). Lanes
+//without a valid hit get INFINITY.
+void	sphere_hits4(const t_scene_soa *soa, int i, t_ray ray, double t[4])
+{
+	for (int k = 0; k < SCENE_SOA_LANES; k += DVEC_LANES)
+		sphere_lanes(soa, i + k, ray, t + k);
+}
+
+//Planes i .. i + 3 against one ray, like ray_plane_intersect: nearly
+//parallel planes only count when the origin lies on them
+void	plane_hits4(const t_scene_soa *soa, int i, t_ray ray, double t[4])
+{
+	for (int k = 0; k < SCENE_SOA_LANES; k += DVEC_LANES)
+		plane_lanes(soa, i + k, ray, t + k);
+}
+
+#else
+
+//Without x86 SIMD the same lanes one after the other
+void	sphere_hits4(const t_scene_soa *soa, int i, t_ray ray, double t[4])
+{
+	t_sphere	s;
+
+	for (int k = 0; k < SCENE_SOA_LANES; k++)
+	{
+		s.center = vec3_create(soa->sphere[0][i + k], soa->sphere[1][i + k],
+				soa->sphere[2][i + k]);
+		s.radius = soa->sphere[3][i + k];
+		if (!ray_sphere_intersect(ray, s, &t[k]))
+			t[k] = INFINITY;
+	}
+}
+
+void	plane_hits4(const t_scene_soa *soa, int i, t_ray ray, double t[4])
+{
+	t_plane	p;
+
+	for (int k = 0; k < SCENE_SOA_LANES; k++)
+	{
+		p.point = vec3_create(soa->plane[0][i + k], soa->plane[1][i + k],
+				soa->plane[2][i + k]);
+		p.normal = vec3_create(soa->plane[3][i + k], soa->plane[4][i + k],
+				soa->plane[5][i + k]);
+		if (!ray_plane_intersect(ray, p, &t[k]))
+			t[k] = INFINITY;
+	}
+}
+
+#endif
+
+//Single precision: four lanes in one SSE register on every x86_64 build.
+//The sphere test solves for the roots without the b * b - 4ac
+//cancellation (the discriminant comes from the distance between the
+//center and the ray line, the near root from c / q), which keeps the
+//float error a few ulps of t. Hits closer than SCENE_FLOAT_EPS are
+//dropped instead of the double path's 0.001.
+#if HAS_SSE
+
+static inline __m128	f_select(__m128 a, __m128 b, __m128 mask)
+{
+	return (_mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a)));
+}
+
+static inline __m128	f_dot(__m128 x, __m128 y, __m128 z, const float v[3])
+{
+	return (_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(v[0])),
+				_mm_mul_ps(y, _mm_set1_ps(v[1]))),
+			_mm_mul_ps(z, _mm_set1_ps(v[2]))));
+}
+
+static void	store_lanes(double t[4], __m128 v)
+{
+	_mm_storeu_pd(t, _mm_cvtps_pd(v));
+	_mm_storeu_pd(t + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+}
+
+void	sphere_hits4f(const t_scene_soa *soa, int i, t_ray ray, double t[4])
+{
+	const float	d[3] = {ray.direction.x, ray.direction.y, ray.direction.z};
+	const float	a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+	__m128		fx, fy, fz, r2, bh, c, disc, q, t1, t2;
+
+	fx = _mm_sub_ps(_mm_set1_ps(ray.origin.x),
+			_mm_loadu_ps(soa->sphere_f[0] + i));
+	fy = _mm_sub_ps(_mm_set1_ps(ray.origin.y),
+			_mm_loadu_ps(soa->sphere_f[1] + i));
+	fz = _mm_sub_ps(_mm_set1_ps(ray.origin.z),
+			_mm_loadu_ps(soa->sphere_f[2] + i));
+	r2 = _mm_loadu_ps(soa->sphere_f[3] + i);
+	r2 = _mm_mul_ps(r2, r2);
+	bh = f_dot(fx, fy, fz, d);
+	c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(fx, fx),
+					_mm_mul_ps(fy, fy)), _mm_mul_ps(fz, fz)), r2);
+	q = _mm_div_ps(bh, _mm_set1_ps(a));
+	fx = _mm_sub_ps(fx, _mm_mul_ps(q, _mm_set1_ps(d[0])));
+	fy = _mm_sub_ps(fy, _mm_mul_ps(q, _mm_set1_ps(d[1])));
+	fz = _mm_sub_ps(fz, _mm_mul_ps(q, _mm_set1_ps(d[2])));
+	disc = _mm_sub_ps(r2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(fx, fx),
+					_mm_mul_ps(fy, fy)), _mm_mul_ps(fz, fz)));
+	q = _mm_sqrt_ps(_mm_mul_ps(_mm_set1_ps(a),
+				_mm_max_ps(disc, _mm_setzero_ps())));
+	q = _mm_xor_ps(_mm_or_ps(q, _mm_and_ps(bh, _mm_set1_ps(-0.0f))),
+			_mm_set1_ps(-0.0f));
+	q = _mm_sub_ps(q, bh);
+	t1 = _mm_div_ps(c, q);
+	t2 = _mm_div_ps(q, _mm_set1_ps(a));
+	bh = _mm_min_ps(t1, t2);
+	t2 = _mm_max_ps(t1, t2);
+	t2 = f_select(_mm_set1_ps(INFINITY), t2,
+			_mm_cmpgt_ps(t2, _mm_set1_ps(SCENE_FLOAT_EPS)));
+	t1 = f_select(t2, bh, _mm_cmpgt_ps(bh, _mm_set1_ps(SCENE_FLOAT_EPS)));
+	store_lanes(t, f_select(t1, _mm_set1_ps(INFINITY),
+			_mm_cmplt_ps(disc, _mm_setzero_ps())));
+}
+
+void	plane_hits4f(const t_scene_soa *soa, int i, t_ray ray, double t[4])
+{
+	const float		d[3] = {ray.direction.x, ray.direction.y, ray.direction.z};
+	const __m128	sign = _mm_set1_ps(-0.0f);
+	const __m128	inf = _mm_set1_ps(INFINITY);
+	__m128			nx, ny, nz, denom, dist, tp, parallel;
+
+	nx = _mm_loadu_ps(soa->plane_f[3] + i);
+	ny = _mm_loadu_ps(soa->plane_f[4] + i);
+	nz = _mm_loadu_ps(soa->plane_f[5] + i);
+	denom = f_dot(nx, ny, nz, d);
+	dist = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(soa->plane_f[0] + i),
+						_mm_set1_ps(ray.origin.x)), nx),
+				_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(soa->plane_f[1] + i),
+						_mm_set1_ps(ray.origin.y)), ny)),
+			_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(soa->plane_f[2] + i),
+					_mm_set1_ps(ray.origin.z)), nz));
+	parallel = _mm_cmplt_ps(_mm_andnot_ps(sign, denom), _mm_set1_ps(0.0001f));
+	tp = _mm_div_ps(dist, denom);
+	tp = f_select(_mm_sub_ps(tp, _mm_set1_ps(0.0001f)), inf,
+			_mm_cmpnge_ps(tp, _mm_set1_ps(SCENE_FLOAT_EPS)));
+	tp = f_select(tp, f_select(inf, _mm_set1_ps(SCENE_FLOAT_EPS),
+				_mm_cmplt_ps(_mm_andnot_ps(sign, dist),
+					_mm_set1_ps(SCENE_FLOAT_EPS))), parallel);
+	store_lanes(t, tp);
+}
+
+#else
+
+void	sphere_hits4f(const t_scene_soa *soa, int i, t_ray ray, double t[4])
+{
+	const float	d[3] = {ray.direction.x, ray.direction.y, ray.direction.z};
+	const float	a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+	float		f[3], l[3], r2, bh, c, disc, q, t1, t2;
+
+	for (int k = 0; k < SCENE_SOA_LANES; k++)
+	{
+		t[k] = INFINITY;
+		f[0] = (float)ray.origin.x - soa->sphere_f[0][i + k];
+		f[1] = (float)ray.origin.y - soa->sphere_f[1][i + k];
+		f[2] = (float)ray.origin.z - soa->sphere_f[2][i + k];
+		r2 = soa->sphere_f[3][i + k] * soa->sphere_f[3][i + k];
+		bh = f[0] * d[0] + f[1] * d[1] + f[2] * d[2];
+		c = f[0] * f[0] + f[1] * f[1] + f[2] * f[2] - r2;
+		for (int j = 0; j < 3; j++)
+			l[j] = f[j] - bh / a * d[j];
+		disc = r2 - (l[0] * l[0] + l[1] * l[1] + l[2] * l[2]);
+		if (disc < 0)
+			continue ;
+		q = -(bh + copysignf(sqrtf(a * disc), bh));
+		t1 = fminf(c / q, q / a);
+		t2 = fmaxf(c / q, q / a);
+		if (t1 > SCENE_FLOAT_EPS)
+			t[k] = t1;
+		else if (t2 > SCENE_FLOAT_EPS)
+			t[k] = t2;
+	}
+}
+
+void	plane_hits4f(const t_scene_soa *soa, int i, t_ray ray, double t[4])
+{
+	const float	d[3] = {ray.direction.x, ray.direction.y, ray.direction.z};
+	float		n[3], dist, denom, tp;
+
+	for (int k = 0; k < SCENE_SOA_LANES; k++)
+	{
+		for (int j = 0; j < 3; j++)
+			n[j] = soa->plane_f[3 + j][i + k];
+		denom = n[0] * d[0] + n[1] * d[1] + n[2] * d[2];
+		dist = (soa->plane_f[0][i + k] - (float)ray.origin.x) * n[0]
+			+ (soa->plane_f[1][i + k] - (float)ray.origin.y) * n[1]
+			+ (soa->plane_f[2][i + k] - (float)ray.origin.z) * n[2];
+		t[k] = INFINITY;
+		if (fabsf(denom) < 0.0001f)
+		{
+			if (fabsf(dist) < SCENE_FLOAT_EPS)
+				t[k] = SCENE_FLOAT_EPS;
+			continue ;
+		}
+		tp = dist / denom;
+		if (tp >= SCENE_FLOAT_EPS)
+			t[k] = tp - 0.0001f;
+	}
+}
+
+#endif
@@ -22,6 +22,9 @@ int	is_in_shadow(t_scene *scene, t_vec3 hit_point, t_vec3 light_dir, double ligh
 	shadow_ray.origin = vec3_add(hit_point, vec3_scale(light_dir, 0.001)); //offset to avoid self intersection
 	shadow_ray.direction = light_dir;
 
+	//any blocker will do, no need for the closest one
+	if (scene->bvh.built)
+		return (scene_bvh_occluded(&scene->bvh, shadow_ray, light_distance));
 	if (find_closest_intersection(scene, shadow_ray, &t, &hit_object) && t < light_distance)
 		return (1);
 	return (0);